@@ -26,10 +26,23 @@
 #include "implementation/hash_implementation.h"
 #include "implementation/vault_implementation.h"
 #include "implementation/persistent_implementation.h"
+#include "implementation/statistics_implementation.h"
 
 #include <com/com.h>
 #include <plugins/Types.h>
 
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 namespace WPEFramework {
 namespace Implementation {
     static constexpr uint16_t TimeOut = 3000;
@@ -83,6 +96,338 @@ namespace Implementation {
         Core::ProxyListType<Core::IUnknown> _interfaces;
     };
 
+    // Keeps the proxy of a wrapper alive for the duration of a single call. The wrapper lock is only held while
+    // taking the reference, so calls through the same wrapper can be in flight concurrently, while Unlink() may
+    // drop the wrapper's own reference in the meantime.
+    template <typename INTERFACE>
+    class AccessorType {
+    public:
+        AccessorType() = delete;
+        AccessorType(const AccessorType<INTERFACE>&) = delete;
+        AccessorType<INTERFACE>& operator=(const AccessorType<INTERFACE>&) = delete;
+
+        AccessorType(Core::CriticalSection& lock, INTERFACE* const& accessor)
+            : _accessor(nullptr)
+        {
+            lock.Lock();
+            _accessor = accessor;
+            if (_accessor != nullptr) {
+                _accessor->AddRef();
+            }
+            lock.Unlock();
+        }
+        ~AccessorType()
+        {
+            if (_accessor != nullptr) {
+                _accessor->Release();
+            }
+        }
+
+    public:
+        bool IsValid() const
+        {
+            return (_accessor != nullptr);
+        }
+        INTERFACE* Interface() const
+        {
+            return (_accessor);
+        }
+        INTERFACE* operator->() const
+        {
+            ASSERT(_accessor != nullptr);
+            return (_accessor);
+        }
+
+    private:
+        INTERFACE* _accessor;
+    };
+
+    // The shared memory regions of the payload channel live in a private directory of the client user (only accessible
+    // by its owner), $XDG_RUNTIME_DIR/svalbard or otherwise /tmp/svalbard-<uid>, and are named svalbard.<pid>.<sequence>.
+    // The implementation side refuses to map anything else, so a client can not make it open arbitrary files on its
+    // behalf. It only checks what it actually opened (no symbolic links followed), so the region can not be swapped
+    // for something else in between.
+    class ExchangeLocation {
+    private:
+        static constexpr const TCHAR* Base = "svalbard";
+        static constexpr const TCHAR* Prefix = "svalbard.";
+
+    public:
+        ExchangeLocation() = delete;
+        ExchangeLocation(const ExchangeLocation&) = delete;
+        ExchangeLocation& operator=(const ExchangeLocation&) = delete;
+
+    public:
+        // Client side, returns an empty name if the private directory can not be set up.
+        static string Create(const uint32_t sequence)
+        {
+            string result;
+
+            const string directory = Directory();
+
+            if ((::mkdir(directory.c_str(), S_IRWXU) == 0) || (errno == EEXIST)) {
+                struct stat info;
+
+                if ((::lstat(directory.c_str(), &info) == 0) && (IsPrivate(info, S_IFDIR) == true) && (info.st_uid == ::geteuid())) {
+                    result = Core::Format(_T("%s/%s%u.%u"), directory.c_str(), Prefix, Core::ProcessInfo().Id(), sequence);
+                } else {
+                    TRACE_L1("Shared memory directory %s is not private", directory.c_str());
+                }
+            }
+
+            return (result);
+        }
+
+        // Implementation side, returns an open descriptor (or -1) of the region if it is a plain file with a name as
+        // created above, owned by the owner of the directory and not accessible by anyone else.
+        static int Open(const string& name)
+        {
+            int result = -1;
+
+            const size_t slash = name.find_last_of(_T('/'));
+
+            if ((slash != string::npos) && (slash != 0)) {
+                const string directory = name.substr(0, slash);
+                const string file = name.substr(slash + 1);
+
+                uint32_t uid = 0;
+
+                if ((file.compare(0, ::strlen(Prefix), Prefix) == 0) && (IsSequence(file.substr(::strlen(Prefix))) == true)
+                    && (IsDirectory(directory, uid) == true)) {
+
+                    int folder = ::open(directory.c_str(), (O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC));
+
+                    if (folder != -1) {
+                        struct stat info;
+
+                        if ((::fstat(folder, &info) == 0) && (IsPrivate(info, S_IFDIR) == true)
+                            && ((uid == static_cast<uint32_t>(~0)) || (info.st_uid == uid))) {
+
+                            const uid_t owner = info.st_uid;
+                            int region = ::openat(folder, file.c_str(), (O_RDWR | O_NOFOLLOW | O_CLOEXEC));
+
+                            if (region != -1) {
+                                if ((::fstat(region, &info) == 0) && (IsPrivate(info, S_IFREG) == true)
+                                    && (info.st_nlink == 1) && (info.st_uid == owner)) {
+                                    result = region;
+                                } else {
+                                    ::close(region);
+                                }
+                            }
+                        }
+
+                        ::close(folder);
+                    }
+                }
+            }
+
+            return (result);
+        }
+
+    private:
+        static string Directory()
+        {
+            string result;
+
+            const TCHAR* runtime = ::getenv(_T("XDG_RUNTIME_DIR"));
+
+            if ((runtime != nullptr) && (runtime[0] == _T('/'))) {
+                result = string(runtime) + _T('/') + Base;
+            } else {
+                result = Core::Format(_T("/tmp/%s-%u"), Base, static_cast<uint32_t>(::geteuid()));
+            }
+
+            return (result);
+        }
+
+        // Either <runtime directory>/svalbard or /tmp/svalbard-<uid>, in the latter case uid is set to that of the name
+        static bool IsDirectory(const string& directory, uint32_t& uid)
+        {
+            bool result = false;
+
+            const string temporary = Core::Format(_T("/tmp/%s-"), Base);
+            const string runtime = string(_T("/")) + Base;
+
+            if (directory.compare(0, temporary.length(), temporary) == 0) {
+                const string value = directory.substr(temporary.length());
+
+                if ((value.empty() == false) && (value.length() <= 10) && (value.find_first_not_of(_T("0123456789")) == string::npos)) {
+                    const unsigned long number = std::stoul(value);
+
+                    if (number < static_cast<uint32_t>(~0)) {
+                        uid = static_cast<uint32_t>(number);
+                        result = true;
+                    }
+                }
+            } else if ((directory.length() > runtime.length()) && (directory.compare(directory.length() - runtime.length(), runtime.length(), runtime) == 0)) {
+                uid = static_cast<uint32_t>(~0);
+                result = true;
+            }
+
+            return (result);
+        }
+
+        static bool IsPrivate(const struct stat& info, const mode_t type)
+        {
+            return (((info.st_mode & S_IFMT) == type) && ((info.st_mode & (S_IRWXG | S_IRWXO)) == 0));
+        }
+
+        // <pid>.<sequence>
+        static bool IsSequence(const string& value)
+        {
+            uint8_t fields = 0;
+            bool digit = false;
+            bool result = true;
+
+            for (const TCHAR element : value) {
+                if ((element >= '0') && (element <= '9')) {
+                    digit = true;
+                } else if ((element == '.') && (digit == true) && (fields == 0)) {
+                    digit = false;
+                    fields++;
+                } else {
+                    result = false;
+                    break;
+                }
+            }
+
+            return ((result == true) && (digit == true) && (fields == 1));
+        }
+    };
+
+    // Client side of the shared memory payload channel (see IHashExchange/ICipherExchange). The region is created on
+    // the first payload that is worth it and grown (to the next power of two) whenever a larger payload comes along.
+    // The backing file is removed as soon as both sides have it mapped, so nothing lingers if either side dies.
+    // There is a single region per wrapper, so Reserve() and the use of the region are to be done with the lock taken.
+    template <typename EXCHANGE>
+    class ExchangeChannel {
+    private:
+        static constexpr uint32_t Threshold = 4 * 1024; // Smaller payloads are cheaper to pass inline
+        static constexpr uint32_t MaxSize = 16 * 1024 * 1024;
+        static constexpr uint32_t Mode = Core::File::USER_READ | Core::File::USER_WRITE | Core::File::SHAREABLE;
+
+    public:
+        ExchangeChannel(const ExchangeChannel&) = delete;
+        ExchangeChannel& operator=(const ExchangeChannel&) = delete;
+
+        ExchangeChannel()
+            : _adminLock()
+            , _exchange(nullptr)
+            , _region(nullptr)
+            , _probed(false)
+        {
+        }
+        ~ExchangeChannel()
+        {
+            Close();
+        }
+
+    public:
+        void Lock() const
+        {
+            _adminLock.Lock();
+        }
+        void Unlock() const
+        {
+            _adminLock.Unlock();
+        }
+
+        EXCHANGE* operator->() const
+        {
+            ASSERT(_exchange != nullptr);
+            return (_exchange);
+        }
+
+        // Returns the start of the region if the payload is to go through it, nullptr if it should be passed inline.
+        uint8_t* Reserve(Core::IUnknown* iface, const uint64_t size)
+        {
+            uint8_t* result = nullptr;
+
+            ASSERT(iface != nullptr);
+
+            if ((size >= Threshold) && (size <= MaxSize)) {
+                if (_probed == false) {
+                    _probed = true;
+                    _exchange = reinterpret_cast<EXCHANGE*>(iface->QueryInterface(EXCHANGE::ID));
+                }
+
+                if ((_exchange != nullptr) && ((_region == nullptr) || (_region->Size() < size))) {
+                    Map(static_cast<uint32_t>(size));
+                }
+
+                if (_region != nullptr) {
+                    result = _region->Buffer();
+                }
+            }
+
+            return (result);
+        }
+
+        void Close()
+        {
+            Core::SafeSyncType<Core::CriticalSection> lock(_adminLock);
+
+            if (_exchange != nullptr) {
+                _exchange->Detach();
+                _exchange->Release();
+                _exchange = nullptr;
+            }
+
+            if (_region != nullptr) {
+                delete _region;
+                _region = nullptr;
+            }
+        }
+
+    private:
+        void Map(const uint32_t size)
+        {
+            static std::atomic<uint32_t> sequence(0);
+
+            uint32_t capacity = Threshold;
+            while (capacity < size) {
+                capacity <<= 1;
+            }
+
+            if (_region != nullptr) {
+                delete _region;
+                _region = nullptr;
+            }
+
+            const string name = ExchangeLocation::Create(sequence++);
+            Core::DataElementFile* region = nullptr;
+
+            if (name.empty() == false) {
+                region = new Core::DataElementFile(name, (Mode | Core::File::CREATE), capacity);
+                ASSERT(region != nullptr);
+
+                if ((region->IsValid() == false) || (_exchange->Attach(name, capacity) != Core::ERROR_NONE)) {
+                    delete region;
+                    region = nullptr;
+                }
+
+                Core::File(name).Destroy();
+            }
+
+            if (region != nullptr) {
+                _region = region;
+            } else {
+                TRACE_L1("Failed to set up a shared memory region of %u bytes, passing payloads inline", capacity);
+
+                // Do not retry for every payload that follows.
+                _exchange->Detach();
+                _exchange->Release();
+                _exchange = nullptr;
+            }
+        }
+
+    private:
+        mutable Core::CriticalSection _adminLock;
+        EXCHANGE* _exchange;
+        Core::DataElementFile* _region;
+        bool _probed;
+    };
+
     class RPCDiffieHellmanImpl : public Cryptography::IDiffieHellman {
     public:
         RPCDiffieHellmanImpl(Cryptography::IDiffieHellman* iface)
@@ -103,14 +448,20 @@ namespace Implementation {
             const uint16_t modulusSize, const uint8_t modulus[],
             uint32_t& privKeyId, uint32_t& pubKeyId) override
         {
-            Core::SafeSyncType<Core::CriticalSection> lock(_adminLock);
-            return (_accessor != nullptr) ? _accessor->Generate(generator, modulusSize, modulus, privKeyId, pubKeyId) : 0;
+            AccessorType<Cryptography::IDiffieHellman> accessor(_adminLock, _accessor);
+            return (accessor.IsValid() == true) ? accessor->Generate(generator, modulusSize, modulus, privKeyId, pubKeyId) : 0;
+        }
+
+        uint32_t GenerateEC(const Cryptography::curvetype curve, uint32_t& privKeyId, uint32_t& pubKeyId) override
+        {
+            AccessorType<Cryptography::IDiffieHellman> accessor(_adminLock, _accessor);
+            return (accessor.IsValid() == true) ? accessor->GenerateEC(curve, privKeyId, pubKeyId) : 0;
         }
 
         uint32_t Derive(const uint32_t privateKey, const uint32_t peerPublicKeyId, uint32_t& secretId) override
         {
-            Core::SafeSyncType<Core::CriticalSection> lock(_adminLock);
-            return (_accessor != nullptr) ? _accessor->Derive(privateKey, peerPublicKeyId, secretId) : 0;
+            AccessorType<Cryptography::IDiffieHellman> accessor(_adminLock, _accessor);
+            return (accessor.IsValid() == true) ? accessor->Derive(privateKey, peerPublicKeyId, secretId) : 0;
         }
 
         void Unlink()
@@ -132,13 +483,528 @@ namespace Implementation {
         RPCCipherImpl(Cryptography::ICipher* iface)
             : _accessor(iface)
         {
-            if (_accessor != nullptr) {
-                _accessor->AddRef();
-            }
+            if (_accessor != nullptr) {
+                _accessor->AddRef();
+            }
+        }
+        ~RPCCipherImpl() override = default;
+
+        BEGIN_INTERFACE_MAP(RPCCipherImpl)
+        INTERFACE_ENTRY(Cryptography::ICipher)
+        END_INTERFACE_MAP
+
+    public:
+        int32_t Encrypt(const uint8_t ivLength, const uint8_t iv[],
+            const uint32_t inputLength, const uint8_t input[],
+            const uint32_t maxOutputLength, uint8_t output[]) const override
+        {
+            AccessorType<Cryptography::ICipher> accessor(_adminLock, _accessor);
+            return (accessor.IsValid() == true) ? Process(accessor.Interface(), true, ivLength, iv, inputLength, input, maxOutputLength, output) : 0;
+        }
+
+        int32_t Decrypt(const uint8_t ivLength, const uint8_t iv[],
+            const uint32_t inputLength, const uint8_t input[],
+            const uint32_t maxOutputLength, uint8_t output[]) const override
+        {
+            AccessorType<Cryptography::ICipher> accessor(_adminLock, _accessor);
+            return (accessor.IsValid() == true) ? Process(accessor.Interface(), false, ivLength, iv, inputLength, input, maxOutputLength, output) : 0;
+        }
+
+        uint32_t OutputSize(const bool encrypt, const uint32_t inputLength) const override
+        {
+            AccessorType<Cryptography::ICipher> accessor(_adminLock, _accessor);
+            return (accessor.IsValid() == true) ? accessor->OutputSize(encrypt, inputLength) : 0;
+        }
+
+        int32_t EncryptInPlace(const uint8_t ivLength, const uint8_t iv[],
+            const uint32_t length, const uint32_t maxLength, uint8_t data[]) const override
+        {
+            AccessorType<Cryptography::ICipher> accessor(_adminLock, _accessor);
+            return (accessor.IsValid() == true) ? InPlace(accessor.Interface(), true, ivLength, iv, length, maxLength, data) : 0;
+        }
+
+        int32_t DecryptInPlace(const uint8_t ivLength, const uint8_t iv[],
+            const uint32_t length, const uint32_t maxLength, uint8_t data[]) const override
+        {
+            AccessorType<Cryptography::ICipher> accessor(_adminLock, _accessor);
+            return (accessor.IsValid() == true) ? InPlace(accessor.Interface(), false, ivLength, iv, length, maxLength, data) : 0;
+        }
+
+        int32_t Batch(const bool encrypt, const uint8_t ivLength, const uint16_t count,
+            const uint32_t inputLength, const uint8_t input[],
+            const uint32_t maxOutputLength, uint8_t output[]) const override
+        {
+            AccessorType<Cryptography::ICipher> accessor(_adminLock, _accessor);
+            return (accessor.IsValid() == true) ? accessor->Batch(encrypt, ivLength, count, inputLength, input, maxOutputLength, output) : 0;
+        }
+
+        uint32_t Initialize(const bool encrypt, const uint8_t ivLength, const uint8_t iv[]) override
+        {
+            AccessorType<Cryptography::ICipher> accessor(_adminLock, _accessor);
+            return (accessor.IsValid() == true) ? accessor->Initialize(encrypt, ivLength, iv) : Core::ERROR_UNAVAILABLE;
+        }
+
+        int32_t Update(const uint32_t inputLength, const uint8_t input[],
+            const uint32_t maxOutputLength, uint8_t output[]) override
+        {
+            AccessorType<Cryptography::ICipher> accessor(_adminLock, _accessor);
+            return (accessor.IsValid() == true) ? accessor->Update(inputLength, input, maxOutputLength, output) : 0;
+        }
+
+        int32_t Finalize(const uint32_t maxOutputLength, uint8_t output[]) override
+        {
+            AccessorType<Cryptography::ICipher> accessor(_adminLock, _accessor);
+            return (accessor.IsValid() == true) ? accessor->Finalize(maxOutputLength, output) : 0;
+        }
+
+        int32_t EncryptAuthenticated(const uint8_t ivLength, const uint8_t iv[],
+            const uint32_t aadLength, const uint8_t aad[],
+            const uint32_t inputLength, const uint8_t input[],
+            const uint32_t maxOutputLength, uint8_t output[]) const override
+        {
+            AccessorType<Cryptography::ICipher> accessor(_adminLock, _accessor);
+            return (accessor.IsValid() == true) ? accessor->EncryptAuthenticated(ivLength, iv, aadLength, aad, inputLength, input, maxOutputLength, output) : 0;
+        }
+
+        int32_t DecryptAuthenticated(const uint8_t ivLength, const uint8_t iv[],
+            const uint32_t aadLength, const uint8_t aad[],
+            const uint32_t inputLength, const uint8_t input[],
+            const uint32_t maxOutputLength, uint8_t output[]) const override
+        {
+            AccessorType<Cryptography::ICipher> accessor(_adminLock, _accessor);
+            return (accessor.IsValid() == true) ? accessor->DecryptAuthenticated(ivLength, iv, aadLength, aad, inputLength, input, maxOutputLength, output) : 0;
+        }
+
+        void Unlink()
+        {
+            Core::SafeSyncType<Core::CriticalSection> lock(_adminLock);
+            _exchange.Close();
+            if (_accessor != nullptr) {
+                _accessor->Release();
+                _accessor = nullptr;
+            }
+        }
+
+    private:
+        int32_t Process(Cryptography::ICipher* accessor, const bool encrypt, const uint8_t ivLength, const uint8_t iv[],
+            const uint32_t inputLength, const uint8_t input[],
+            const uint32_t maxOutputLength, uint8_t output[]) const
+        {
+            int32_t result = 0;
+
+            _exchange.Lock();
+
+            uint8_t* region = _exchange.Reserve(accessor, (static_cast<uint64_t>(inputLength) + maxOutputLength));
+
+            if (region == nullptr) {
+                _exchange.Unlock();
+
+                result = (encrypt == true ? accessor->Encrypt(ivLength, iv, inputLength, input, maxOutputLength, output)
+                                          : accessor->Decrypt(ivLength, iv, inputLength, input, maxOutputLength, output));
+            } else {
+                // Input goes first, the output area follows it.
+                ::memcpy(region, input, inputLength);
+
+                result = (encrypt == true ? _exchange->Encrypt(ivLength, iv, 0, inputLength, inputLength, maxOutputLength)
+                                          : _exchange->Decrypt(ivLength, iv, 0, inputLength, inputLength, maxOutputLength));
+
+                if (result > 0) {
+                    ::memcpy(output, (region + inputLength), result);
+                }
+
+                _exchange.Unlock();
+            }
+
+            return (result);
+        }
+
+        // Same as above, but the input and output area in the shared memory region coincide
+        int32_t InPlace(Cryptography::ICipher* accessor, const bool encrypt, const uint8_t ivLength, const uint8_t iv[],
+            const uint32_t length, const uint32_t maxLength, uint8_t data[]) const
+        {
+            int32_t result = 0;
+
+            _exchange.Lock();
+
+            // The buffer holds the input, so it can't be smaller than that
+            uint8_t* region = (length <= maxLength ? _exchange.Reserve(accessor, maxLength) : nullptr);
+
+            if (region == nullptr) {
+                _exchange.Unlock();
+
+                result = (encrypt == true ? accessor->EncryptInPlace(ivLength, iv, length, maxLength, data)
+                                          : accessor->DecryptInPlace(ivLength, iv, length, maxLength, data));
+            } else {
+                ::memcpy(region, data, length);
+
+                result = (encrypt == true ? _exchange->Encrypt(ivLength, iv, 0, length, 0, maxLength)
+                                          : _exchange->Decrypt(ivLength, iv, 0, length, 0, maxLength));
+
+                if (result > 0) {
+                    ::memcpy(data, region, result);
+                }
+
+                _exchange.Unlock();
+            }
+
+            return (result);
+        }
+
+    private:
+        mutable Core::CriticalSection _adminLock;
+        Cryptography::ICipher* _accessor;
+        mutable ExchangeChannel<Cryptography::ICipherExchange> _exchange;
+    };
+
+    class RPCHashImpl : public Cryptography::IHash {
+    public:
+        RPCHashImpl(Cryptography::IHash* hash)
+            : _accessor(hash)
+        {
+            if (_accessor != nullptr) {
+                _accessor->AddRef();
+            }
+        }
+        ~RPCHashImpl() override = default;
+
+        BEGIN_INTERFACE_MAP(RPCHashImpl)
+        INTERFACE_ENTRY(Cryptography::IHash)
+        END_INTERFACE_MAP
+
+    public:
+        /* Ingest data into the hash calculator (multiple calls possible) */
+        uint32_t Ingest(const uint32_t length, const uint8_t data[] /* @length:length */) override
+        {
+            AccessorType<Cryptography::IHash> accessor(_adminLock, _accessor);
+
+            uint32_t result = 0;
+
+            if (accessor.IsValid() == true) {
+                _exchange.Lock();
+
+                uint8_t* region = _exchange.Reserve(accessor.Interface(), length);
+
+                if (region == nullptr) {
+                    _exchange.Unlock();
+                    result = accessor->Ingest(length, data);
+                } else {
+                    ::memcpy(region, data, length);
+                    result = _exchange->Ingest(0, length);
+                    _exchange.Unlock();
+                }
+            }
+
+            return (result);
+        }
+
+        /* Calculate the hash from all ingested data */
+        uint8_t Calculate(const uint8_t maxLength, uint8_t data[] /* @out @maxlength:maxLength */) override
+        {
+            AccessorType<Cryptography::IHash> accessor(_adminLock, _accessor);
+            return (accessor.IsValid() == true ? accessor->Calculate(maxLength, data) : 0);
+        }
+
+        /* Calculate the hashes of a batch of independent messages */
+        uint16_t Batch(const uint16_t count, const uint32_t inputLength, const uint8_t input[] /* @length:inputLength */,
+            const uint32_t maxOutputLength, uint8_t output[] /* @out @maxlength:maxOutputLength */) override
+        {
+            AccessorType<Cryptography::IHash> accessor(_adminLock, _accessor);
+            return (accessor.IsValid() == true ? accessor->Batch(count, inputLength, input, maxOutputLength, output) : 0);
+        }
+
+        uint32_t Reset() override
+        {
+            AccessorType<Cryptography::IHash> accessor(_adminLock, _accessor);
+            return (accessor.IsValid() == true ? accessor->Reset() : Core::ERROR_UNAVAILABLE);
+        }
+
+        /* Only the outcome of the comparison travels back, not the digest */
+        bool Verify(const uint8_t length, const uint8_t expected[] /* @length:length */) override
+        {
+            AccessorType<Cryptography::IHash> accessor(_adminLock, _accessor);
+            return (accessor.IsValid() == true ? accessor->Verify(length, expected) : false);
+        }
+
+        void Unlink()
+        {
+            Core::SafeSyncType<Core::CriticalSection> lock(_adminLock);
+            _exchange.Close();
+            if (_accessor != nullptr) {
+                _accessor->Release();
+                _accessor = nullptr;
+            }
+        }
+
+    private:
+        Core::CriticalSection _adminLock;
+        Cryptography::IHash* _accessor;
+        ExchangeChannel<Cryptography::IHashExchange> _exchange;
+    };
+
+    // Idle wrappers of the ciphers and calculators retrieved through a vault. A wrapper is only ever held by one
+    // caller, it comes back here once that caller is done with it, so asking for the same (mode, key) again is
+    // served locally without sharing the state of a calculation or stream between callers.
+    class WrapperPool {
+    public:
+        enum kind : uint8_t {
+            AES_CIPHER = 1,
+            HMAC_CALCULATOR = 2
+        };
+
+    private:
+        static constexpr uint16_t MaxCached = 64;
+
+        struct Entry {
+            Core::ProxyType<Core::IUnknown> Object;
+            bool Dirty;
+        };
+
+        // Leases out on a key, and the eviction count of the key at the time they were handed out
+        struct Ledger {
+            uint32_t Out;
+            uint32_t Epoch;
+        };
+
+        using Wrappers = std::list<Entry>;
+
+    public:
+        WrapperPool(const WrapperPool&) = delete;
+        WrapperPool& operator=(const WrapperPool&) = delete;
+
+        WrapperPool()
+            : _adminLock()
+            , _idle()
+            , _leased()
+            , _count(0)
+            , _closed(false)
+        {
+        }
+        ~WrapperPool() = default;
+
+    public:
+        static uint64_t Key(const kind type, const uint8_t mode, const uint32_t keyId)
+        {
+            return ((static_cast<uint64_t>(type) << 40) | (static_cast<uint64_t>(mode) << 32) | keyId);
+        }
+
+        // Hands out an idle wrapper if there is one, and in any case the epoch the lease is to be given back with.
+        // Every Take must be matched by a Give, also if no lease came of it.
+        Core::ProxyType<Core::IUnknown> Take(const uint64_t key, uint32_t& epoch, bool& dirty)
+        {
+            Core::ProxyType<Core::IUnknown> result;
+
+            Core::SafeSyncType<Core::CriticalSection> lock(_adminLock);
+
+            Ledger& ledger(_leased[static_cast<uint32_t>(key)]);
+            ledger.Out++;
+            epoch = ledger.Epoch;
+
+            auto it = _idle.find(key);
+
+            if (it != _idle.end()) {
+                result = it->second.front().Object;
+                dirty = it->second.front().Dirty;
+                it->second.pop_front();
+
+                if (it->second.empty() == true) {
+                    _idle.erase(it);
+                }
+
+                _count--;
+            }
+
+            return (result);
+        }
+
+        // Takes a wrapper back, unless its key was evicted while it was out. A dirty one is only reset once leased
+        // again, so a calculator that is not asked for anymore costs no RPC. An invalid object only ends the lease.
+        void Give(const uint64_t key, const uint32_t epoch, const Core::ProxyType<Core::IUnknown>& object, const bool dirty)
+        {
+            // Dropped outside of the lock, the last release of a wrapper is an RPC
+            Core::ProxyType<Core::IUnknown> victim;
+
+            _adminLock.Lock();
+
+            auto entry = _leased.find(static_cast<uint32_t>(key));
+
+            ASSERT((entry != _leased.end()) && (entry->second.Out != 0));
+
+            const bool current = (entry->second.Epoch == epoch);
+
+            if (--(entry->second.Out) == 0) {
+                // No lease carries an older epoch anymore, so there is nothing left to remember about this key
+                _leased.erase(entry);
+            }
+
+            if ((_closed == false) && (current == true) && (object.IsValid() == true)) {
+                if (_count >= MaxCached) {
+                    // Keys deleted through another client are never evicted, this keeps them from piling up
+                    auto it = _idle.begin();
+
+                    victim = it->second.front().Object;
+                    it->second.pop_front();
+
+                    if (it->second.empty() == true) {
+                        _idle.erase(it);
+                    }
+
+                    _count--;
+                }
+
+                _idle[key].push_back({ object, dirty });
+                _count++;
+            }
+
+            _adminLock.Unlock();
+        }
+
+        // Only wrappers of this key are dropped, or not taken back once they return
+        void Evict(const uint32_t keyId)
+        {
+            std::list<Wrappers> victims;
+
+            _adminLock.Lock();
+
+            auto entry = _leased.find(keyId);
+
+            if (entry != _leased.end()) {
+                entry->second.Epoch++;
+            }
+
+            auto it = _idle.begin();
+
+            while (it != _idle.end()) {
+                if (static_cast<uint32_t>(it->first) == keyId) {
+                    _count -= static_cast<uint16_t>(it->second.size());
+                    victims.push_back(std::move(it->second));
+                    it = _idle.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+
+            _adminLock.Unlock();
+        }
+
+        void Close()
+        {
+            std::map<uint64_t, Wrappers> victims;
+
+            _adminLock.Lock();
+
+            _closed = true;
+            _count = 0;
+            victims.swap(_idle);
+
+            _adminLock.Unlock();
+        }
+
+    private:
+        mutable Core::CriticalSection _adminLock;
+        std::map<uint64_t, Wrappers> _idle;
+        std::map<uint32_t, Ledger> _leased;
+        uint16_t _count;
+        bool _closed;
+    };
+
+    // The caller's own hold on a pooled calculator, it goes back to the pool once the caller releases it.
+    // The vault is kept alive for as long as that, so the pool can't go away underneath.
+    class RPCHashLease : public Cryptography::IHash {
+    public:
+        RPCHashLease(Cryptography::IVault* owner, WrapperPool& pool, const uint64_t key, const uint32_t epoch, const Core::ProxyType<Core::IUnknown>& object)
+            : _owner(owner)
+            , _pool(pool)
+            , _key(key)
+            , _epoch(epoch)
+            , _object(object)
+            , _hash(reinterpret_cast<Cryptography::IHash*>(object->QueryInterface(Cryptography::IHash::ID)))
+            , _used(false)
+        {
+            ASSERT(_hash != nullptr);
+            _owner->AddRef();
+        }
+        ~RPCHashLease() override
+        {
+            _pool.Give(_key, _epoch, _object, _used);
+
+            _hash->Release();
+            _owner->Release();
+        }
+
+        BEGIN_INTERFACE_MAP(RPCHashLease)
+        INTERFACE_ENTRY(Cryptography::IHash)
+        END_INTERFACE_MAP
+
+    public:
+        uint32_t Ingest(const uint32_t length, const uint8_t data[] /* @length:length */) override
+        {
+            _used = true;
+            return (_hash->Ingest(length, data));
+        }
+
+        uint8_t Calculate(const uint8_t maxLength, uint8_t data[] /* @out @maxlength:maxLength */) override
+        {
+            _used = true;
+            return (_hash->Calculate(maxLength, data));
+        }
+
+        uint16_t Batch(const uint16_t count, const uint32_t inputLength, const uint8_t input[] /* @length:inputLength */,
+            const uint32_t maxOutputLength, uint8_t output[] /* @out @maxlength:maxOutputLength */) override
+        {
+            return (_hash->Batch(count, inputLength, input, maxOutputLength, output));
+        }
+
+        uint32_t Reset() override
+        {
+            uint32_t result = _hash->Reset();
+
+            if (result == Core::ERROR_NONE) {
+                _used = false;
+            }
+
+            return (result);
+        }
+
+        bool Verify(const uint8_t length, const uint8_t expected[] /* @length:length */) override
+        {
+            _used = true;
+            return (_hash->Verify(length, expected));
+        }
+
+    private:
+        Cryptography::IVault* _owner;
+        WrapperPool& _pool;
+        const uint64_t _key;
+        const uint32_t _epoch;
+        Core::ProxyType<Core::IUnknown> _object;
+        Cryptography::IHash* _hash;
+        std::atomic<bool> _used;
+    };
+
+    // Same for a pooled cipher, it is not taken back while a stream (Initialize/Update/Finalize) is left unfinished.
+    class RPCCipherLease : public Cryptography::ICipher {
+    public:
+        RPCCipherLease(Cryptography::IVault* owner, WrapperPool& pool, const uint64_t key, const uint32_t epoch, const Core::ProxyType<Core::IUnknown>& object)
+            : _owner(owner)
+            , _pool(pool)
+            , _key(key)
+            , _epoch(epoch)
+            , _object(object)
+            , _cipher(reinterpret_cast<Cryptography::ICipher*>(object->QueryInterface(Cryptography::ICipher::ID)))
+            , _streaming(false)
+        {
+            ASSERT(_cipher != nullptr);
+            _owner->AddRef();
         }
-        ~RPCCipherImpl() override = default;
+        ~RPCCipherLease() override
+        {
+            _pool.Give(_key, _epoch, (_streaming == false ? _object : Core::ProxyType<Core::IUnknown>()), false);
 
-        BEGIN_INTERFACE_MAP(RPCCipherImpl)
+            _cipher->Release();
+            _owner->Release();
+        }
+
+        BEGIN_INTERFACE_MAP(RPCCipherLease)
         INTERFACE_ENTRY(Cryptography::ICipher)
         END_INTERFACE_MAP
 
@@ -147,80 +1013,90 @@ namespace Implementation {
             const uint32_t inputLength, const uint8_t input[],
             const uint32_t maxOutputLength, uint8_t output[]) const override
         {
-            Core::SafeSyncType<Core::CriticalSection> lock(_adminLock);
-            return (_accessor != nullptr) ? _accessor->Encrypt(ivLength, iv, inputLength, input, maxOutputLength, output) : 0;
+            return (_cipher->Encrypt(ivLength, iv, inputLength, input, maxOutputLength, output));
         }
 
         int32_t Decrypt(const uint8_t ivLength, const uint8_t iv[],
             const uint32_t inputLength, const uint8_t input[],
             const uint32_t maxOutputLength, uint8_t output[]) const override
         {
-            Core::SafeSyncType<Core::CriticalSection> lock(_adminLock);
-            return (_accessor != nullptr) ? _accessor->Decrypt(ivLength, iv, inputLength, input, maxOutputLength, output) : 0;
+            return (_cipher->Decrypt(ivLength, iv, inputLength, input, maxOutputLength, output));
         }
 
-        void Unlink()
+        uint32_t OutputSize(const bool encrypt, const uint32_t inputLength) const override
         {
-            Core::SafeSyncType<Core::CriticalSection> lock(_adminLock);
-            if (_accessor != nullptr) {
-                _accessor->Release();
-                _accessor = nullptr;
-            }
+            return (_cipher->OutputSize(encrypt, inputLength));
         }
 
-    private:
-        mutable Core::CriticalSection _adminLock;
-        Cryptography::ICipher* _accessor;
-    };
+        int32_t EncryptInPlace(const uint8_t ivLength, const uint8_t iv[],
+            const uint32_t length, const uint32_t maxLength, uint8_t data[]) const override
+        {
+            return (_cipher->EncryptInPlace(ivLength, iv, length, maxLength, data));
+        }
 
-    class RPCHashImpl : public Cryptography::IHash {
-    public:
-        RPCHashImpl(Cryptography::IHash* hash)
-            : _accessor(hash)
+        int32_t DecryptInPlace(const uint8_t ivLength, const uint8_t iv[],
+            const uint32_t length, const uint32_t maxLength, uint8_t data[]) const override
         {
-            if (_accessor != nullptr) {
-                _accessor->AddRef();
-            }
+            return (_cipher->DecryptInPlace(ivLength, iv, length, maxLength, data));
         }
-        ~RPCHashImpl() override = default;
 
-        BEGIN_INTERFACE_MAP(RPCHashImpl)
-        INTERFACE_ENTRY(Cryptography::IHash)
-        END_INTERFACE_MAP
+        int32_t Batch(const bool encrypt, const uint8_t ivLength, const uint16_t count,
+            const uint32_t inputLength, const uint8_t input[],
+            const uint32_t maxOutputLength, uint8_t output[]) const override
+        {
+            return (_cipher->Batch(encrypt, ivLength, count, inputLength, input, maxOutputLength, output));
+        }
 
-    public:
-        /* Ingest data into the hash calculator (multiple calls possible) */
-        uint32_t Ingest(const uint32_t length, const uint8_t data[] /* @length:length */) override
+        uint32_t Initialize(const bool encrypt, const uint8_t ivLength, const uint8_t iv[]) override
         {
-            Core::SafeSyncType<Core::CriticalSection> lock(_adminLock);
-            return (_accessor != nullptr ? _accessor->Ingest(length, data) : 0);
+            _streaming = true;
+            return (_cipher->Initialize(encrypt, ivLength, iv));
         }
 
-        /* Calculate the hash from all ingested data */
-        uint8_t Calculate(const uint8_t maxLength, uint8_t data[] /* @out @maxlength:maxLength */) override
+        int32_t Update(const uint32_t inputLength, const uint8_t input[],
+            const uint32_t maxOutputLength, uint8_t output[]) override
         {
-            Core::SafeSyncType<Core::CriticalSection> lock(_adminLock);
-            return (_accessor != nullptr ? _accessor->Calculate(maxLength, data) : 0);
+            return (_cipher->Update(inputLength, input, maxOutputLength, output));
         }
 
-        void Unlink()
+        int32_t Finalize(const uint32_t maxOutputLength, uint8_t output[]) override
         {
-            Core::SafeSyncType<Core::CriticalSection> lock(_adminLock);
-            if (_accessor != nullptr) {
-                _accessor->Release();
-                _accessor = nullptr;
-            }
+            int32_t result = _cipher->Finalize(maxOutputLength, output);
+            _streaming = false;
+            return (result);
+        }
+
+        int32_t EncryptAuthenticated(const uint8_t ivLength, const uint8_t iv[],
+            const uint32_t aadLength, const uint8_t aad[],
+            const uint32_t inputLength, const uint8_t input[],
+            const uint32_t maxOutputLength, uint8_t output[]) const override
+        {
+            return (_cipher->EncryptAuthenticated(ivLength, iv, aadLength, aad, inputLength, input, maxOutputLength, output));
+        }
+
+        int32_t DecryptAuthenticated(const uint8_t ivLength, const uint8_t iv[],
+            const uint32_t aadLength, const uint8_t aad[],
+            const uint32_t inputLength, const uint8_t input[],
+            const uint32_t maxOutputLength, uint8_t output[]) const override
+        {
+            return (_cipher->DecryptAuthenticated(ivLength, iv, aadLength, aad, inputLength, input, maxOutputLength, output));
         }
 
     private:
-        Core::CriticalSection _adminLock;
-        Cryptography::IHash* _accessor;
+        Cryptography::IVault* _owner;
+        WrapperPool& _pool;
+        const uint64_t _key;
+        const uint32_t _epoch;
+        Core::ProxyType<Core::IUnknown> _object;
+        Cryptography::ICipher* _cipher;
+        std::atomic<bool> _streaming;
     };
 
     class RPCVaultImpl : public Cryptography::IVault {
     public:
         RPCVaultImpl(Cryptography::IVault* vault)
             : _accessor(vault)
+            , _pool()
         {
             if (_accessor != nullptr) {
                 _accessor->AddRef();
@@ -237,44 +1113,54 @@ namespace Implementation {
         // (-1 if the blob exists in the vault but is not extractable and 0 if the ID does not exist)
         uint16_t Size(const uint32_t id) const override
         {
-            Core::SafeSyncType<Core::CriticalSection> lock(_adminLock);
-            return (_accessor != nullptr ? _accessor->Size(id) : 0);
+            AccessorType<Cryptography::IVault> accessor(_adminLock, _accessor);
+            return (accessor.IsValid() == true ? accessor->Size(id) : 0);
         }
 
         // Import unencrypted data blob into the vault (returns blob ID)
         // Note: User IDs are always greater than 0x80000000, values below 0x80000000 are reserved for implementation-specific internal data blobs.
         uint32_t Import(const uint16_t length, const uint8_t blob[] /* @length:length */) override
         {
-            Core::SafeSyncType<Core::CriticalSection> lock(_adminLock);
-            return (_accessor != nullptr ? _accessor->Import(length, blob) : 0);
+            AccessorType<Cryptography::IVault> accessor(_adminLock, _accessor);
+            return (accessor.IsValid() == true ? accessor->Import(length, blob) : 0);
         }
 
         // Export unencrypted data blob out of the vault (returns blob ID), only public blobs are exportable
         uint16_t Export(const uint32_t id, const uint16_t maxLength, uint8_t blob[] /* @out @maxlength:maxLength */) const override
         {
-            Core::SafeSyncType<Core::CriticalSection> lock(_adminLock);
-            return (_accessor != nullptr ? _accessor->Export(id, maxLength, blob) : 0);
+            AccessorType<Cryptography::IVault> accessor(_adminLock, _accessor);
+            return (accessor.IsValid() == true ? accessor->Export(id, maxLength, blob) : 0);
         }
 
         // Set encrypted data blob in the vault (returns blob ID)
         uint32_t Set(const uint16_t length, const uint8_t blob[] /* @length:length */) override
         {
-            Core::SafeSyncType<Core::CriticalSection> lock(_adminLock);
-            return (_accessor != nullptr ? _accessor->Set(length, blob) : 0);
+            AccessorType<Cryptography::IVault> accessor(_adminLock, _accessor);
+            return (accessor.IsValid() == true ? accessor->Set(length, blob) : 0);
         }
 
         // Get encrypted data blob out of the vault (data identified by ID, returns size of the retrieved data)
         uint16_t Get(const uint32_t id, const uint16_t maxLength, uint8_t blob[] /* @out @maxlength:maxLength */) const override
         {
-            Core::SafeSyncType<Core::CriticalSection> lock(_adminLock);
-            return (_accessor != nullptr ? _accessor->Get(id, maxLength, blob) : 0);
+            AccessorType<Cryptography::IVault> accessor(_adminLock, _accessor);
+            return (accessor.IsValid() == true ? accessor->Get(id, maxLength, blob) : 0);
         }
 
         // Delete a data blob from the vault
         bool Delete(const uint32_t id) override
         {
-            Core::SafeSyncType<Core::CriticalSection> lock(_adminLock);
-            return (_accessor != nullptr ? _accessor->Delete(id) : false);
+            AccessorType<Cryptography::IVault> accessor(_adminLock, _accessor);
+
+            bool result = false;
+
+            if (accessor.IsValid() == true) {
+                // Ciphers and calculators of a deleted key are of no use anymore
+                _pool.Evict(id);
+
+                result = accessor->Delete(id);
+            }
+
+            return (result);
         }
 
         // Crypto operations using the vault for key storage
@@ -285,23 +1171,48 @@ namespace Implementation {
         {
             Cryptography::IHash* iface = nullptr;
 
-            Core::SafeSyncType<Core::CriticalSection> lock(_adminLock);
+            uint32_t epoch = 0;
+            bool dirty = false;
+            const uint64_t key = WrapperPool::Key(WrapperPool::HMAC_CALCULATOR, hashType, keyId);
+            Core::ProxyType<Core::IUnknown> object = _pool.Take(key, epoch, dirty);
 
-            if (_accessor != nullptr) {
+            if ((object.IsValid() == true) && (dirty == true)) {
+                Cryptography::IHash* hash = reinterpret_cast<Cryptography::IHash*>(object->QueryInterface(Cryptography::IHash::ID));
 
-                iface = _accessor->HMAC(hashType, keyId);
+                ASSERT(hash != nullptr);
 
-                if (iface != nullptr) {
-                    Core::ProxyType<Core::IUnknown> object = CryptographyLink::Instance().Register<RPCHashImpl>(iface);
+                // A calculator that can't be brought back to a clean state is of no use to this caller
+                if (hash->Reset() != Core::ERROR_NONE) {
+                    object = Core::ProxyType<Core::IUnknown>();
+                }
 
-                    ASSERT(object.IsValid() == true);
+                hash->Release();
+            }
 
-                    iface->Release();
+            if (object.IsValid() == false) {
+                AccessorType<Cryptography::IVault> accessor(_adminLock, _accessor);
 
-                    iface = reinterpret_cast<Cryptography::IHash*>(object->QueryInterface(Cryptography::IHash::ID));
+                if (accessor.IsValid() == true) {
+
+                    Cryptography::IHash* hash = accessor->HMAC(hashType, keyId);
+
+                    if (hash != nullptr) {
+                        object = CryptographyLink::Instance().Register<RPCHashImpl>(hash);
+
+                        ASSERT(object.IsValid() == true);
+
+                        hash->Release();
+                    }
                 }
             }
 
+            if (object.IsValid() == true) {
+                // Each caller gets a calculator of its own, an idle one from the pool costs no RPC and no registration
+                iface = Core::Service<RPCHashLease>::Create<Cryptography::IHash>(this, _pool, key, epoch, object);
+            } else {
+                _pool.Give(key, epoch, object, false);
+            }
+
             return iface;
         }
 
@@ -310,23 +1221,34 @@ namespace Implementation {
         {
             Cryptography::ICipher* iface = nullptr;
 
-            Core::SafeSyncType<Core::CriticalSection> lock(_adminLock);
+            uint32_t epoch = 0;
+            bool dirty = false;
+            const uint64_t key = WrapperPool::Key(WrapperPool::AES_CIPHER, aesMode, keyId);
+            Core::ProxyType<Core::IUnknown> object = _pool.Take(key, epoch, dirty);
 
-            if (_accessor != nullptr) {
+            if (object.IsValid() == false) {
+                AccessorType<Cryptography::IVault> accessor(_adminLock, _accessor);
 
-                iface = _accessor->AES(aesMode, keyId);
+                if (accessor.IsValid() == true) {
 
-                if (iface != nullptr) {
-                    Core::ProxyType<Core::IUnknown> object = CryptographyLink::Instance().Register<RPCCipherImpl>(iface);
+                    Cryptography::ICipher* cipher = accessor->AES(aesMode, keyId);
 
-                    ASSERT(object.IsValid() == true);
+                    if (cipher != nullptr) {
+                        object = CryptographyLink::Instance().Register<RPCCipherImpl>(cipher);
 
-                    iface->Release();
+                        ASSERT(object.IsValid() == true);
 
-                    iface = reinterpret_cast<Cryptography::ICipher*>(object->QueryInterface(Cryptography::ICipher::ID));
+                        cipher->Release();
+                    }
                 }
             }
 
+            if (object.IsValid() == true) {
+                iface = Core::Service<RPCCipherLease>::Create<Cryptography::ICipher>(this, _pool, key, epoch, object);
+            } else {
+                _pool.Give(key, epoch, object, false);
+            }
+
             return iface;
         }
 
@@ -335,11 +1257,11 @@ namespace Implementation {
         {
             Cryptography::IDiffieHellman* iface = nullptr;
 
-            Core::SafeSyncType<Core::CriticalSection> lock(_adminLock);
+            AccessorType<Cryptography::IVault> accessor(_adminLock, _accessor);
 
-            if (_accessor != nullptr) {
+            if (accessor.IsValid() == true) {
 
-                iface = _accessor->DiffieHellman();
+                iface = accessor->DiffieHellman();
 
                 if (iface != nullptr) {
                     Core::ProxyType<Core::IUnknown> object = CryptographyLink::Instance().Register<RPCDiffieHellmanImpl>(iface);
@@ -355,8 +1277,20 @@ namespace Implementation {
             return iface;
         }
 
+        // Derive sealed keys from a secret in the vault
+        uint32_t Derive(const Cryptography::hashtype hashType, const uint32_t secretId,
+                        const uint16_t saltLength, const uint8_t salt[],
+                        const uint16_t infoLength, const uint8_t info[],
+                        const uint8_t count, const uint16_t keyLengths[], uint32_t keyIds[]) override
+        {
+            AccessorType<Cryptography::IVault> accessor(_adminLock, _accessor);
+            return (accessor.IsValid() == true ? accessor->Derive(hashType, secretId, saltLength, salt, infoLength, info, count, keyLengths, keyIds) : Core::ERROR_UNAVAILABLE);
+        }
+
         void Unlink()
         {
+            _pool.Close();
+
             Core::SafeSyncType<Core::CriticalSection> lock(_adminLock);
             if (_accessor != nullptr) {
                 _accessor->Release();
@@ -367,6 +1301,7 @@ namespace Implementation {
     private:
         mutable Core::CriticalSection _adminLock;
         Cryptography::IVault* _accessor;
+        WrapperPool _pool;
     };
 
     class RPCCryptographyImpl : public Cryptography::ICryptography {
@@ -392,11 +1327,11 @@ namespace Implementation {
         {
             Cryptography::IHash* iface = nullptr;
 
-            Core::SafeSyncType<Core::CriticalSection> lock(_adminLock);
+            AccessorType<Cryptography::ICryptography> accessor(_adminLock, _accessor);
 
-            if (_accessor != nullptr) {
+            if (accessor.IsValid() == true) {
 
-                iface = _accessor->Hash(hashType);
+                iface = accessor->Hash(hashType);
 
                 if (iface != nullptr) {
                     Core::ProxyType<Core::IUnknown> object = CryptographyLink::Instance().Register<RPCHashImpl>(iface);
@@ -417,11 +1352,11 @@ namespace Implementation {
         {
             Cryptography::IVault* iface = nullptr;
 
-            Core::SafeSyncType<Core::CriticalSection> lock(_adminLock);
+            AccessorType<Cryptography::ICryptography> accessor(_adminLock, _accessor);
 
-            if (_accessor != nullptr) {
+            if (accessor.IsValid() == true) {
 
-                iface = _accessor->Vault(id);
+                iface = accessor->Vault(id);
 
                 if (iface != nullptr) {
                     Core::ProxyType<Core::IUnknown> object = CryptographyLink::Instance().Register<RPCVaultImpl>(iface);
@@ -437,6 +1372,32 @@ namespace Implementation {
             return iface;
         }
 
+        uint32_t EnableStatistics(const bool enable) override
+        {
+            uint32_t result = Core::ERROR_UNAVAILABLE;
+
+            AccessorType<Cryptography::ICryptography> accessor(_adminLock, _accessor);
+
+            if (accessor.IsValid() == true) {
+                result = accessor->EnableStatistics(enable);
+            }
+
+            return (result);
+        }
+
+        uint16_t Statistics(const bool reset, const uint32_t maxLength, uint8_t data[]) override
+        {
+            uint16_t result = 0;
+
+            AccessorType<Cryptography::ICryptography> accessor(_adminLock, _accessor);
+
+            if (accessor.IsValid() == true) {
+                result = accessor->Statistics(reset, maxLength, data);
+            }
+
+            return (result);
+        }
+
         void Unlink()
         {
             Core::SafeSyncType<Core::CriticalSection> lock(_adminLock);
@@ -470,7 +1431,111 @@ namespace Implementation {
         return iface;
     }
 
-    class HashImpl : public WPEFramework::Cryptography::IHash {
+    // Implementation side of the shared memory payload channel (see IHashExchange/ICipherExchange).
+    class ExchangeRegion {
+    public:
+        ExchangeRegion(const ExchangeRegion&) = delete;
+        ExchangeRegion& operator=(const ExchangeRegion&) = delete;
+
+        ExchangeRegion()
+            : _adminLock()
+            , _buffer(nullptr)
+            , _size(0)
+        {
+        }
+        ~ExchangeRegion()
+        {
+            Detach();
+        }
+
+    public:
+        void Lock() const
+        {
+            _adminLock.Lock();
+        }
+        void Unlock() const
+        {
+            _adminLock.Unlock();
+        }
+
+        uint32_t Attach(const string& name, const uint32_t size)
+        {
+            uint32_t result = Core::ERROR_PRIVILIGED_REQUEST;
+
+            // The checks are done on the descriptor that gets mapped, not on the name
+            int fd = ExchangeLocation::Open(name);
+
+            if (fd == -1) {
+                TRACE_L1("Refusing to map %s, not a shared memory region of this library", name.c_str());
+            } else {
+                struct stat info;
+                void* buffer = MAP_FAILED;
+                uint64_t length = 0;
+
+                if ((::fstat(fd, &info) == 0) && (static_cast<uint64_t>(info.st_size) >= size) && (info.st_size > 0)) {
+                    length = static_cast<uint64_t>(info.st_size);
+                    buffer = ::mmap(nullptr, length, (PROT_READ | PROT_WRITE), MAP_SHARED, fd, 0);
+                }
+
+                ::close(fd);
+
+                if (buffer != MAP_FAILED) {
+                    _adminLock.Lock();
+                    uint8_t* previous = _buffer;
+                    const uint64_t previousSize = _size;
+                    _buffer = static_cast<uint8_t*>(buffer);
+                    _size = length;
+                    _adminLock.Unlock();
+
+                    if (previous != nullptr) {
+                        ::munmap(previous, previousSize);
+                    }
+
+                    result = Core::ERROR_NONE;
+                } else {
+                    TRACE_L1("Failed to map shared memory region %s of %u bytes", name.c_str(), size);
+                    result = Core::ERROR_OPENING_FAILED;
+                }
+            }
+
+            return (result);
+        }
+
+        uint32_t Detach()
+        {
+            _adminLock.Lock();
+            uint8_t* buffer = _buffer;
+            uint64_t length = _size;
+            _buffer = nullptr;
+            _size = 0;
+            _adminLock.Unlock();
+
+            if (buffer != nullptr) {
+                ::munmap(buffer, length);
+            }
+
+            return (Core::ERROR_NONE);
+        }
+
+        // To be called with the lock taken, returns nullptr if the requested range is not within the region.
+        uint8_t* Slice(const uint32_t offset, const uint32_t length) const
+        {
+            uint8_t* result = nullptr;
+
+            if ((_buffer != nullptr) && ((static_cast<uint64_t>(offset) + length) <= _size)) {
+                result = (_buffer + offset);
+            }
+
+            return (result);
+        }
+
+    private:
+        mutable Core::CriticalSection _adminLock;
+        uint8_t* _buffer;
+        uint64_t _size;
+    };
+
+    class HashImpl : public WPEFramework::Cryptography::IHash, public WPEFramework::Cryptography::IHashExchange {
     public:
         HashImpl() = delete;
         HashImpl(const HashImpl&) = delete;
@@ -498,13 +1563,56 @@ namespace Implementation {
             return (hash_calculate(_implementation, maxLength, data));
         }
 
+        uint16_t Batch(const uint16_t count, const uint32_t inputLength, const uint8_t input[],
+            const uint32_t maxOutputLength, uint8_t output[]) override
+        {
+            return (hash_batch(_implementation, count, inputLength, input, maxOutputLength, output));
+        }
+
+        uint32_t Reset() override
+        {
+            return (hash_reset(_implementation));
+        }
+
+        bool Verify(const uint8_t length, const uint8_t expected[]) override
+        {
+            return (hash_verify(_implementation, length, expected));
+        }
+
+        uint32_t Attach(const string& name, const uint32_t size) override
+        {
+            return (_exchange.Attach(name, size));
+        }
+
+        uint32_t Detach() override
+        {
+            return (_exchange.Detach());
+        }
+
+        uint32_t Ingest(const uint32_t offset, const uint32_t length) override
+        {
+            uint32_t result = 0;
+
+            Core::SafeSyncType<ExchangeRegion> lock(_exchange);
+
+            const uint8_t* data = _exchange.Slice(offset, length);
+
+            if (data != nullptr) {
+                result = hash_ingest(_implementation, length, data);
+            }
+
+            return (result);
+        }
+
     public:
         BEGIN_INTERFACE_MAP(HashImpl)
         INTERFACE_ENTRY(WPEFramework::Cryptography::IHash)
+        INTERFACE_ENTRY(WPEFramework::Cryptography::IHashExchange)
         END_INTERFACE_MAP
 
     private:
         HashImplementation* _implementation;
+        ExchangeRegion _exchange;
     }; // class HashImpl
 
     class VaultImpl : public WPEFramework::Cryptography::IVault, public WPEFramework::Cryptography::IPersistent {
@@ -605,7 +1713,7 @@ namespace Implementation {
             VaultImpl* _vault;
         }; // class HMACImpl
 
-        class CipherImpl : public WPEFramework::Cryptography::ICipher {
+        class CipherImpl : public WPEFramework::Cryptography::ICipher, public WPEFramework::Cryptography::ICipherExchange {
         public:
             CipherImpl() = delete;
             CipherImpl(const CipherImpl&) = delete;
@@ -641,14 +1749,123 @@ namespace Implementation {
                 return (cipher_decrypt(_implementation, ivLength, iv, inputLength, input, maxOutputLength, output));
             }
 
+            uint32_t OutputSize(const bool encrypt, const uint32_t inputLength) const override
+            {
+                return (cipher_output_size(_implementation, encrypt, inputLength));
+            }
+
+            int32_t EncryptInPlace(const uint8_t ivLength, const uint8_t iv[],
+                const uint32_t length, const uint32_t maxLength, uint8_t data[]) const override
+            {
+                return (cipher_encrypt_in_place(_implementation, ivLength, iv, length, maxLength, data));
+            }
+
+            int32_t DecryptInPlace(const uint8_t ivLength, const uint8_t iv[],
+                const uint32_t length, const uint32_t maxLength, uint8_t data[]) const override
+            {
+                return (cipher_decrypt_in_place(_implementation, ivLength, iv, length, maxLength, data));
+            }
+
+            int32_t Batch(const bool encrypt, const uint8_t ivLength, const uint16_t count,
+                const uint32_t inputLength, const uint8_t input[],
+                const uint32_t maxOutputLength, uint8_t output[]) const override
+            {
+                return (cipher_batch(_implementation, encrypt, ivLength, count, inputLength, input, maxOutputLength, output));
+            }
+
+            uint32_t Initialize(const bool encrypt, const uint8_t ivLength, const uint8_t iv[]) override
+            {
+                return (cipher_stream_initialize(_implementation, encrypt, ivLength, iv));
+            }
+
+            int32_t Update(const uint32_t inputLength, const uint8_t input[],
+                const uint32_t maxOutputLength, uint8_t output[]) override
+            {
+                return (cipher_stream_update(_implementation, inputLength, input, maxOutputLength, output));
+            }
+
+            int32_t Finalize(const uint32_t maxOutputLength, uint8_t output[]) override
+            {
+                return (cipher_stream_finalize(_implementation, maxOutputLength, output));
+            }
+
+            int32_t EncryptAuthenticated(const uint8_t ivLength, const uint8_t iv[],
+                const uint32_t aadLength, const uint8_t aad[],
+                const uint32_t inputLength, const uint8_t input[],
+                const uint32_t maxOutputLength, uint8_t output[]) const override
+            {
+                return (cipher_encrypt_authenticated(_implementation, ivLength, iv, aadLength, aad, inputLength, input, maxOutputLength, output));
+            }
+
+            int32_t DecryptAuthenticated(const uint8_t ivLength, const uint8_t iv[],
+                const uint32_t aadLength, const uint8_t aad[],
+                const uint32_t inputLength, const uint8_t input[],
+                const uint32_t maxOutputLength, uint8_t output[]) const override
+            {
+                return (cipher_decrypt_authenticated(_implementation, ivLength, iv, aadLength, aad, inputLength, input, maxOutputLength, output));
+            }
+
+            uint32_t Attach(const string& name, const uint32_t size) override
+            {
+                return (_exchange.Attach(name, size));
+            }
+
+            uint32_t Detach() override
+            {
+                return (_exchange.Detach());
+            }
+
+            int32_t Encrypt(const uint8_t ivLength, const uint8_t iv[],
+                const uint32_t inputOffset, const uint32_t inputLength,
+                const uint32_t outputOffset, const uint32_t maxOutputLength) const override
+            {
+                return (Process(true, ivLength, iv, inputOffset, inputLength, outputOffset, maxOutputLength));
+            }
+
+            int32_t Decrypt(const uint8_t ivLength, const uint8_t iv[],
+                const uint32_t inputOffset, const uint32_t inputLength,
+                const uint32_t outputOffset, const uint32_t maxOutputLength) const override
+            {
+                return (Process(false, ivLength, iv, inputOffset, inputLength, outputOffset, maxOutputLength));
+            }
+
         public:
             BEGIN_INTERFACE_MAP(CipherImpl)
             INTERFACE_ENTRY(WPEFramework::Cryptography::ICipher)
+            INTERFACE_ENTRY(WPEFramework::Cryptography::ICipherExchange)
             END_INTERFACE_MAP
 
+        private:
+            int32_t Process(const bool encrypt, const uint8_t ivLength, const uint8_t iv[],
+                const uint32_t inputOffset, const uint32_t inputLength,
+                const uint32_t outputOffset, const uint32_t maxOutputLength) const
+            {
+                int32_t result = 0;
+
+                Core::SafeSyncType<ExchangeRegion> lock(_exchange);
+
+                const uint8_t* input = _exchange.Slice(inputOffset, inputLength);
+                uint8_t* output = _exchange.Slice(outputOffset, maxOutputLength);
+
+                if ((input == nullptr) || (output == nullptr)) {
+                    TRACE_L1("Payload is not within the shared memory region");
+                } else if (inputOffset == outputOffset) {
+                    result = (encrypt == true ? cipher_encrypt_in_place(_implementation, ivLength, iv, inputLength, maxOutputLength, output)
+                                              : cipher_decrypt_in_place(_implementation, ivLength, iv, inputLength, maxOutputLength, output));
+                } else if (((static_cast<uint64_t>(inputOffset) + inputLength) > outputOffset) && ((static_cast<uint64_t>(outputOffset) + maxOutputLength) > inputOffset)) {
+                    TRACE_L1("Input and output in the shared memory region overlap");
+                } else {
+                    result = (encrypt == true ? cipher_encrypt(_implementation, ivLength, iv, inputLength, input, maxOutputLength, output)
+                                              : cipher_decrypt(_implementation, ivLength, iv, inputLength, input, maxOutputLength, output));
+                }
+
+                return (result);
+            }
+
         private:
             VaultImpl* _vault;
             CipherImplementation* _implementation;
+            mutable ExchangeRegion _exchange;
         }; // class CipherImpl
 
         class DiffieHellmanImpl : public WPEFramework::Cryptography::IDiffieHellman {
@@ -676,6 +1893,11 @@ namespace Implementation {
                 return (diffiehellman_generate(_vault->Implementation(), generator, modulusSize, modulus, &privKeyId, &pubKeyId));
             }
 
+            uint32_t GenerateEC(const WPEFramework::Cryptography::curvetype curve, uint32_t& privKeyId, uint32_t& pubKeyId) override
+            {
+                return (diffiehellman_generate_ec(_vault->Implementation(), static_cast<curve_type>(curve), &privKeyId, &pubKeyId));
+            }
+
             uint32_t Derive(const uint32_t privateKeyId, const uint32_t peerPublicKeyId, uint32_t& secretId) override
             {
                 return (diffiehellman_derive(_vault->Implementation(), privateKeyId, peerPublicKeyId, &secretId));
@@ -735,6 +1957,14 @@ namespace Implementation {
             return (dh);
         }
 
+        uint32_t Derive(const WPEFramework::Cryptography::hashtype hashType, const uint32_t secretId,
+            const uint16_t saltLength, const uint8_t salt[],
+            const uint16_t infoLength, const uint8_t info[],
+            const uint8_t count, const uint16_t keyLengths[], uint32_t keyIds[]) override
+        {
+            return (hash_derive_keys(_implementation, static_cast<hash_type>(hashType), secretId, saltLength, salt, infoLength, info, count, keyLengths, keyIds));
+        }
+
     public:
         BEGIN_INTERFACE_MAP(VaultImpl)
         INTERFACE_ENTRY(WPEFramework::Cryptography::IVault)
@@ -783,6 +2013,30 @@ namespace Implementation {
             return (vault);
         }
 
+        uint32_t EnableStatistics(const bool enable) override
+        {
+            statistics_enable(enable);
+            return (WPEFramework::Core::ERROR_NONE);
+        }
+
+        uint16_t Statistics(const bool reset, const uint32_t maxLength, uint8_t data[]) override
+        {
+            // The output buffer is not necessarily aligned for the records
+            std::vector<cryptographystatistics> records(maxLength / sizeof(cryptographystatistics));
+
+            const uint16_t result = statistics_query(static_cast<uint16_t>(std::min(records.size(), static_cast<size_t>(USHRT_MAX))), records.data());
+
+            if (result != 0) {
+                ::memcpy(data, records.data(), (result * sizeof(cryptographystatistics)));
+            }
+
+            if (reset == true) {
+                statistics_reset();
+            }
+
+            return (result);
+        }
+
     public:
         BEGIN_INTERFACE_MAP(CryptographyImpl)
         INTERFACE_ENTRY(WPEFramework::Cryptography::ICryptography)
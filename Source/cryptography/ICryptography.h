@@ -21,8 +21,10 @@
 
 #include "Module.h"
 
+#include "cryptography_statistics.h"
 #include "cryptography_vault_ids.h"
 
+/* @stubgen:include "cryptography_statistics.h" */
 /* @stubgen:include "cryptography_vault_ids.h" */
 
 namespace WPEFramework {
@@ -35,7 +37,9 @@ namespace Cryptography {
         ID_CIPHER,
         ID_DIFFIE_HELLMAN,
         ID_CRYPTOGRAPHY,
-        ID_PERSISTENT
+        ID_PERSISTENT,
+        ID_HASH_EXCHANGE,
+        ID_CIPHER_EXCHANGE
     };
 
     enum aesmode : uint8_t {
@@ -45,7 +49,13 @@ namespace Cryptography {
         CFB1,
         CFB8,
         CFB128,
-        CTR
+        CTR,
+        GCM // authenticated, the 16 byte tag is appended to (encrypt) or expected at the end of (decrypt) the data
+    };
+
+    enum curvetype : uint8_t {
+        X25519, // public key: 32 bytes (RFC 7748)
+        P256 // public key: 65 bytes, uncompressed point
     };
 
     enum hashtype : uint8_t {
@@ -69,6 +79,18 @@ namespace Cryptography {
 
         /* Calculate the hash from all ingested data */
         virtual uint8_t Calculate(const uint8_t maxLength, uint8_t data[] /* @out @maxlength:maxLength */) = 0;
+
+        /* Calculate the hashes of a number of independent messages, laid out as [length (uint32_t, native byte order)][data],
+           the digests are stored back to back. Ingested data is not affected. Returns the number of digests calculated */
+        virtual uint16_t Batch(const uint16_t count, const uint32_t inputLength, const uint8_t input[] /* @length:inputLength */,
+                               const uint32_t maxOutputLength, uint8_t output[] /* @out @maxlength:maxOutputLength */) = 0;
+
+        /* Discard all ingested data and start a new calculation with the same algorithm and key */
+        virtual uint32_t Reset() = 0;
+
+        /* Calculate the hash from all ingested data and compare it to the expected one in constant time, a truncated
+           value (down to half of the digest size) is compared to the leading bytes of the digest */
+        virtual bool Verify(const uint8_t length, const uint8_t expected[] /* @length:length */) = 0;
     };
 
     struct EXTERNAL ICipher : virtual public Core::IUnknown {
@@ -90,6 +112,109 @@ namespace Cryptography {
         virtual int32_t Decrypt(const uint8_t ivLength, const uint8_t iv[] /* @length:ivLength */,
                                 const uint32_t inputLength, const uint8_t input[] /* @length:inputLength */,
                                 const uint32_t maxOutputLength, uint8_t output[] /* @out @maxlength:maxOutputLength */) const = 0;
+
+        // Output buffer size needed for Encrypt or Decrypt of inputLength bytes. Exact for encryption, for decryption
+        // with padding it is an upper bound, the actual length is only known once the padding is removed.
+
+        /* Size the output buffer of an operation */
+        virtual uint32_t OutputSize(const bool encrypt, const uint32_t inputLength) const = 0;
+
+        // In place encryption and decryption, the length bytes of input in data are replaced by the result. The data
+        // buffer is maxLength bytes in size, it has to hold OutputSize() bytes. Results and failures are reported as
+        // above, if an operation fails the content of data is undefined.
+
+        /* Encrypt data in place */
+        virtual int32_t EncryptInPlace(const uint8_t ivLength, const uint8_t iv[] /* @length:ivLength */,
+                                       const uint32_t length, const uint32_t maxLength, uint8_t data[] /* @inout @length:maxLength */) const = 0;
+
+        /* Decrypt data in place */
+        virtual int32_t DecryptInPlace(const uint8_t ivLength, const uint8_t iv[] /* @length:ivLength */,
+                                       const uint32_t length, const uint32_t maxLength, uint8_t data[] /* @inout @length:maxLength */) const = 0;
+
+        // Batched encryption or decryption of a number of records with the same key in one go. Every input record is
+        // laid out as [IV (ivLength bytes)][data length (uint32_t, native byte order)][data], the output receives per
+        // record [result length (uint32_t, native byte order)][result]. Returns the total number of output bytes, 0 if
+        // any record failed or a negative size if the output buffer is too small (no record is processed then).
+
+        /* Encrypt or decrypt a batch of records */
+        virtual int32_t Batch(const bool encrypt, const uint8_t ivLength, const uint16_t count,
+                              const uint32_t inputLength, const uint8_t input[] /* @length:inputLength */,
+                              const uint32_t maxOutputLength, uint8_t output[] /* @out @maxlength:maxOutputLength */) const = 0;
+
+        // Streaming encryption and decryption, for data that does not fit in memory at once. Initialize starts
+        // an operation, every Update processes a chunk of input (output may lag up to a block behind) and Finalize
+        // flushes the remaining data, including padding. Output buffer size requirements are reported as above.
+
+        /* Start a streaming encryption or decryption */
+        virtual uint32_t Initialize(const bool encrypt, const uint8_t ivLength, const uint8_t iv[] /* @length:ivLength */) = 0;
+
+        /* Process the next chunk of data */
+        virtual int32_t Update(const uint32_t inputLength, const uint8_t input[] /* @length:inputLength */,
+                               const uint32_t maxOutputLength, uint8_t output[] /* @out @maxlength:maxOutputLength */) = 0;
+
+        /* Complete the streaming operation */
+        virtual int32_t Finalize(const uint32_t maxOutputLength, uint8_t output[] /* @out @maxlength:maxOutputLength */) = 0;
+
+        // Authenticated encryption and decryption (GCM) with additional data, which is covered by the tag but neither
+        // encrypted nor part of the output. Encrypt and Decrypt above do the same without additional data. Results and
+        // failures are reported as above, other modes fail these calls.
+
+        /* Encrypt and authenticate data */
+        virtual int32_t EncryptAuthenticated(const uint8_t ivLength, const uint8_t iv[] /* @length:ivLength */,
+                                             const uint32_t aadLength, const uint8_t aad[] /* @length:aadLength */,
+                                             const uint32_t inputLength, const uint8_t input[] /* @length:inputLength */,
+                                             const uint32_t maxOutputLength, uint8_t output[] /* @out @maxlength:maxOutputLength */) const = 0;
+
+        /* Decrypt and verify data */
+        virtual int32_t DecryptAuthenticated(const uint8_t ivLength, const uint8_t iv[] /* @length:ivLength */,
+                                             const uint32_t aadLength, const uint8_t aad[] /* @length:aadLength */,
+                                             const uint32_t inputLength, const uint8_t input[] /* @length:inputLength */,
+                                             const uint32_t maxOutputLength, uint8_t output[] /* @out @maxlength:maxOutputLength */) const = 0;
+    };
+
+    // Optional payload channel for out-of-process users of IHash and ICipher (query it from those objects). The
+    // client creates a shared memory region (a memory mapped file) and hands its name over with Attach, from then
+    // on the payloads are exchanged through that region and only offsets and lengths into it cross the COM-RPC
+    // channel. Offsets and lengths falling outside of the attached region fail the operation. Only regions created
+    // by the client library in its private directory can be attached.
+
+    struct EXTERNAL IHashExchange : virtual public Core::IUnknown {
+
+        enum { ID = ID_HASH_EXCHANGE };
+
+        ~IHashExchange() override = default;
+
+        /* Map the named shared memory region of (at least) size bytes, replaces a previously attached region */
+        virtual uint32_t Attach(const string& name, const uint32_t size) = 0;
+
+        /* Unmap the shared memory region */
+        virtual uint32_t Detach() = 0;
+
+        /* Ingest data from the shared memory region into the hash calculator */
+        virtual uint32_t Ingest(const uint32_t offset, const uint32_t length) = 0;
+    };
+
+    struct EXTERNAL ICipherExchange : virtual public Core::IUnknown {
+
+        enum { ID = ID_CIPHER_EXCHANGE };
+
+        ~ICipherExchange() override = default;
+
+        /* Map the named shared memory region of (at least) size bytes, replaces a previously attached region */
+        virtual uint32_t Attach(const string& name, const uint32_t size) = 0;
+
+        /* Unmap the shared memory region */
+        virtual uint32_t Detach() = 0;
+
+        /* Encrypt data, input and output are located in the shared memory region and may only overlap if they start at the same offset */
+        virtual int32_t Encrypt(const uint8_t ivLength, const uint8_t iv[] /* @length:ivLength */,
+                                const uint32_t inputOffset, const uint32_t inputLength,
+                                const uint32_t outputOffset, const uint32_t maxOutputLength) const = 0;
+
+        /* Decrypt data, input and output are located in the shared memory region and may only overlap if they start at the same offset */
+        virtual int32_t Decrypt(const uint8_t ivLength, const uint8_t iv[] /* @length:ivLength */,
+                                const uint32_t inputOffset, const uint32_t inputLength,
+                                const uint32_t outputOffset, const uint32_t maxOutputLength) const = 0;
     };
 
     struct EXTERNAL IDiffieHellman : virtual public Core::IUnknown {
@@ -102,8 +227,11 @@ namespace Cryptography {
         virtual uint32_t Generate(const uint8_t generator, const uint16_t modulusSize, const uint8_t modulus[]/* @length:modulusSize */ ,
                                   uint32_t& privKeyId /* @out */, uint32_t& pubKeyId /* @out */) = 0;
 
-        /* Calculate a DH shared secret */
+        /* Calculate a DH or ECDH shared secret, depending on the private key */
         virtual uint32_t Derive(const uint32_t privateKey, const uint32_t peerPublicKeyId, uint32_t& secretId /* @out */) = 0;
+
+        /* Generate elliptic curve private/public keys */
+        virtual uint32_t GenerateEC(const curvetype curve, uint32_t& privKeyId /* @out */, uint32_t& pubKeyId /* @out */) = 0;
     };
 
     struct IPersistent : virtual public Core::IUnknown {
@@ -176,6 +304,15 @@ namespace Cryptography {
 
         // Retrieve a Diffie-Hellman key creator
         virtual IDiffieHellman* DiffieHellman() = 0;
+
+        // Derive keys from a secret using HKDF (RFC 5869), e.g. an encryption and a MAC key in one go: the output keying
+        // material is split into count keys of the given lengths, in order. The keys are kept sealed in the vault and
+        // their IDs go to keyIds, if the derivation fails no key is kept.
+        virtual uint32_t Derive(const hashtype hashType, const uint32_t secretId,
+                                const uint16_t saltLength, const uint8_t salt[] /* @length:saltLength */,
+                                const uint16_t infoLength, const uint8_t info[] /* @length:infoLength */,
+                                const uint8_t count, const uint16_t keyLengths[] /* @length:count */,
+                                uint32_t keyIds[] /* @out @length:count */) = 0;
     };
 
     struct EXTERNAL ICryptography : virtual public Core::IUnknown {
@@ -190,6 +327,14 @@ namespace Cryptography {
 
         // Retrieve a vault (TEE identified by ID)
         virtual IVault* Vault(const cryptographyvault id) = 0;
+
+        // Switch the collection of per-operation statistics on or off
+        // Note: operations are recorded by the OpenSSL and SecApi implementations, the Thunder one records none
+        virtual uint32_t EnableStatistics(const bool enable) = 0;
+
+        // Retrieve the statistics of all operations used so far, stored back to back as cryptographystatistics
+        // records (see cryptography_statistics.h), optionally clearing them afterwards (returns the number of records)
+        virtual uint16_t Statistics(const bool reset, const uint32_t maxLength, uint8_t data[] /* @out @maxlength:maxLength */) = 0;
     };
 
 } // namespace Cryptography
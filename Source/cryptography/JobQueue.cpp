@@ -0,0 +1,299 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 Metrological
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Module.h"
+
+#include "JobQueue.h"
+
+namespace WPEFramework {
+
+namespace Cryptography {
+
+    JobQueue::JobQueue(const uint8_t workers, const uint16_t depth)
+        : _depth(depth)
+        , _bulkWorkers(workers > 1 ? (workers - 1) : 1)
+        , _lock()
+        , _queues()
+        , _minions()
+        , _idle()
+        , _bulkRunning(0)
+        , _stop(false)
+    {
+        ASSERT(workers != 0);
+        ASSERT(depth != 0);
+
+        // The workers are started on the first job that comes along
+        for (uint8_t index = 0; index < workers; index++) {
+            _minions.emplace_back(*this);
+            _idle.push_back(&_minions.back());
+        }
+    }
+
+    JobQueue::~JobQueue()
+    {
+        _lock.Lock();
+        _stop = true;
+        _lock.Unlock();
+
+        // Running jobs complete first, whatever is still queued after that is run from here
+        for (Minion& minion : _minions) {
+            minion.Stop();
+        }
+
+        _minions.clear();
+        _idle.clear();
+
+        Job job;
+        uint8_t urgency;
+
+        _lock.Lock();
+
+        while (Next(job, urgency) == true) {
+            _lock.Unlock();
+            job();
+            _lock.Lock();
+        }
+
+        _lock.Unlock();
+    }
+
+    uint32_t JobQueue::Submit(const priority urgency, const Job& job)
+    {
+        uint32_t result = Core::ERROR_UNAVAILABLE;
+
+        ASSERT(urgency < PRIORITIES);
+        ASSERT(job != nullptr);
+
+        _lock.Lock();
+
+        if ((_stop == false) && (urgency < PRIORITIES) && (_queues[urgency].size() < _depth)) {
+            _queues[urgency].push_back(job);
+
+            if (_idle.empty() == false) {
+                _idle.front()->Run();
+                _idle.pop_front();
+            }
+
+            result = Core::ERROR_NONE;
+        } else {
+            TRACE_L1("Job queue %i is full", urgency);
+        }
+
+        _lock.Unlock();
+
+        return (result);
+    }
+
+    uint32_t JobQueue::Encrypt(const priority urgency, ICipher* cipher,
+                               const uint8_t ivLength, const uint8_t iv[],
+                               const uint32_t inputLength, const uint8_t input[],
+                               const uint32_t maxOutputLength, uint8_t output[],
+                               const std::function<void(const int32_t length)>& completion)
+    {
+        ASSERT(cipher != nullptr);
+
+        cipher->AddRef();
+
+        uint32_t result = Submit(urgency, [=]() {
+            const int32_t length = cipher->Encrypt(ivLength, iv, inputLength, input, maxOutputLength, output);
+            cipher->Release();
+            completion(length);
+        });
+
+        if (result != Core::ERROR_NONE) {
+            cipher->Release();
+        }
+
+        return (result);
+    }
+
+    uint32_t JobQueue::Decrypt(const priority urgency, ICipher* cipher,
+                               const uint8_t ivLength, const uint8_t iv[],
+                               const uint32_t inputLength, const uint8_t input[],
+                               const uint32_t maxOutputLength, uint8_t output[],
+                               const std::function<void(const int32_t length)>& completion)
+    {
+        ASSERT(cipher != nullptr);
+
+        cipher->AddRef();
+
+        uint32_t result = Submit(urgency, [=]() {
+            const int32_t length = cipher->Decrypt(ivLength, iv, inputLength, input, maxOutputLength, output);
+            cipher->Release();
+            completion(length);
+        });
+
+        if (result != Core::ERROR_NONE) {
+            cipher->Release();
+        }
+
+        return (result);
+    }
+
+    uint32_t JobQueue::Calculate(const priority urgency, IHash* hash,
+                                 const uint32_t length, const uint8_t data[],
+                                 const uint8_t maxLength, uint8_t digest[],
+                                 const std::function<void(const uint8_t length)>& completion)
+    {
+        ASSERT(hash != nullptr);
+
+        hash->AddRef();
+
+        uint32_t result = Submit(urgency, [=]() {
+            uint8_t digestLength = 0;
+
+            if (hash->Ingest(length, data) == length) {
+                digestLength = hash->Calculate(maxLength, digest);
+            }
+
+            hash->Release();
+            completion(digestLength);
+        });
+
+        if (result != Core::ERROR_NONE) {
+            hash->Release();
+        }
+
+        return (result);
+    }
+
+    uint32_t JobQueue::Generate(const priority urgency, IDiffieHellman* diffieHellman,
+                                const uint8_t generator, const uint16_t modulusSize, const uint8_t modulus[],
+                                const std::function<void(const uint32_t result, const uint32_t privKeyId, const uint32_t pubKeyId)>& completion)
+    {
+        ASSERT(diffieHellman != nullptr);
+
+        diffieHellman->AddRef();
+
+        uint32_t result = Submit(urgency, [=]() {
+            uint32_t privKeyId = 0;
+            uint32_t pubKeyId = 0;
+            const uint32_t outcome = diffieHellman->Generate(generator, modulusSize, modulus, privKeyId, pubKeyId);
+            diffieHellman->Release();
+            completion(outcome, privKeyId, pubKeyId);
+        });
+
+        if (result != Core::ERROR_NONE) {
+            diffieHellman->Release();
+        }
+
+        return (result);
+    }
+
+    uint32_t JobQueue::Derive(const priority urgency, IDiffieHellman* diffieHellman,
+                              const uint32_t privateKey, const uint32_t peerPublicKeyId,
+                              const std::function<void(const uint32_t result, const uint32_t secretId)>& completion)
+    {
+        ASSERT(diffieHellman != nullptr);
+
+        diffieHellman->AddRef();
+
+        uint32_t result = Submit(urgency, [=]() {
+            uint32_t secretId = 0;
+            const uint32_t outcome = diffieHellman->Derive(privateKey, peerPublicKeyId, secretId);
+            diffieHellman->Release();
+            completion(outcome, secretId);
+        });
+
+        if (result != Core::ERROR_NONE) {
+            diffieHellman->Release();
+        }
+
+        return (result);
+    }
+
+    uint32_t JobQueue::Derive(const priority urgency, IVault* vault,
+                              const hashtype hashType, const uint32_t secretId,
+                              const uint16_t saltLength, const uint8_t salt[],
+                              const uint16_t infoLength, const uint8_t info[],
+                              const uint8_t count, const uint16_t keyLengths[], uint32_t keyIds[],
+                              const std::function<void(const uint32_t result)>& completion)
+    {
+        ASSERT(vault != nullptr);
+
+        vault->AddRef();
+
+        uint32_t result = Submit(urgency, [=]() {
+            const uint32_t outcome = vault->Derive(hashType, secretId, saltLength, salt, infoLength, info, count, keyLengths, keyIds);
+            vault->Release();
+            completion(outcome);
+        });
+
+        if (result != Core::ERROR_NONE) {
+            vault->Release();
+        }
+
+        return (result);
+    }
+
+    // To be called with the lock taken: takes the most urgent job, bulk jobs only while a worker is left for the others
+    bool JobQueue::Next(Job& job, uint8_t& urgency)
+    {
+        urgency = 0;
+
+        while ((urgency < PRIORITIES) && ((_queues[urgency].empty() == true) || ((urgency == BULK) && (_bulkRunning >= _bulkWorkers)))) {
+            urgency++;
+        }
+
+        if (urgency < PRIORITIES) {
+            job = std::move(_queues[urgency].front());
+            _queues[urgency].pop_front();
+        }
+
+        return (urgency < PRIORITIES);
+    }
+
+    uint32_t JobQueue::Process(Minion& minion)
+    {
+        uint32_t result = 0;
+        uint8_t urgency;
+        Job job;
+
+        _lock.Lock();
+
+        if (Next(job, urgency) == false) {
+            // Until Submit() hands out more work
+            _idle.push_back(&minion);
+            minion.Block();
+
+            result = Core::infinite;
+        } else {
+            if (urgency == BULK) {
+                _bulkRunning++;
+            }
+
+            _lock.Unlock();
+
+            job();
+
+            _lock.Lock();
+
+            if (urgency == BULK) {
+                _bulkRunning--;
+            }
+        }
+
+        _lock.Unlock();
+
+        return (result);
+    }
+
+} // namespace Cryptography
+
+} // namespace WPEFramework
@@ -0,0 +1,162 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 Metrological
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "ICryptography.h"
+
+#include <deque>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+
+namespace WPEFramework {
+
+namespace Cryptography {
+
+    // Runs cryptographic operations on a pool of worker threads, so callers like UI or network threads do not
+    // block on them. Every priority has a queue of its own, bounded by depth: submitting to a full queue fails
+    // immediately. Workers always pick the most urgent job first and BULK jobs never occupy the last worker (if
+    // there is more than one), so HIGH and NORMAL work does not wait for long running bulk operations to finish.
+    //
+    // The interfaces passed in are kept referenced until the job completed, all buffers are owned by the caller
+    // and must stay valid up to the completion. Completions are called on a worker thread. Jobs still queued
+    // when the queue is destroyed are run before it returns.
+    class EXTERNAL JobQueue {
+    public:
+        enum priority : uint8_t {
+            HIGH,
+            NORMAL,
+            BULK
+        };
+
+        using Job = std::function<void()>;
+
+    public:
+        JobQueue() = delete;
+        JobQueue(const JobQueue&) = delete;
+        JobQueue& operator=(const JobQueue&) = delete;
+
+        JobQueue(const uint8_t workers, const uint16_t depth);
+        ~JobQueue();
+
+    public:
+        // Queue a job (returns ERROR_NONE, or ERROR_UNAVAILABLE if the queue of this priority is full)
+        uint32_t Submit(const priority urgency, const Job& job);
+
+        // Queue a job and get hold of its result, the future is not valid if the job could not be queued
+        template <typename RESULT>
+        std::future<RESULT> Submit(const priority urgency, const std::function<RESULT()>& job)
+        {
+            std::shared_ptr<std::packaged_task<RESULT()>> task(std::make_shared<std::packaged_task<RESULT()>>(job));
+            std::future<RESULT> result(task->get_future());
+
+            if (Submit(urgency, Job([task]() { (*task)(); })) != Core::ERROR_NONE) {
+                result = std::future<RESULT>();
+            }
+
+            return (result);
+        }
+
+        // Encrypt data, the completion receives the ICipher::Encrypt result
+        uint32_t Encrypt(const priority urgency, ICipher* cipher,
+                         const uint8_t ivLength, const uint8_t iv[],
+                         const uint32_t inputLength, const uint8_t input[],
+                         const uint32_t maxOutputLength, uint8_t output[],
+                         const std::function<void(const int32_t length)>& completion);
+
+        // Decrypt data, the completion receives the ICipher::Decrypt result
+        uint32_t Decrypt(const priority urgency, ICipher* cipher,
+                         const uint8_t ivLength, const uint8_t iv[],
+                         const uint32_t inputLength, const uint8_t input[],
+                         const uint32_t maxOutputLength, uint8_t output[],
+                         const std::function<void(const int32_t length)>& completion);
+
+        // Ingest data into a hash or HMAC calculator and calculate it, the completion receives the digest length (0 on failure)
+        uint32_t Calculate(const priority urgency, IHash* hash,
+                           const uint32_t length, const uint8_t data[],
+                           const uint8_t maxLength, uint8_t digest[],
+                           const std::function<void(const uint8_t length)>& completion);
+
+        // Generate DH private/public keys, the completion receives the IDiffieHellman::Generate results
+        uint32_t Generate(const priority urgency, IDiffieHellman* diffieHellman,
+                          const uint8_t generator, const uint16_t modulusSize, const uint8_t modulus[],
+                          const std::function<void(const uint32_t result, const uint32_t privKeyId, const uint32_t pubKeyId)>& completion);
+
+        // Calculate a DH or ECDH shared secret, the completion receives the IDiffieHellman::Derive results
+        uint32_t Derive(const priority urgency, IDiffieHellman* diffieHellman,
+                        const uint32_t privateKey, const uint32_t peerPublicKeyId,
+                        const std::function<void(const uint32_t result, const uint32_t secretId)>& completion);
+
+        // Derive keys from a secret using HKDF, the completion receives the IVault::Derive result (key IDs in keyIds)
+        uint32_t Derive(const priority urgency, IVault* vault,
+                        const hashtype hashType, const uint32_t secretId,
+                        const uint16_t saltLength, const uint8_t salt[],
+                        const uint16_t infoLength, const uint8_t info[],
+                        const uint8_t count, const uint16_t keyLengths[], uint32_t keyIds[],
+                        const std::function<void(const uint32_t result)>& completion);
+
+    private:
+        static constexpr uint8_t PRIORITIES = (BULK + 1);
+
+        class Minion : public Core::Thread {
+        public:
+            Minion() = delete;
+            Minion(const Minion&) = delete;
+            Minion& operator=(const Minion&) = delete;
+
+            Minion(JobQueue& parent)
+                : Core::Thread(Core::Thread::DefaultStackSize(), _T("CryptographyJobs"))
+                , _parent(parent)
+            {
+            }
+            ~Minion() override
+            {
+                Stop();
+                Wait(Core::Thread::STOPPED, Core::infinite);
+            }
+
+        private:
+            uint32_t Worker() override
+            {
+                return (_parent.Process(*this));
+            }
+
+        private:
+            JobQueue& _parent;
+        };
+
+        uint32_t Process(Minion& minion);
+        bool Next(Job& job, uint8_t& urgency);
+
+    private:
+        const uint16_t _depth;
+        const uint8_t _bulkWorkers;
+        Core::CriticalSection _lock;
+        std::deque<Job> _queues[PRIORITIES];
+        std::list<Minion> _minions;
+        std::list<Minion*> _idle;
+        uint8_t _bulkRunning;
+        bool _stop;
+    };
+
+} // namespace Cryptography
+
+} // namespace WPEFramework
@@ -21,3 +21,4 @@
 
 #include "ICryptography.h"
 #include "INetflixSecurity.h"
+#include "JobQueue.h"
@@ -0,0 +1,63 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 Metrological
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/* Latency histogram: bucket 0 counts calls under 1 us, bucket n calls of [2^(n-1), 2^n) us, the last one all slower calls */
+#define CRYPTOGRAPHY_LATENCY_BUCKETS 20
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    enum cryptographyoperation : uint8_t {
+        CRYPTOGRAPHY_OPERATION_HASH = 0,
+        CRYPTOGRAPHY_OPERATION_HMAC = 1,
+        CRYPTOGRAPHY_OPERATION_ENCRYPT = 2,
+        CRYPTOGRAPHY_OPERATION_DECRYPT = 3,
+        CRYPTOGRAPHY_OPERATION_DH_GENERATE = 4,
+        CRYPTOGRAPHY_OPERATION_DH_DERIVE = 5,
+        CRYPTOGRAPHY_OPERATION_KEY_DERIVE = 6,
+        CRYPTOGRAPHY_OPERATION_VAULT_IMPORT = 7,
+        CRYPTOGRAPHY_OPERATION_VAULT_EXPORT = 8,
+        CRYPTOGRAPHY_OPERATION_VAULT_SET = 9,
+        CRYPTOGRAPHY_OPERATION_VAULT_GET = 10,
+        CRYPTOGRAPHY_OPERATION_VAULT_DELETE = 11
+    };
+
+    /* Statistics of one operation with one algorithm:
+         algorithm: digest size for hashes, HMAC and key derivation, key size (in bytes) for ciphers,
+                    0 (MODP), 1 (X25519) or 2 (P256) for Diffie-Hellman and 0 for vault operations
+         mode:      AES mode for ciphers (see aesmode), 0 otherwise */
+    struct cryptographystatistics {
+        uint8_t operation;
+        uint8_t algorithm;
+        uint8_t mode;
+        uint8_t reserved[5];
+        uint64_t calls;
+        uint64_t bytes;
+        uint64_t nanoseconds;
+        uint32_t latency[CRYPTOGRAPHY_LATENCY_BUCKETS];
+    };
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
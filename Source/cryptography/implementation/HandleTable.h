@@ -0,0 +1,499 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 Metrological
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+
+namespace Implementation {
+
+    // Storage for vault blobs, addressed by handles that carry a slot index and a generation.
+    // Slots live in chunks that are locked in memory (and kept out of core dumps), small blobs -
+    // which covers all symmetric keys - are stored inline so looking one up is an index into an
+    // array rather than a walk over tree nodes. Larger blobs are carved out of a single arena,
+    // locked and kept out of core dumps just the same. A slot is recycled once its blob is removed,
+    // the bumped generation makes sure stale handles to it fail to resolve.
+    //
+    // User handles have the top bit set:  1 | generation (15 bits) | slot index (16 bits)
+    // Reserved handles (1 up to RESERVED - 1) are meant for implementation-specific blobs.
+    //
+    // The slots can be spread over a number of independently locked shards, the shard of a slot
+    // being its index modulo the number of shards. Locks are only held to copy a blob in or out,
+    // so whatever is done with a blob (e.g. unsealing it) happens on the copy, outside of them.
+    class HandleTable {
+    public:
+        static constexpr uint32_t USER = 0x80000000;
+        static constexpr uint32_t RESERVED = 32;
+        static constexpr uint16_t INLINE_SIZE = 80;
+
+    private:
+        static constexpr uint32_t MAX_SLOTS = 0x10000;
+        static constexpr uint16_t CHUNK_SLOTS = 256;
+        static constexpr uint16_t MAX_CHUNKS = (MAX_SLOTS / CHUNK_SLOTS);
+        static constexpr uint16_t MAX_GENERATION = 0x7FFF;
+        static constexpr uint32_t NONE = UINT32_MAX;
+
+        enum flags : uint8_t {
+            USED = 0x01,
+            EXPORTABLE = 0x02
+        };
+
+        struct Slot {
+            uint8_t* External;
+            uint64_t Serial;
+            uint32_t Next;
+            uint16_t Generation;
+            uint16_t Size;
+            uint8_t Flags;
+            uint8_t Inline[INLINE_SIZE];
+
+            const uint8_t* Data() const
+            {
+                return (External != nullptr ? External : Inline);
+            }
+        };
+
+        struct Shard {
+            Shard()
+                : Lock()
+                , Free(NONE)
+                , Next(0)
+                , Chunks()
+            {
+            }
+
+            mutable WPEFramework::Core::CriticalSection Lock;
+            uint32_t Free;
+            uint32_t Next;
+            Slot* Chunks[MAX_CHUNKS];
+        };
+
+        // Blobs too large to be stored inline. The address range is reserved once, pages are only committed (and
+        // locked) when the used part grows into them, so it costs no memory until needed and a syscall pair only
+        // every GROWTH bytes. Blocks come in power of two classes and go to a free list of their class once
+        // released, they are reused from there before the arena grows any further.
+        class Arena {
+        private:
+            static constexpr uint32_t SIZE = (16 * 1024 * 1024);
+            static constexpr uint32_t GROWTH = (64 * 1024);
+            static constexpr uint8_t MIN_CLASS = 7; // 128 bytes, larger than INLINE_SIZE
+            static constexpr uint8_t MAX_CLASS = 16; // 64KB, the largest blob size
+
+            struct Block {
+                Block* Next;
+            };
+
+        public:
+            Arena(const Arena&) = delete;
+            Arena& operator=(const Arena&) = delete;
+
+            Arena()
+                : _lock()
+                , _base(nullptr)
+                , _used(0)
+                , _committed(0)
+                , _free()
+            {
+            }
+            ~Arena()
+            {
+                if (_base != nullptr) {
+                    ::munlock(_base, _committed);
+                    ::munmap(_base, SIZE);
+                }
+            }
+
+        public:
+            uint8_t* Allocate(const uint16_t size)
+            {
+                uint8_t* result = nullptr;
+
+                const uint8_t index = Class(size);
+                const uint32_t length = (1 << index);
+
+                WPEFramework::Core::SafeSyncType<WPEFramework::Core::CriticalSection> lock(_lock);
+
+                Block*& head = _free[index - MIN_CLASS];
+
+                if (head != nullptr) {
+                    result = reinterpret_cast<uint8_t*>(head);
+                    head = head->Next;
+                } else if (Reserve() == true) {
+                    // Blocks are aligned to their size, as the used part only ever grows by whole blocks of a class
+                    const uint32_t offset = (((_used + length - 1) / length) * length);
+
+                    if ((offset + length) <= SIZE) {
+                        if (((offset + length) <= _committed) || (Commit(offset + length) == true)) {
+                            result = (_base + offset);
+
+                            // The alignment gap is of no use to this class, hand it to the smaller ones
+                            Recycle(_used, offset);
+                            _used = (offset + length);
+                        }
+                    } else {
+                        TRACE_L1("Vault arena exhausted, can not store a blob of %i bytes", size);
+                    }
+                }
+
+                return (result);
+            }
+
+            void Free(uint8_t* block, const uint16_t size)
+            {
+                const uint8_t index = Class(size);
+
+                WPEFramework::Core::SafeSyncType<WPEFramework::Core::CriticalSection> lock(_lock);
+
+                Block* entry = reinterpret_cast<Block*>(block);
+                entry->Next = _free[index - MIN_CLASS];
+                _free[index - MIN_CLASS] = entry;
+            }
+
+        private:
+            static uint8_t Class(const uint16_t size)
+            {
+                uint8_t index = MIN_CLASS;
+
+                while ((static_cast<uint32_t>(1) << index) < size) {
+                    index++;
+                }
+
+                return (index);
+            }
+
+            bool Reserve()
+            {
+                if (_base == nullptr) {
+                    void* area = ::mmap(nullptr, SIZE, PROT_NONE, (MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE), -1, 0);
+
+                    if (area != MAP_FAILED) {
+                        _base = reinterpret_cast<uint8_t*>(area);
+#ifdef MADV_DONTDUMP
+                        ::madvise(_base, SIZE, MADV_DONTDUMP);
+#endif
+                    } else {
+                        TRACE_L1("Failed to reserve the vault arena");
+                    }
+                }
+
+                return (_base != nullptr);
+            }
+
+            bool Commit(const uint32_t required)
+            {
+                bool result = false;
+
+                const uint32_t rounded = (((required + GROWTH - 1) / GROWTH) * GROWTH);
+                const uint32_t committed = (rounded < SIZE ? rounded : SIZE);
+                uint8_t* area = (_base + _committed);
+                const size_t length = (committed - _committed);
+
+                if (::mprotect(area, length, (PROT_READ | PROT_WRITE)) == 0) {
+                    if (::mlock(area, length) != 0) {
+                        TRACE_L1("Failed to lock %u bytes of the vault arena in memory (%i), the blobs in it may be swapped out", static_cast<uint32_t>(length), errno);
+                    }
+
+                    _committed = committed;
+                    result = true;
+                } else {
+                    TRACE_L1("Failed to commit %u bytes of the vault arena", static_cast<uint32_t>(length));
+                }
+
+                return (result);
+            }
+
+            // Splits the range into the largest aligned blocks that fit and puts them on their free lists
+            void Recycle(uint32_t from, const uint32_t to)
+            {
+                while (from < to) {
+                    uint8_t index = MAX_CLASS;
+
+                    while ((index >= MIN_CLASS) && (((from % (1 << index)) != 0) || ((from + (1 << index)) > to))) {
+                        index--;
+                    }
+
+                    if (index < MIN_CLASS) {
+                        // Blocks are at least MIN_CLASS aligned, so this is only a remainder we can not use
+                        break;
+                    }
+
+                    Block* entry = reinterpret_cast<Block*>(_base + from);
+                    entry->Next = _free[index - MIN_CLASS];
+                    _free[index - MIN_CLASS] = entry;
+
+                    from += (1 << index);
+                }
+            }
+
+        private:
+            WPEFramework::Core::CriticalSection _lock;
+            uint8_t* _base;
+            uint32_t _used;
+            uint32_t _committed;
+            Block* _free[MAX_CLASS - MIN_CLASS + 1];
+        };
+
+    public:
+        HandleTable() = delete;
+        HandleTable(const HandleTable&) = delete;
+        HandleTable& operator=(const HandleTable&) = delete;
+
+        HandleTable(const uint8_t shards)
+            : _count(shards)
+            , _shards(new Shard[shards])
+            , _arena()
+            , _round(0)
+            , _serial(0)
+        {
+            ASSERT((shards != 0) && ((RESERVED % shards) == 0));
+
+            for (uint8_t index = 0; index < _count; index++) {
+                _shards[index].Next = (RESERVED / _count);
+            }
+        }
+
+        ~HandleTable()
+        {
+            for (uint8_t index = 0; index < _count; index++) {
+                for (Slot*& chunk : _shards[index].Chunks) {
+                    if (chunk != nullptr) {
+                        for (uint16_t slot = 0; slot < CHUNK_SLOTS; slot++) {
+                            Clear(chunk[slot]);
+                        }
+
+                        Unmap(chunk);
+                        chunk = nullptr;
+                    }
+                }
+            }
+
+            delete[] _shards;
+        }
+
+    public:
+        // Stores a blob, on the given reserved handle or else on a fresh user handle (returns 0 on failure).
+        uint32_t Insert(const uint16_t size, const uint8_t blob[], const bool exportable, const uint32_t reserved = 0)
+        {
+            uint32_t id = 0;
+
+            if (reserved < RESERVED) {
+                const uint8_t index = (reserved != 0 ? (reserved % _count) : static_cast<uint8_t>(_round++ % _count));
+                Shard& shard(_shards[index]);
+
+                WPEFramework::Core::SafeSyncType<WPEFramework::Core::CriticalSection> lock(shard.Lock);
+
+                uint32_t local = NONE;
+
+                if (reserved != 0) {
+                    local = (reserved / _count);
+                } else if (shard.Free != NONE) {
+                    local = shard.Free;
+                } else if (shard.Next < (MAX_SLOTS / _count)) {
+                    local = shard.Next;
+                }
+
+                Slot* slot = (local != NONE ? Acquire(shard, local) : nullptr);
+
+                if ((slot != nullptr) && ((slot->Flags & USED) == 0)) {
+                    uint8_t* external = nullptr;
+
+                    if ((size <= INLINE_SIZE) || ((external = _arena.Allocate(size)) != nullptr)) {
+                        if (reserved != 0) {
+                            id = reserved;
+                        } else {
+                            if (local == shard.Free) {
+                                shard.Free = slot->Next;
+                            } else {
+                                shard.Next++;
+                            }
+
+                            slot->Generation = (slot->Generation == MAX_GENERATION ? 1 : (slot->Generation + 1));
+                            id = (USER | (static_cast<uint32_t>(slot->Generation) << 16) | ((local * _count) + index));
+                        }
+
+                        slot->External = external;
+                        slot->Serial = ++_serial;
+                        slot->Next = NONE;
+                        slot->Size = size;
+                        slot->Flags = (USED | (exportable == true ? EXPORTABLE : 0));
+                        ::memcpy((external != nullptr ? external : slot->Inline), blob, size);
+                    }
+                }
+            }
+
+            return (id);
+        }
+
+        // Copies up to maxSize bytes of a blob out (returns the full size of the blob, 0 if the handle is not valid).
+        uint16_t Copy(const uint32_t id, const uint16_t maxSize, uint8_t blob[], bool& exportable) const
+        {
+            uint16_t size = 0;
+            const Shard& shard(_shards[Index(id) % _count]);
+
+            WPEFramework::Core::SafeSyncType<WPEFramework::Core::CriticalSection> lock(shard.Lock);
+
+            const Slot* slot = Find(shard, id);
+
+            if (slot != nullptr) {
+                size = slot->Size;
+                exportable = ((slot->Flags & EXPORTABLE) != 0);
+
+                if (blob != nullptr) {
+                    ::memcpy(blob, slot->Data(), std::min(size, maxSize));
+                }
+            }
+
+            return (size);
+        }
+
+        // Identifies the blob stored under a handle. Unlike a handle, which comes back once the generation of its
+        // slot wraps around, a serial is never reused (returns 0 if the handle is not valid).
+        uint64_t Serial(const uint32_t id) const
+        {
+            uint64_t serial = 0;
+            const Shard& shard(_shards[Index(id) % _count]);
+
+            WPEFramework::Core::SafeSyncType<WPEFramework::Core::CriticalSection> lock(shard.Lock);
+
+            const Slot* slot = Find(shard, id);
+
+            if (slot != nullptr) {
+                serial = slot->Serial;
+            }
+
+            return (serial);
+        }
+
+        bool Remove(const uint32_t id)
+        {
+            bool result = false;
+            Shard& shard(_shards[Index(id) % _count]);
+
+            WPEFramework::Core::SafeSyncType<WPEFramework::Core::CriticalSection> lock(shard.Lock);
+
+            Slot* slot = const_cast<Slot*>(Find(shard, id));
+
+            if (slot != nullptr) {
+                Clear(*slot);
+
+                if ((id & USER) != 0) {
+                    slot->Next = shard.Free;
+                    shard.Free = (Index(id) / _count);
+                }
+
+                result = true;
+            }
+
+            return (result);
+        }
+
+    private:
+        static uint32_t Index(const uint32_t id)
+        {
+            return ((id & USER) != 0 ? (id & 0xFFFF) : id);
+        }
+
+        const Slot* Find(const Shard& shard, const uint32_t id) const
+        {
+            const Slot* slot = nullptr;
+
+            const uint32_t index = Index(id);
+            const uint16_t generation = ((id & USER) != 0 ? static_cast<uint16_t>((id >> 16) & MAX_GENERATION) : 0);
+
+            if ((index < MAX_SLOTS) && (((id & USER) != 0) ? (generation != 0) : ((id != 0) && (id < RESERVED)))) {
+                const uint32_t local = (index / _count);
+                const Slot* chunk = shard.Chunks[local / CHUNK_SLOTS];
+
+                if ((chunk != nullptr) && ((chunk[local % CHUNK_SLOTS].Flags & USED) != 0) && (chunk[local % CHUNK_SLOTS].Generation == generation)) {
+                    slot = &chunk[local % CHUNK_SLOTS];
+                }
+            }
+
+            return (slot);
+        }
+
+        static Slot* Acquire(Shard& shard, const uint32_t local)
+        {
+            Slot*& chunk = shard.Chunks[local / CHUNK_SLOTS];
+
+            if (chunk == nullptr) {
+                chunk = Map();
+            }
+
+            return (chunk != nullptr ? &chunk[local % CHUNK_SLOTS] : nullptr);
+        }
+
+        void Clear(Slot& slot)
+        {
+            // shred :)
+            if (slot.External != nullptr) {
+                ::memset(slot.External, 0xFF, slot.Size);
+                _arena.Free(slot.External, slot.Size);
+                slot.External = nullptr;
+            }
+
+            ::memset(slot.Inline, 0xFF, sizeof(slot.Inline));
+            slot.Serial = 0;
+            slot.Size = 0;
+            slot.Flags = 0;
+        }
+
+        static Slot* Map()
+        {
+            Slot* result = nullptr;
+
+            // Anonymous pages come zeroed: all slots unused, generation 0
+            void* area = ::mmap(nullptr, (CHUNK_SLOTS * sizeof(Slot)), (PROT_READ | PROT_WRITE), (MAP_PRIVATE | MAP_ANONYMOUS), -1, 0);
+
+            if (area != MAP_FAILED) {
+                if (::mlock(area, (CHUNK_SLOTS * sizeof(Slot))) != 0) {
+                    TRACE_L1("Failed to lock a chunk of vault slots in memory (%i), the blobs in it may be swapped out", errno);
+                }
+#ifdef MADV_DONTDUMP
+                ::madvise(area, (CHUNK_SLOTS * sizeof(Slot)), MADV_DONTDUMP);
+#endif
+                result = reinterpret_cast<Slot*>(area);
+            }
+
+            return (result);
+        }
+
+        static void Unmap(Slot* chunk)
+        {
+            ::munlock(chunk, (CHUNK_SLOTS * sizeof(Slot)));
+            ::munmap(chunk, (CHUNK_SLOTS * sizeof(Slot)));
+        }
+
+    private:
+        const uint8_t _count;
+        Shard* _shards;
+        Arena _arena;
+        std::atomic<uint32_t> _round;
+        std::atomic<uint64_t> _serial;
+    };
+
+} // namespace Implementation
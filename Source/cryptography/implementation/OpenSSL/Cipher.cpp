@@ -32,6 +32,10 @@
 
 #include <limits.h>
 
+#include <algorithm>
+
+#include "../Parallel.h"
+#include "../Statistics.h"
 #include "Vault.h"
 
 struct CipherImplementation {
@@ -43,6 +47,24 @@ struct CipherImplementation {
         const uint32_t inputLength, const uint8_t input[],
         const uint32_t maxOutputLength, uint8_t output[]) const = 0;
 
+    virtual int32_t Batch(const bool encrypt, const uint8_t ivLength, const uint16_t count,
+        const uint32_t inputLength, const uint8_t input[],
+        const uint32_t maxOutputLength, uint8_t output[]) const = 0;
+
+    virtual uint32_t OutputSize(const bool encrypt, const uint32_t inputLength) const = 0;
+
+    virtual uint32_t Initialize(const bool encrypt, const uint8_t ivLength, const uint8_t iv[]) = 0;
+
+    virtual int32_t Update(const uint32_t inputLength, const uint8_t input[],
+        const uint32_t maxOutputLength, uint8_t output[]) = 0;
+
+    virtual int32_t Finalize(const uint32_t maxOutputLength, uint8_t output[]) = 0;
+
+    virtual int32_t Authenticated(const bool encrypt, const uint8_t ivLength, const uint8_t iv[],
+        const uint32_t aadLength, const uint8_t aad[],
+        const uint32_t inputLength, const uint8_t input[],
+        const uint32_t maxOutputLength, uint8_t output[]) const = 0;
+
     virtual ~CipherImplementation() {}
 };
 
@@ -65,28 +87,35 @@ public:
     Cipher& operator=(const Cipher) = delete;
     Cipher() = delete;
 
-    Cipher(const Implementation::Vault* vault, const EVP_CIPHER* cipher, const uint32_t keyId, const uint8_t keyLength, const uint8_t ivLength)
-        : _context(nullptr)
+    Cipher(const Implementation::Vault* vault, const EVP_CIPHER* cipher, const aes_mode mode, const uint32_t keyId, const uint8_t keyLength, const uint8_t ivLength, const uint8_t tagLength = 0)
+        : _lock()
+        , _encryptContext(nullptr)
+        , _decryptContext(nullptr)
+        , _streamContext(nullptr)
+        , _streaming(false)
+        , _streamEncrypt(false)
         , _vault(vault)
         , _cipher(cipher)
+        , _mode(mode)
         , _keyId(keyId)
         , _keyLength(keyLength)
         , _ivLength(ivLength)
+        , _tagLength(tagLength)
+        , _serial(vault->Serial(keyId))
     {
         ASSERT(vault != nullptr);
         ASSERT(cipher != nullptr);
         ASSERT(keyId != 0);
         ASSERT(keyLength != 0);
         ASSERT(ivLength != 0);
-
-        _context = EVP_CIPHER_CTX_new();
-        ASSERT(_context != nullptr);
     }
 
     ~Cipher() override
     {
-        if (_context != nullptr) {
-            EVP_CIPHER_CTX_free(_context);
+        Invalidate();
+
+        if (_streamContext != nullptr) {
+            EVP_CIPHER_CTX_free(_streamContext);
         }
     }
 
@@ -104,26 +133,244 @@ public:
         return (Operation(false, ivLength, iv, inputLength, input, maxOutputLength, output));
     }
 
-private:
-    int32_t Operation(bool encrypt,
-        const uint8_t ivLength, const uint8_t iv[],
+    int32_t Authenticated(const bool encrypt, const uint8_t ivLength, const uint8_t iv[],
+        const uint32_t aadLength, const uint8_t aad[],
         const uint32_t inputLength, const uint8_t input[],
-        const uint32_t maxOutputLength, uint8_t output[]) const
+        const uint32_t maxOutputLength, uint8_t output[]) const override
     {
         int32_t result = 0;
 
-        ASSERT(iv != nullptr);
-        ASSERT(ivLength != 0);
+        ASSERT((aadLength == 0) || (aad != nullptr));
+
+        if (_tagLength == 0) {
+            TRACE_L1("Not an authenticated cipher mode");
+        } else {
+            result = Operation(encrypt, ivLength, iv, inputLength, input, maxOutputLength, output, aadLength, aad);
+        }
+
+        return (result);
+    }
+
+    uint32_t OutputSize(const bool encrypt, const uint32_t inputLength) const override
+    {
+        uint32_t result = inputLength;
+
+        const uint32_t blockSize = EVP_CIPHER_block_size(_cipher);
+
+        if (_tagLength != 0) {
+            result = (encrypt == true ? (inputLength + _tagLength) : (inputLength > _tagLength ? (inputLength - _tagLength) : 0));
+        } else if ((encrypt == true) && (blockSize > 1)) {
+            // PKCS#7, a full block of padding if the input is block aligned
+            result = (inputLength + (blockSize - (inputLength % blockSize)));
+        }
+
+        return (result);
+    }
+
+    int32_t Batch(const bool encrypt, const uint8_t ivLength, const uint16_t count,
+        const uint32_t inputLength, const uint8_t input[],
+        const uint32_t maxOutputLength, uint8_t output[]) const override
+    {
+        int32_t result = 0;
+
+        Statistics::Scope scope(Statistic(encrypt), _keyLength, _mode, inputLength);
+
         ASSERT(input != nullptr);
-        ASSERT(inputLength != 0);
+
+        const uint32_t blockSize = EVP_CIPHER_block_size(_cipher);
+        const uint32_t header = (ivLength + sizeof(uint32_t));
+        uint32_t required = 0;
+        uint32_t offset = 0;
+        uint16_t index = 0;
+
+        // Validate the layout and size up the output before touching any record.
+        while ((index < count) && ((inputLength - offset) >= header)) {
+            uint32_t length;
+            ::memcpy(&length, (input + offset + ivLength), sizeof(length));
+
+            if (length > (inputLength - offset - header)) {
+                break;
+            }
+
+            offset += (header + length);
+            required += (sizeof(uint32_t) + (((encrypt == true) && (blockSize > 1)) ? (length + (blockSize - (length % blockSize))) : length));
+            required += (encrypt == true ? _tagLength : 0);
+            index++;
+        }
+
+        if (ivLength != _ivLength) {
+            TRACE_L1("Invalid IV length! [%i]", ivLength);
+        } else if ((index != count) || (offset != inputLength)) {
+            TRACE_L1("Malformed batch, %i of %i records are valid", index, count);
+        } else if (maxOutputLength < required) {
+            TRACE_L1("Too small output buffer, expected: %i bytes", required);
+            result = (-static_cast<int32_t>(required));
+        } else {
+            WPEFramework::Core::SafeSyncType<WPEFramework::Core::CriticalSection> lock(_lock);
+
+            EVP_CIPHER_CTX* context = Context(encrypt);
+
+            if (context != nullptr) {
+                uint32_t written = 0;
+
+                offset = 0;
+                index = 0;
+
+                while (index < count) {
+                    uint32_t length;
+                    ::memcpy(&length, (input + offset + ivLength), sizeof(length));
+
+                    int32_t processed = Process(context, encrypt, (input + offset), length, (input + offset + header), (output + written + sizeof(uint32_t)));
+
+                    // An empty result is fine (e.g. a padding only block or a tag only record)
+                    if (processed < 0) {
+                        break;
+                    }
+
+                    ::memcpy((output + written), &processed, sizeof(uint32_t));
+                    written += (sizeof(uint32_t) + processed);
+                    offset += (header + length);
+                    index++;
+                }
+
+                result = (index == count ? static_cast<int32_t>(written) : 0);
+            }
+        }
+
+        return (result);
+    }
+
+    uint32_t Initialize(const bool encrypt, const uint8_t ivLength, const uint8_t iv[]) override
+    {
+        uint32_t result = WPEFramework::Core::ERROR_GENERAL;
+
+        ASSERT(iv != nullptr);
+
+        WPEFramework::Core::SafeSyncType<WPEFramework::Core::CriticalSection> lock(_lock);
+
+        _streaming = false;
 
         if (ivLength != _ivLength) {
             TRACE_L1("Invalid IV length! [%i]", ivLength);
-        } else if (maxOutputLength < inputLength) {
-            // Note: Pitfall, AES CBC/ECB will use padding
-            TRACE_L1("Too small output buffer, expected: %i bytes", inputLength);
-            result = (-static_cast<int32_t>(inputLength + (16 - (inputLength % 16))));
+            result = WPEFramework::Core::ERROR_BAD_REQUEST;
+        } else if (_tagLength != 0) {
+            TRACE_L1("Streaming is not supported for authenticated modes");
+            result = WPEFramework::Core::ERROR_NOT_SUPPORTED;
+        } else {
+            EVP_CIPHER_CTX* context = Context(encrypt);
+
+            if (context == nullptr) {
+                result = WPEFramework::Core::ERROR_UNAVAILABLE;
+            } else {
+                if (_streamContext == nullptr) {
+                    _streamContext = EVP_CIPHER_CTX_new();
+                    ASSERT(_streamContext != nullptr);
+                }
+
+                ERR_clear_error();
+
+                // Start off from the prepared key schedule, the one-shot operations keep using theirs.
+                if ((EVP_CIPHER_CTX_copy(_streamContext, context) == 0) || (EVP_CipherInit_ex(_streamContext, nullptr, nullptr, nullptr, iv, encrypt) == 0)) {
+                    TRACE_L1("Failed to start a streaming operation: %s", GetSSLError().c_str());
+                } else {
+                    _streaming = true;
+                    _streamEncrypt = encrypt;
+                    result = WPEFramework::Core::ERROR_NONE;
+                }
+            }
+        }
+
+        return (result);
+    }
+
+    int32_t Update(const uint32_t inputLength, const uint8_t input[],
+        const uint32_t maxOutputLength, uint8_t output[]) override
+    {
+        int32_t result = 0;
+
+        ASSERT(input != nullptr);
+
+        WPEFramework::Core::SafeSyncType<WPEFramework::Core::CriticalSection> lock(_lock);
+
+        Statistics::Scope scope(Statistic(_streamEncrypt), _keyLength, _mode, inputLength);
+
+        // A block may be held back from a previous update
+        const uint32_t blockSize = EVP_CIPHER_block_size(_cipher);
+        const uint32_t required = (inputLength + (blockSize > 1 ? blockSize : 0));
+
+        if (_streaming == false) {
+            TRACE_L1("No streaming operation in progress");
+        } else if (maxOutputLength < required) {
+            TRACE_L1("Too small output buffer, expected: %i bytes", required);
+            result = (-static_cast<int32_t>(required));
+        } else {
+            int len = 0;
+
+            if (EVP_CipherUpdate(_streamContext, output, &len, input, inputLength) == 0) {
+                TRACE_L1("EVP_CipherUpdate() failed: %s", GetSSLError().c_str());
+                _streaming = false;
+            } else {
+                result = len;
+            }
+        }
+
+        return (result);
+    }
+
+    int32_t Finalize(const uint32_t maxOutputLength, uint8_t output[]) override
+    {
+        int32_t result = 0;
+
+        WPEFramework::Core::SafeSyncType<WPEFramework::Core::CriticalSection> lock(_lock);
+
+        const uint32_t blockSize = EVP_CIPHER_block_size(_cipher);
+
+        if (_streaming == false) {
+            TRACE_L1("No streaming operation in progress");
+        } else if ((blockSize > 1) && (maxOutputLength < blockSize)) {
+            TRACE_L1("Too small output buffer, expected: %i bytes", blockSize);
+            result = (-static_cast<int32_t>(blockSize));
         } else {
+            int len = 0;
+
+            if (EVP_CipherFinal_ex(_streamContext, output, &len) == 0) {
+                TRACE_L1("EVP_CipherFinal_ex() failed: %s", GetSSLError().c_str());
+            } else {
+                result = len;
+            }
+
+            _streaming = false;
+        }
+
+        return (result);
+    }
+
+private:
+    void Invalidate() const
+    {
+        if (_encryptContext != nullptr) {
+            EVP_CIPHER_CTX_free(_encryptContext);
+            _encryptContext = nullptr;
+        }
+        if (_decryptContext != nullptr) {
+            EVP_CIPHER_CTX_free(_decryptContext);
+            _decryptContext = nullptr;
+        }
+    }
+
+    // Returns a context with the key schedule already set up, so an operation
+    // only needs to (re)load the IV. The key is exported from the vault only
+    // once per direction and dropped again as soon as the key is deleted.
+    EVP_CIPHER_CTX* Context(bool encrypt) const
+    {
+        EVP_CIPHER_CTX*& context = (encrypt == true ? _encryptContext : _decryptContext);
+
+        // Handles are recycled (with a new generation), the serial tells if the blob
+        // behind our handle is still the key the schedule was made from.
+        if (_vault->Serial(_keyId) != _serial) {
+            TRACE_L1("Key 0x%08x is no longer available", _keyId);
+            Invalidate();
+        } else if (context == nullptr) {
             uint8_t* keyBuf = reinterpret_cast<uint8_t*>(ALLOCA(_keyLength));
             ASSERT(keyBuf != nullptr);
 
@@ -134,42 +381,263 @@ private:
                 TRACE_L1("Failed to retrieve a valid encryption key from id 0x%08x", _keyId);
             } else {
                 ERR_clear_error();
-                int len = 0;
-                int initResult = EVP_CipherInit_ex(_context, _cipher, nullptr, keyBuf, iv, encrypt);
-                ::memset(keyBuf, 0xFF, length);
+                context = EVP_CIPHER_CTX_new();
+                ASSERT(context != nullptr);
 
-                if (initResult == 0) {
+                if (EVP_CipherInit_ex(context, _cipher, nullptr, keyBuf, nullptr, encrypt) == 0) {
                     TRACE_L1("EVP_CipherInit_ex() failed: %s", GetSSLError().c_str());
+                    EVP_CIPHER_CTX_free(context);
+                    context = nullptr;
+                }
+            }
+
+            ::memset(keyBuf, 0xFF, _keyLength);
+        }
+
+        return (context);
+    }
+
+    static cryptographyoperation Statistic(const bool encrypt)
+    {
+        return (encrypt == true ? CRYPTOGRAPHY_OPERATION_ENCRYPT : CRYPTOGRAPHY_OPERATION_DECRYPT);
+    }
+
+    int32_t Operation(bool encrypt,
+        const uint8_t ivLength, const uint8_t iv[],
+        const uint32_t inputLength, const uint8_t input[],
+        const uint32_t maxOutputLength, uint8_t output[],
+        const uint32_t aadLength = 0, const uint8_t aad[] = nullptr) const
+    {
+        int32_t result = 0;
+
+        Statistics::Scope scope(Statistic(encrypt), _keyLength, _mode, inputLength);
+
+        ASSERT(iv != nullptr);
+        ASSERT(ivLength != 0);
+        ASSERT(input != nullptr);
+        ASSERT(inputLength != 0);
+
+        const uint32_t required = OutputSize(encrypt, inputLength);
+
+        if (ivLength != _ivLength) {
+            TRACE_L1("Invalid IV length! [%i]", ivLength);
+        } else if (maxOutputLength < required) {
+            TRACE_L1("Too small output buffer, expected: %i bytes", required);
+            result = (-static_cast<int32_t>(required));
+        } else {
+            WPEFramework::Core::SafeSyncType<WPEFramework::Core::CriticalSection> lock(_lock);
+
+            EVP_CIPHER_CTX* context = Context(encrypt);
+
+            if (context != nullptr) {
+                // Failures are reported as 0 here, negative results mean the output buffer is too small
+                result = std::max(Process(context, encrypt, iv, inputLength, input, output, aadLength, aad), 0);
+            }
+        }
+
+        return (result);
+    }
+
+    // Returns the number of bytes produced, which may be 0, or -1 on failure.
+    int32_t Process(EVP_CIPHER_CTX* context, bool encrypt, const uint8_t iv[],
+        const uint32_t inputLength, const uint8_t input[], uint8_t output[],
+        const uint32_t aadLength = 0, const uint8_t aad[] = nullptr) const
+    {
+        return (_tagLength == 0 ? Plain(context, encrypt, iv, inputLength, input, output)
+                                : Seal(context, encrypt, iv, aadLength, aad, inputLength, input, output));
+    }
+
+    // Single pass encryption and authentication, the tag travels behind the ciphertext.
+    int32_t Seal(EVP_CIPHER_CTX* context, bool encrypt, const uint8_t iv[],
+        const uint32_t aadLength, const uint8_t aad[],
+        const uint32_t inputLength, const uint8_t input[], uint8_t output[]) const
+    {
+        int32_t result = -1;
+
+        const uint32_t dataLength = (encrypt == true ? inputLength : (inputLength - _tagLength));
+
+        ERR_clear_error();
+        int len = 0;
+        int fed = 0;
+
+        if ((encrypt == false) && (inputLength < _tagLength)) {
+            TRACE_L1("Input too short to hold an authentication tag");
+        } else if (EVP_CipherInit_ex(context, nullptr, nullptr, nullptr, iv, encrypt) == 0) {
+            TRACE_L1("EVP_CipherInit_ex() failed: %s", GetSSLError().c_str());
+        } else if ((aadLength != 0) && (EVP_CipherUpdate(context, nullptr, &fed, aad, aadLength) == 0)) {
+            // No output buffer, this only feeds the additional data into the tag
+            TRACE_L1("Failed to process the additional data: %s", GetSSLError().c_str());
+        } else if ((dataLength != 0) && (EVP_CipherUpdate(context, output, &len, input, dataLength) == 0)) {
+            TRACE_L1("EVP_CipherUpdate() failed: %s", GetSSLError().c_str());
+        } else {
+            int32_t length = len;
+            len = 0;
+
+            if (encrypt == true) {
+                if ((EVP_CipherFinal_ex(context, (output + length), &len) == 0)
+                    || (EVP_CIPHER_CTX_ctrl(context, EVP_CTRL_GCM_GET_TAG, _tagLength, (output + length + len)) == 0)) {
+                    TRACE_L1("Failed to complete authenticated encryption: %s", GetSSLError().c_str());
                 } else {
-                    if (EVP_CipherUpdate(_context, output, &len, input, inputLength) == 0) {
-                        TRACE_L1("EVP_CipherUpdate() failed: %s", GetSSLError().c_str());
-                    } else {
-                        result = len;
-                        len = 0;
-                        // Note: EVP_CipherFinal_ex() can still write to the output buffer!
-                        if (EVP_CipherFinal_ex(_context, (output + result), &len) == 0) {
-                            TRACE_L1("EVP_CipherFinal_ex() failed: %s", GetSSLError().c_str());
-                            result = 0;
-                        } else {
-                            result += len;
-                            TRACE_L2("Completed %scryption, input size: %i, output size: %i",
-                                (encrypt ? "en" : "de"), inputLength, result);
-                        }
-                    }
+                    result = (length + len + _tagLength);
+                }
+            } else {
+                // The tag has to be known before finalizing, that is where it gets verified.
+                if ((EVP_CIPHER_CTX_ctrl(context, EVP_CTRL_GCM_SET_TAG, _tagLength, const_cast<uint8_t*>(input + dataLength)) == 0)
+                    || (EVP_CipherFinal_ex(context, (output + length), &len) == 0)) {
+                    TRACE_L1("Authentication of the decrypted data failed");
+                    ::memset(output, 0, length);
+                } else {
+                    result = (length + len);
                 }
             }
+
+            if (result >= 0) {
+                TRACE_L2("Completed authenticated %scryption, input size: %i, output size: %i",
+                    (encrypt ? "en" : "de"), inputLength, result);
+            }
+        }
+
+        return (result);
+    }
+
+    int32_t Plain(EVP_CIPHER_CTX* context, bool encrypt, const uint8_t iv[],
+        const uint32_t inputLength, const uint8_t input[], uint8_t output[]) const
+    {
+        int32_t result = -1;
+
+        ERR_clear_error();
+        int len = 0;
+
+        const uint8_t chunks = Chunks(encrypt, inputLength);
+
+        if (chunks > 1) {
+            result = Spread(context, encrypt, iv, chunks, inputLength, input, output);
+        }
+        // Keep the key schedule, only load the new IV.
+        else if (EVP_CipherInit_ex(context, nullptr, nullptr, nullptr, iv, encrypt) == 0) {
+            TRACE_L1("EVP_CipherInit_ex() failed: %s", GetSSLError().c_str());
+        } else {
+            if (EVP_CipherUpdate(context, output, &len, input, inputLength) == 0) {
+                TRACE_L1("EVP_CipherUpdate() failed: %s", GetSSLError().c_str());
+            } else {
+                const int32_t length = len;
+                len = 0;
+                // Note: EVP_CipherFinal_ex() can still write to the output buffer!
+                if (EVP_CipherFinal_ex(context, (output + length), &len) == 0) {
+                    TRACE_L1("EVP_CipherFinal_ex() failed: %s", GetSSLError().c_str());
+                } else {
+                    result = (length + len);
+                    TRACE_L2("Completed %scryption, input size: %i, output size: %i",
+                        (encrypt ? "en" : "de"), inputLength, result);
+                }
+            }
+        }
+
+        return (result);
+    }
+
+    // CTR and CBC decryption do not chain from one block into the next, so large inputs can be cut
+    // into block aligned chunks that are processed concurrently, each starting off from its own IV.
+    uint8_t Chunks(const bool encrypt, const uint32_t inputLength) const
+    {
+        uint8_t result = 1;
+
+        const int mode = EVP_CIPHER_mode(_cipher);
+
+        if ((Parallel::Enabled == true) && (inputLength >= Parallel::Threshold)
+            && ((mode == EVP_CIPH_CTR_MODE) || ((mode == EVP_CIPH_CBC_MODE) && (encrypt == false) && ((inputLength % Parallel::BlockSize) == 0)))) {
+            result = Parallel::Instance().Chunks(inputLength);
+        }
+
+        return (result);
+    }
+
+    int32_t Spread(EVP_CIPHER_CTX* context, bool encrypt, const uint8_t iv[], const uint8_t chunks,
+        const uint32_t inputLength, const uint8_t input[], uint8_t output[]) const
+    {
+        int32_t result = -1;
+
+        const bool counter = (EVP_CIPHER_mode(_cipher) == EVP_CIPH_CTR_MODE);
+
+        uint8_t* ivs = reinterpret_cast<uint8_t*>(ALLOCA(chunks * Parallel::BlockSize));
+        EVP_CIPHER_CTX** contexts = reinterpret_cast<EVP_CIPHER_CTX**>(ALLOCA(chunks * sizeof(EVP_CIPHER_CTX*)));
+        int32_t* lengths = reinterpret_cast<int32_t*>(ALLOCA(chunks * sizeof(int32_t)));
+        bool prepared = true;
+
+        // Collect the IVs before any output gets written, when decrypting in place the
+        // ciphertext block preceding a CBC chunk is overwritten by the chunk before it.
+        for (uint8_t index = 0; index < chunks; index++) {
+            const uint32_t offset = Parallel::Offset(inputLength, chunks, index);
+            uint8_t* chunkIV = (ivs + (index * Parallel::BlockSize));
+
+            if ((counter == true) || (index == 0)) {
+                ::memcpy(chunkIV, iv, Parallel::BlockSize);
+                Parallel::Advance(chunkIV, (counter == true ? (offset / Parallel::BlockSize) : 0));
+            } else {
+                ::memcpy(chunkIV, (input + offset - Parallel::BlockSize), Parallel::BlockSize);
+            }
+
+            contexts[index] = EVP_CIPHER_CTX_new();
+            ASSERT(contexts[index] != nullptr);
+
+            // Only the last chunk may carry the padding.
+            if ((EVP_CIPHER_CTX_copy(contexts[index], context) == 0)
+                || (EVP_CipherInit_ex(contexts[index], nullptr, nullptr, nullptr, chunkIV, encrypt) == 0)
+                || (EVP_CIPHER_CTX_set_padding(contexts[index], (index == (chunks - 1) ? 1 : 0)) == 0)) {
+                TRACE_L1("Failed to prepare cipher chunk %i: %s", index, GetSSLError().c_str());
+                prepared = false;
+            }
+        }
+
+        if (prepared == true) {
+            const bool success = Parallel::Instance().Run(chunks, [&](const uint8_t index) -> bool {
+                const uint32_t offset = Parallel::Offset(inputLength, chunks, index);
+                const uint32_t length = (index == (chunks - 1) ? inputLength : Parallel::Offset(inputLength, chunks, (index + 1))) - offset;
+                int len = 0;
+                int tail = 0;
+
+                bool completed = ((EVP_CipherUpdate(contexts[index], (output + offset), &len, (input + offset), length) != 0)
+                    && (EVP_CipherFinal_ex(contexts[index], (output + offset + len), &tail) != 0));
+
+                lengths[index] = (len + tail);
+
+                // Anything but the last chunk has to map one on one
+                return ((completed == true) && ((index == (chunks - 1)) || (static_cast<uint32_t>(lengths[index]) == length)));
+            });
+
+            if (success == false) {
+                TRACE_L1("Concurrent %scryption failed: %s", (encrypt ? "en" : "de"), GetSSLError().c_str());
+            } else {
+                result = (Parallel::Offset(inputLength, chunks, (chunks - 1)) + lengths[chunks - 1]);
+                TRACE_L2("Completed %scryption in %i chunks, input size: %i, output size: %i",
+                    (encrypt ? "en" : "de"), chunks, inputLength, result);
+            }
+        }
+
+        for (uint8_t index = 0; index < chunks; index++) {
+            if (contexts[index] != nullptr) {
+                EVP_CIPHER_CTX_free(contexts[index]);
+            }
         }
 
         return (result);
     }
 
 private:
-    EVP_CIPHER_CTX* _context;
+    mutable WPEFramework::Core::CriticalSection _lock;
+    mutable EVP_CIPHER_CTX* _encryptContext;
+    mutable EVP_CIPHER_CTX* _decryptContext;
+    EVP_CIPHER_CTX* _streamContext;
+    bool _streaming;
+    bool _streamEncrypt;
     const Implementation::Vault* _vault;
     const EVP_CIPHER* _cipher;
+    aes_mode _mode;
     uint32_t _keyId;
     uint8_t _keyLength;
     uint8_t _ivLength;
+    uint8_t _tagLength;
+    uint64_t _serial;
 };
 
 const EVP_CIPHER* AESCipher(const uint8_t keySize, const aes_mode mode)
@@ -178,10 +646,10 @@ const EVP_CIPHER* AESCipher(const uint8_t keySize, const aes_mode mode)
 
     typedef const EVP_CIPHER* (*cipherfn)(void);
 
-    static const cipherfn cipherTable[][7] = {
-        { EVP_aes_128_ecb, EVP_aes_128_cbc, EVP_aes_128_ofb, EVP_aes_128_cfb1, EVP_aes_128_cfb8, EVP_aes_128_cfb128, EVP_aes_128_ctr },
-        { EVP_aes_192_ecb, EVP_aes_192_cbc, EVP_aes_192_ofb, EVP_aes_192_cfb1, EVP_aes_192_cfb8, EVP_aes_192_cfb128, EVP_aes_192_ctr },
-        { EVP_aes_256_ecb, EVP_aes_256_cbc, EVP_aes_256_ofb, EVP_aes_256_cfb1, EVP_aes_256_cfb8, EVP_aes_256_cfb128, EVP_aes_256_ctr }
+    static const cipherfn cipherTable[][8] = {
+        { EVP_aes_128_ecb, EVP_aes_128_cbc, EVP_aes_128_ofb, EVP_aes_128_cfb1, EVP_aes_128_cfb8, EVP_aes_128_cfb128, EVP_aes_128_ctr, EVP_aes_128_gcm },
+        { EVP_aes_192_ecb, EVP_aes_192_cbc, EVP_aes_192_ofb, EVP_aes_192_cfb1, EVP_aes_192_cfb8, EVP_aes_192_cfb128, EVP_aes_192_ctr, EVP_aes_192_gcm },
+        { EVP_aes_256_ecb, EVP_aes_256_cbc, EVP_aes_256_ofb, EVP_aes_256_cfb1, EVP_aes_256_cfb8, EVP_aes_256_cfb128, EVP_aes_256_ctr, EVP_aes_256_gcm }
     };
 
     uint8_t idx = -1;
@@ -207,6 +675,9 @@ const EVP_CIPHER* AESCipher(const uint8_t keySize, const aes_mode mode)
     case aes_mode::AES_MODE_CTR:
         idx = 6;
         break;
+    case aes_mode::AES_MODE_GCM:
+        idx = 7;
+        break;
     default:
         TRACE_L1("Unsupported AES cipher block mode %i", mode);
     }
@@ -244,7 +715,11 @@ struct CipherImplementation* cipher_create_aes(const struct VaultImplementation*
         const EVP_CIPHER* evpcipher = Implementation::AESCipher(static_cast<uint8_t>(keyLength), mode);
         ASSERT(evpcipher != nullptr);
         if (evpcipher != nullptr) {
-            cipher = new Implementation::Cipher(vaultImpl, evpcipher, key_id, static_cast<uint8_t>(keyLength), 16);
+            if (mode == aes_mode::AES_MODE_GCM) {
+                cipher = new Implementation::Cipher(vaultImpl, evpcipher, mode, key_id, static_cast<uint8_t>(keyLength), 12, 16);
+            } else {
+                cipher = new Implementation::Cipher(vaultImpl, evpcipher, mode, key_id, static_cast<uint8_t>(keyLength), 16);
+            }
         }
     }
 
@@ -271,4 +746,67 @@ int32_t cipher_decrypt(const struct CipherImplementation* cipher, const uint8_t
     return (cipher->Decrypt(iv_length, iv, input_length, input, max_output_length, output));
 }
 
+uint32_t cipher_output_size(const struct CipherImplementation* cipher, const bool encrypt, const uint32_t input_length)
+{
+    ASSERT(cipher != nullptr);
+    return (cipher->OutputSize(encrypt, input_length));
+}
+
+// EVP operations may write to the buffer they read from, as long as both start at the same address.
+int32_t cipher_encrypt_in_place(const struct CipherImplementation* cipher, const uint8_t iv_length, const uint8_t iv[],
+    const uint32_t length, const uint32_t max_length, uint8_t data[])
+{
+    ASSERT(cipher != nullptr);
+    return (cipher->Encrypt(iv_length, iv, length, data, max_length, data));
+}
+
+int32_t cipher_decrypt_in_place(const struct CipherImplementation* cipher, const uint8_t iv_length, const uint8_t iv[],
+    const uint32_t length, const uint32_t max_length, uint8_t data[])
+{
+    ASSERT(cipher != nullptr);
+    return (cipher->Decrypt(iv_length, iv, length, data, max_length, data));
+}
+
+int32_t cipher_batch(const struct CipherImplementation* cipher, const bool encrypt, const uint8_t iv_length, const uint16_t count,
+    const uint32_t input_length, const uint8_t input[], const uint32_t max_output_length, uint8_t output[])
+{
+    ASSERT(cipher != nullptr);
+    return (cipher->Batch(encrypt, iv_length, count, input_length, input, max_output_length, output));
+}
+
+uint32_t cipher_stream_initialize(struct CipherImplementation* cipher, const bool encrypt, const uint8_t iv_length, const uint8_t iv[])
+{
+    ASSERT(cipher != nullptr);
+    return (cipher->Initialize(encrypt, iv_length, iv));
+}
+
+int32_t cipher_stream_update(struct CipherImplementation* cipher, const uint32_t input_length, const uint8_t input[],
+    const uint32_t max_output_length, uint8_t output[])
+{
+    ASSERT(cipher != nullptr);
+    return (cipher->Update(input_length, input, max_output_length, output));
+}
+
+int32_t cipher_stream_finalize(struct CipherImplementation* cipher, const uint32_t max_output_length, uint8_t output[])
+{
+    ASSERT(cipher != nullptr);
+    return (cipher->Finalize(max_output_length, output));
+}
+
+int32_t cipher_encrypt_authenticated(const struct CipherImplementation* cipher, const uint8_t iv_length, const uint8_t iv[],
+    const uint32_t aad_length, const uint8_t aad[],
+    const uint32_t input_length, const uint8_t input[], const uint32_t max_output_length, uint8_t output[])
+{
+    ASSERT(cipher != nullptr);
+    return (cipher->Authenticated(true, iv_length, iv, aad_length, aad, input_length, input, max_output_length, output));
+}
+
+int32_t cipher_decrypt_authenticated(const struct CipherImplementation* cipher, const uint8_t iv_length, const uint8_t iv[],
+    const uint32_t aad_length, const uint8_t aad[],
+    const uint32_t input_length, const uint8_t input[], const uint32_t max_output_length, uint8_t output[])
+{
+    ASSERT(cipher != nullptr);
+    return (cipher->Authenticated(false, iv_length, iv, aad_length, aad, input_length, input, max_output_length, output));
+}
+
 } // extern "C"
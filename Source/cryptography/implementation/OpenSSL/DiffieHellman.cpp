@@ -21,16 +21,21 @@
 
 #include <openssl/ossl_typ.h>
 #include <openssl/dh.h>
+#include <openssl/ec.h>
 #include <openssl/bn.h>
+#include <openssl/crypto.h>
 #include <openssl/evp.h>
 #include <openssl/sha.h>
 #include <openssl/hmac.h>
 #include <openssl/rsa.h>
 
 #include <diffiehellman_implementation.h>
+#include "../Statistics.h"
 #include "Vault.h"
 #include "Derive.h"
 
+#include <list>
+
 
 namespace Implementation {
 
@@ -192,7 +197,96 @@ public:
         }
     }
 
+    uint16_t Export(const uint32_t keyId, const uint16_t maxSize, uint8_t keyBuf[])
+    {
+        ASSERT(keyBuf != nullptr);
+
+        uint16_t result = 0;
+
+        const uint16_t keySize = _vault->Size(keyId, true);
+        if ((keySize == 0) || (keySize > maxSize)) {
+            TRACE_L1("Key 0x%08x does not exist or does not fit", keyId);
+        } else {
+            result = _vault->Export(keyId, keySize, keyBuf, true);
+        }
+
+        return (result);
+    }
+
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+    uint32_t Serialize(EVP_PKEY* key)
+    {
+        ASSERT(key != nullptr);
+
+        uint32_t result = 0;
+
+        const int derSize = i2d_PrivateKey(key, nullptr);
+
+        if ((derSize <= 0) || ((derSize + sizeof(ECKeyHeader)) >= USHRT_MAX)) {
+            TRACE_L1("Failed to encode the private key");
+        } else {
+            const uint16_t keySize = (sizeof(ECKeyHeader) + derSize);
+
+            uint8_t* keyBuf = reinterpret_cast<uint8_t*>(ALLOCA(keySize));
+            ASSERT(keyBuf != nullptr);
+
+            ECKeyHeader* header = reinterpret_cast<ECKeyHeader*>(keyBuf);
+            header->marker = 0;
+            header->type = static_cast<uint16_t>(EVP_PKEY_id(key));
+
+            uint8_t* der = header->data;
+            i2d_PrivateKey(key, &der);
+
+            result = _vault->Import(keySize, keyBuf, false /* EC private key always sealed */);
+
+            ::memset(keyBuf, 0xFF, keySize); // shred :)
+        }
+
+        return (result);
+    }
+
+    // Only picks up elliptic curve private keys, key stays nullptr for anything else (like a DH key).
+    void Deserialize(const uint32_t keyId, EVP_PKEY*& key)
+    {
+        ASSERT(key == nullptr);
+
+        uint16_t keySize = _vault->Size(keyId, true);
+        if ((keySize != 0) && (keySize != USHRT_MAX) && (keySize > sizeof(ECKeyHeader))) {
+            uint8_t* keyBuf = reinterpret_cast<uint8_t*>(ALLOCA(keySize));
+            ASSERT(keyBuf != nullptr);
+
+            keySize = _vault->Export(keyId, keySize, keyBuf, true);
+
+            const ECKeyHeader* header = reinterpret_cast<const ECKeyHeader*>(keyBuf);
+
+            if ((keySize > sizeof(ECKeyHeader)) && (header->marker == 0)) {
+                const uint8_t* der = header->data;
+                key = d2i_PrivateKey(header->type, nullptr, &der, (keySize - sizeof(ECKeyHeader)));
+
+                if (key == nullptr) {
+                    TRACE_L1("Failed to decode the private key 0x%08x", keyId);
+                }
+            }
+
+            ::memset(keyBuf, 0xFF, keySize); // shred :)
+        }
+    }
+#endif
+
 private:
+    // DH keys start off with the (never empty) prime size, elliptic curve keys with a zero marker instead
+    struct ECKeyHeader {
+        uint16_t marker;
+        uint16_t type;
+#ifdef __WINDOWS__
+#pragma warning(disable: 4200)
+#endif
+        uint8_t data[0];
+#ifdef __WINDOWS__
+#pragma warning(default: 4200)
+#endif
+    };
+
     struct DHKeyHeader {
         uint16_t primeSize;
         uint16_t generatorSize;
@@ -211,6 +305,228 @@ private:
     Implementation::Vault* _vault;
 }; //class KeyStore
 
+// Ephemeral key pairs generated ahead of time on a background thread, so a handshake does not have to wait for
+// the modular exponentiation. Only domain parameters that were requested (and validated) before are served, a
+// handful of pairs is kept per set and every pair is handed out once only.
+class KeyPairPool {
+public:
+    static constexpr uint8_t Depth = 2;
+    static constexpr uint8_t Domains = 4;
+
+private:
+    struct Domain {
+        std::string Parameters;
+        DH* Template;
+        std::list<DH*> Pairs;
+    };
+
+    class Minion : public WPEFramework::Core::Thread {
+    public:
+        Minion() = delete;
+        Minion(const Minion&) = delete;
+        Minion& operator=(const Minion&) = delete;
+
+        Minion(KeyPairPool& parent)
+            : WPEFramework::Core::Thread(WPEFramework::Core::Thread::DefaultStackSize(), _T("CryptographyKeyPairs"))
+            , _parent(parent)
+        {
+        }
+        ~Minion() override
+        {
+            Stop();
+            Wait(WPEFramework::Core::Thread::STOPPED, WPEFramework::Core::infinite);
+        }
+
+    private:
+        uint32_t Worker() override
+        {
+            return (_parent.Process(*this));
+        }
+
+    private:
+        KeyPairPool& _parent;
+    };
+
+public:
+    KeyPairPool(const KeyPairPool&) = delete;
+    KeyPairPool& operator=(const KeyPairPool&) = delete;
+
+    KeyPairPool()
+        : _lock()
+        , _domains()
+        , _worker(nullptr)
+    {
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+        // OpenSSL has to outlive the pool at exit
+        OPENSSL_init_crypto(0, nullptr);
+#endif
+    }
+
+    ~KeyPairPool()
+    {
+        if (_worker != nullptr) {
+            delete _worker;
+        }
+
+        for (Domain& domain : _domains) {
+            Clear(domain);
+        }
+    }
+
+    static KeyPairPool& Instance()
+    {
+        static KeyPairPool instance;
+        return (instance);
+    }
+
+public:
+    static std::string Parameters(const uint8_t generator, const uint16_t modulusSize, const uint8_t modulus[])
+    {
+        std::string result(1, static_cast<char>(generator));
+        result.append(reinterpret_cast<const char*>(modulus), modulusSize);
+        return (result);
+    }
+
+    // A ready key pair for these parameters, if any. Known tells if the parameters were validated before.
+    DH* Take(const std::string& parameters, bool& known)
+    {
+        DH* result = nullptr;
+
+        WPEFramework::Core::SafeSyncType<WPEFramework::Core::CriticalSection> lock(_lock);
+
+        std::list<Domain>::iterator index = Find(parameters);
+
+        known = (index != _domains.end());
+
+        if ((known == true) && (index->Pairs.empty() == false)) {
+            result = index->Pairs.front();
+            index->Pairs.pop_front();
+
+            // Top the set up again
+            _worker->Run();
+        }
+
+        return (result);
+    }
+
+    // Keep pairs ready for these (validated) parameters from now on, the least recently used set makes room.
+    void Register(const std::string& parameters, const DH* key)
+    {
+        WPEFramework::Core::SafeSyncType<WPEFramework::Core::CriticalSection> lock(_lock);
+
+        if (Find(parameters) == _domains.end()) {
+            DH* domainTemplate = DHparams_dup(key);
+
+            if (domainTemplate == nullptr) {
+                TRACE_L1("Failed to copy the DH parameters");
+            } else {
+                if (_domains.size() >= Domains) {
+                    Clear(_domains.back());
+                    _domains.pop_back();
+                }
+
+                _domains.push_front({ parameters, domainTemplate, std::list<DH*>() });
+
+                if (_worker == nullptr) {
+                    _worker = new Minion(*this);
+                }
+
+                _worker->Run();
+            }
+        }
+    }
+
+private:
+    std::list<Domain>::iterator Find(const std::string& parameters)
+    {
+        std::list<Domain>::iterator index = _domains.begin();
+
+        while ((index != _domains.end()) && (index->Parameters != parameters)) {
+            index++;
+        }
+
+        if ((index != _domains.end()) && (index != _domains.begin())) {
+            _domains.splice(_domains.begin(), _domains, index);
+            index = _domains.begin();
+        }
+
+        return (index);
+    }
+
+    static void Clear(Domain& domain)
+    {
+        for (DH* pair : domain.Pairs) {
+            DH_free(pair);
+        }
+
+        domain.Pairs.clear();
+
+        DH_free(domain.Template);
+        domain.Template = nullptr;
+    }
+
+    // Generates one pair for the first set that is not topped up yet, blocks the worker once all are
+    uint32_t Process(Minion& minion)
+    {
+        uint32_t result = 0;
+
+        _lock.Lock();
+
+        std::list<Domain>::iterator index = _domains.begin();
+
+        while ((index != _domains.end()) && (index->Pairs.size() >= Depth)) {
+            index++;
+        }
+
+        if (index == _domains.end()) {
+            // Until Take() or Register() makes room for another pair
+            minion.Block();
+            result = WPEFramework::Core::infinite;
+        } else {
+            const std::string parameters(index->Parameters);
+            DH* pair = DHparams_dup(index->Template);
+
+            _lock.Unlock();
+
+            if ((pair != nullptr) && (DH_generate_key(pair) == 0)) {
+                TRACE_L1("DH_generate_key() failed");
+                DH_free(pair);
+                pair = nullptr;
+            }
+
+            _lock.Lock();
+
+            // The set may have been evicted in the mean time
+            index = _domains.begin();
+
+            while ((index != _domains.end()) && (index->Parameters != parameters)) {
+                index++;
+            }
+
+            if (index == _domains.end()) {
+                if (pair != nullptr) {
+                    DH_free(pair);
+                }
+            } else if (pair != nullptr) {
+                index->Pairs.push_back(pair);
+            } else {
+                // Do not spin on parameters that keep failing
+                Clear(*index);
+                _domains.erase(index);
+            }
+        }
+
+        _lock.Unlock();
+
+        return (result);
+    }
+
+private:
+    WPEFramework::Core::CriticalSection _lock;
+    std::list<Domain> _domains;
+    Minion* _worker;
+};
+
 uint32_t GenerateDiffieHellmanKeys(KeyStore& store,
                                    const uint8_t generator, const uint16_t modulusSize, const uint8_t modulus[],
                                    uint32_t& privateKeyId, uint32_t& publicKeyId)
@@ -227,55 +543,73 @@ uint32_t GenerateDiffieHellmanKeys(KeyStore& store,
     TRACE_L2("Generator: %i", generator);
     TRACE_L2("Modulus: %02x %02x %02x... (%i bytes)", modulus[0], modulus[1], modulus[2], modulusSize);
 
-    DH* dh = DH_new();
-    ASSERT(dh != nullptr);
+    bool known = false;
+    const std::string parameters(KeyPairPool::Parameters(generator, modulusSize, modulus));
+
+    DH* dh = KeyPairPool::Instance().Take(parameters, known);
 
-    if (dh == nullptr) {
-        TRACE_L1("DH_new() failed");
+    if (dh != nullptr) {
+        TRACE_L2("Using a pre-generated key pair");
     } else {
+        dh = DH_new();
+        ASSERT(dh != nullptr);
+
+        if (dh == nullptr) {
+            TRACE_L1("DH_new() failed");
+        } else {
 #if OPENSSL_VERSION_NUMBER  >= 0x10100000L
-        BIGNUM* p = BN_bin2bn(modulus, modulusSize, NULL);
-        BIGNUM* g = BN_new();
-        ASSERT(p != nullptr);
-        ASSERT(g != nullptr);
+            BIGNUM* p = BN_bin2bn(modulus, modulusSize, NULL);
+            BIGNUM* g = BN_new();
+            ASSERT(p != nullptr);
+            ASSERT(g != nullptr);
 
-        BN_set_word(g, generator);
+            BN_set_word(g, generator);
 
-        if (DH_set0_pqg(dh, p, nullptr, g) == 0) {
-            ASSERT(false);
-        }
+            if (DH_set0_pqg(dh, p, nullptr, g) == 0) {
+                ASSERT(false);
+            }
 #else
-        dh->p = BN_bin2bn(modulus, modulusSize, NULL);
-        dh->g = BN_new();
-        ASSERT(dh->p != nullptr);
-        ASSERT(dh->g != nullptr);
+            dh->p = BN_bin2bn(modulus, modulusSize, NULL);
+            dh->g = BN_new();
+            ASSERT(dh->p != nullptr);
+            ASSERT(dh->g != nullptr);
 
-        BN_set_word(dh->g, generator);
+            BN_set_word(dh->g, generator);
 #endif
 
-        int codes = 0;
-        if ((DH_check(dh, &codes) == 0) || (codes != 0)) {
-            TRACE_L1("DH parameters are invalid [0x%08x]!", codes);
-        } else {
-            if (DH_generate_key(dh) == 0) {
-                TRACE_L1("DH_generate_key() failed");
+            // Checking the prime is costly as well, parameters known to the pool passed already
+            int codes = 0;
+            if ((known == false) && ((DH_check(dh, &codes) == 0) || (codes != 0))) {
+                TRACE_L1("DH parameters are invalid [0x%08x]!", codes);
+                DH_free(dh);
+                dh = nullptr;
             } else {
-                privateKeyId = store.Serialize(dh);
+                KeyPairPool::Instance().Register(parameters, dh);
+
+                if (DH_generate_key(dh) == 0) {
+                    TRACE_L1("DH_generate_key() failed");
+                    DH_free(dh);
+                    dh = nullptr;
+                }
+            }
+        }
+    }
+
+    if (dh != nullptr) {
+        privateKeyId = store.Serialize(dh);
 #if OPENSSL_VERSION_NUMBER  >= 0x10100000L
-                const BIGNUM* pub_key;
-                DH_get0_key(dh, &pub_key, nullptr);
-                publicKeyId = store.Serialize(pub_key, true /* public key shall not be sealed */);
+        const BIGNUM* pub_key;
+        DH_get0_key(dh, &pub_key, nullptr);
+        publicKeyId = store.Serialize(pub_key, true /* public key shall not be sealed */);
 #else
-                publicKeyId = store.Serialize(dh->pub_key, true /* public key shall not be sealed */);
+        publicKeyId = store.Serialize(dh->pub_key, true /* public key shall not be sealed */);
 #endif
 
-                ASSERT(privateKeyId != 0);
-                ASSERT(publicKeyId != 0);
+        ASSERT(privateKeyId != 0);
+        ASSERT(publicKeyId != 0);
 
-                if ((privateKeyId != 0) && (publicKeyId != 0)) {
-                    result = 0;
-                }
-            }
+        if ((privateKeyId != 0) && (publicKeyId != 0)) {
+            result = 0;
         }
 
         DH_free(dh);
@@ -310,7 +644,178 @@ void DiffieHellmanDeriveSecret(DH* privateKey, const BIGNUM* peerPublicKey, BIGN
     }
 }
 
-uint32_t DiffieHellmanDeriveSecret(KeyStore& store, const uint32_t privateKeyId, const uint32_t peerPublicKeyId, uint32_t& secretId)
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+
+uint32_t GenerateEllipticCurveKeys(KeyStore& store, const curve_type curve, uint32_t& privateKeyId, uint32_t& publicKeyId)
+{
+    uint32_t result = -1;
+
+    privateKeyId = 0;
+    publicKeyId = 0;
+
+    EVP_PKEY_CTX* context = nullptr;
+
+    switch (curve) {
+    case curve_type::CURVE_X25519:
+        context = EVP_PKEY_CTX_new_id(EVP_PKEY_X25519, nullptr);
+        if ((context != nullptr) && (EVP_PKEY_keygen_init(context) <= 0)) {
+            EVP_PKEY_CTX_free(context);
+            context = nullptr;
+        }
+        break;
+    case curve_type::CURVE_P256:
+        context = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr);
+        if ((context != nullptr) && ((EVP_PKEY_keygen_init(context) <= 0) || (EVP_PKEY_CTX_set_ec_paramgen_curve_nid(context, NID_X9_62_prime256v1) <= 0))) {
+            EVP_PKEY_CTX_free(context);
+            context = nullptr;
+        }
+        break;
+    default:
+        TRACE_L1("Curve %i not supported", curve);
+        break;
+    }
+
+    EVP_PKEY* key = nullptr;
+
+    if (context == nullptr) {
+        TRACE_L1("Failed to set up key generation for curve %i", curve);
+    } else if (EVP_PKEY_keygen(context, &key) <= 0) {
+        TRACE_L1("EVP_PKEY_keygen() failed");
+    } else {
+        // The raw public key is what goes over the wire
+        uint8_t publicKey[65];
+        size_t publicKeySize = 0;
+
+        if (curve == curve_type::CURVE_X25519) {
+            publicKeySize = sizeof(publicKey);
+            if (EVP_PKEY_get_raw_public_key(key, publicKey, &publicKeySize) <= 0) {
+                publicKeySize = 0;
+            }
+        } else {
+            const EC_KEY* ecKey = EVP_PKEY_get0_EC_KEY(key);
+            if (ecKey != nullptr) {
+                publicKeySize = EC_POINT_point2oct(EC_KEY_get0_group(ecKey), EC_KEY_get0_public_key(ecKey), POINT_CONVERSION_UNCOMPRESSED,
+                    publicKey, sizeof(publicKey), nullptr);
+            }
+        }
+
+        if (publicKeySize == 0) {
+            TRACE_L1("Failed to retrieve the public key");
+        } else {
+            privateKeyId = store.Serialize(key);
+            publicKeyId = store.Serialize(publicKey, publicKeySize, true /* public key shall not be sealed */);
+
+            ASSERT(privateKeyId != 0);
+            ASSERT(publicKeyId != 0);
+
+            if ((privateKeyId != 0) && (publicKeyId != 0)) {
+                TRACE_L2("Generated elliptic curve keys (private: 0x%08x, public: 0x%08x)", privateKeyId, publicKeyId);
+                result = 0;
+            }
+        }
+
+        EVP_PKEY_free(key);
+    }
+
+    if (context != nullptr) {
+        EVP_PKEY_CTX_free(context);
+    }
+
+    return (result);
+}
+
+EVP_PKEY* EllipticCurvePeerKey(KeyStore& store, const int type, const uint32_t peerPublicKeyId)
+{
+    EVP_PKEY* result = nullptr;
+
+    uint8_t peerKey[65];
+    const uint16_t peerKeySize = store.Export(peerPublicKeyId, sizeof(peerKey), peerKey);
+
+    if (type == EVP_PKEY_X25519) {
+        result = EVP_PKEY_new_raw_public_key(EVP_PKEY_X25519, nullptr, peerKey, peerKeySize);
+    } else if (type == EVP_PKEY_EC) {
+        EC_KEY* ecKey = EC_KEY_new_by_curve_name(NID_X9_62_prime256v1);
+        EC_POINT* point = (ecKey != nullptr ? EC_POINT_new(EC_KEY_get0_group(ecKey)) : nullptr);
+
+        // Only accept points that are on the curve
+        if ((point != nullptr)
+            && (EC_POINT_oct2point(EC_KEY_get0_group(ecKey), point, peerKey, peerKeySize, nullptr) != 0)
+            && (EC_KEY_set_public_key(ecKey, point) != 0)
+            && (EC_KEY_check_key(ecKey) != 0)) {
+
+            result = EVP_PKEY_new();
+            ASSERT(result != nullptr);
+
+            if (EVP_PKEY_assign_EC_KEY(result, ecKey) != 0) {
+                ecKey = nullptr;
+            } else {
+                EVP_PKEY_free(result);
+                result = nullptr;
+            }
+        }
+
+        if (point != nullptr) {
+            EC_POINT_free(point);
+        }
+        if (ecKey != nullptr) {
+            EC_KEY_free(ecKey);
+        }
+    }
+
+    if (result == nullptr) {
+        TRACE_L1("Peer public key 0x%08x is invalid", peerPublicKeyId);
+    }
+
+    return (result);
+}
+
+uint32_t EllipticCurveDeriveSecret(KeyStore& store, EVP_PKEY* privateKey, const uint32_t peerPublicKeyId, uint32_t& secretId)
+{
+    uint32_t result = -1;
+
+    EVP_PKEY* peerKey = EllipticCurvePeerKey(store, EVP_PKEY_id(privateKey), peerPublicKeyId);
+
+    if (peerKey != nullptr) {
+        EVP_PKEY_CTX* context = EVP_PKEY_CTX_new(privateKey, nullptr);
+        size_t secretSize = 0;
+
+        if ((context == nullptr)
+            || (EVP_PKEY_derive_init(context) <= 0)
+            || (EVP_PKEY_derive_set_peer(context, peerKey) <= 0)
+            || (EVP_PKEY_derive(context, nullptr, &secretSize) <= 0)) {
+            TRACE_L1("Failed to set up the key agreement");
+        } else {
+            uint8_t* secretBuf = reinterpret_cast<uint8_t*>(ALLOCA(secretSize));
+            ASSERT(secretBuf != nullptr);
+
+            if (EVP_PKEY_derive(context, secretBuf, &secretSize) <= 0) {
+                TRACE_L1("EVP_PKEY_derive() failed");
+            } else {
+                secretId = store.Serialize(secretBuf, secretSize);
+                if (secretId == 0) {
+                    TRACE_L1("Failed to store computed elliptic curve secret");
+                } else {
+                    TRACE_L2("Computed elliptic curve secret as 0x%08x", secretId);
+                    result = 0;
+                }
+            }
+
+            ::memset(secretBuf, 0xFF, secretSize); // shred :)
+        }
+
+        if (context != nullptr) {
+            EVP_PKEY_CTX_free(context);
+        }
+
+        EVP_PKEY_free(peerKey);
+    }
+
+    return (result);
+}
+
+#endif // OPENSSL_VERSION_NUMBER >= 0x10101000L
+
+uint32_t FiniteFieldDeriveSecret(KeyStore& store, const uint32_t privateKeyId, const uint32_t peerPublicKeyId, uint32_t& secretId)
 {
     uint32_t result = -1;
 
@@ -355,6 +860,28 @@ uint32_t DiffieHellmanDeriveSecret(KeyStore& store, const uint32_t privateKeyId,
     return (result);
 }
 
+uint32_t DiffieHellmanDeriveSecret(KeyStore& store, const uint32_t privateKeyId, const uint32_t peerPublicKeyId, uint32_t& secretId)
+{
+    uint32_t result = -1;
+    bool derived = false;
+
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+    EVP_PKEY* ecPrivateKey = nullptr;
+    store.Deserialize(privateKeyId, ecPrivateKey);
+
+    if (ecPrivateKey != nullptr) {
+        result = EllipticCurveDeriveSecret(store, ecPrivateKey, peerPublicKeyId, secretId);
+        EVP_PKEY_free(ecPrivateKey);
+        derived = true;
+    }
+#endif
+
+    if (derived == false) {
+        result = FiniteFieldDeriveSecret(store, privateKeyId, peerPublicKeyId, secretId);
+    }
+
+    return (result);
+}
 
 namespace Netflix {
 
@@ -483,15 +1010,37 @@ uint32_t diffiehellman_generate(struct VaultImplementation* vault,
     ASSERT(private_key_id != nullptr);
     ASSERT(public_key_id != nullptr);
 
+    Implementation::Statistics::Scope scope(CRYPTOGRAPHY_OPERATION_DH_GENERATE, 0, 0, modulusSize);
+
     Implementation::KeyStore store(reinterpret_cast<Implementation::Vault*>(vault));
     return (Implementation::GenerateDiffieHellmanKeys(store, generator, modulusSize, modulus, (*private_key_id), (*public_key_id)));
 }
 
+uint32_t diffiehellman_generate_ec(struct VaultImplementation* vault, const curve_type curve,
+                                   uint32_t* private_key_id, uint32_t* public_key_id)
+{
+    ASSERT(vault != nullptr);
+    ASSERT(private_key_id != nullptr);
+    ASSERT(public_key_id != nullptr);
+
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+    Implementation::Statistics::Scope scope(CRYPTOGRAPHY_OPERATION_DH_GENERATE, static_cast<uint8_t>(curve + 1));
+
+    Implementation::KeyStore store(reinterpret_cast<Implementation::Vault*>(vault));
+    return (Implementation::GenerateEllipticCurveKeys(store, curve, (*private_key_id), (*public_key_id)));
+#else
+    TRACE_L1("Elliptic curve key agreement requires OpenSSL 1.1.1 or newer");
+    return (-1);
+#endif
+}
+
 uint32_t diffiehellman_derive(struct VaultImplementation* vault, const uint32_t private_key_id, const uint32_t peer_public_key_id, uint32_t* secret_id)
 {
     ASSERT(vault != nullptr);
     ASSERT(secret_id != nullptr);
 
+    Implementation::Statistics::Scope scope(CRYPTOGRAPHY_OPERATION_DH_DERIVE, 0);
+
     Implementation::KeyStore store(reinterpret_cast<Implementation::Vault*>(vault));
     return (Implementation::DiffieHellmanDeriveSecret(store, private_key_id, peer_public_key_id, (*secret_id)));
 }
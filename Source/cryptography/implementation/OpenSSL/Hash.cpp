@@ -28,12 +28,20 @@
 #include <openssl/hmac.h>
 #include <openssl/evp.h>
 
+#include <algorithm>
+#include <list>
+#include <map>
+
+#include "../Statistics.h"
 #include "Vault.h"
 
 
 struct HashImplementation {
     virtual uint32_t Ingest(const uint32_t length, const uint8_t data[]) = 0;
     virtual uint8_t Calculate(const uint8_t maxLength, uint8_t data[]) = 0;
+    virtual uint16_t Batch(const uint16_t count, const uint32_t inputLength, const uint8_t input[],
+                           const uint32_t maxOutputLength, uint8_t output[]) = 0;
+    virtual uint32_t Reset() = 0;
 
     virtual ~HashImplementation() { }
 };
@@ -73,8 +81,10 @@ namespace Operation {
     // Wrappers to get around different function names for digest and HMAC calculation.
 
     struct Digest {
+        static constexpr cryptographyoperation Statistic = CRYPTOGRAPHY_OPERATION_HASH;
+
         static int Init(EVP_MD_CTX* ctx, EVP_PKEY_CTX **pctx, const EVP_MD *type, EVP_PKEY *pkey) {
-            return (1);
+            return (EVP_DigestInit_ex(ctx, type, nullptr));
         }
         static int Update(EVP_MD_CTX* ctx, const void* d, size_t cnt) {
             return (EVP_DigestUpdate(ctx, d, cnt));
@@ -88,6 +98,8 @@ namespace Operation {
     };
 
     struct HMAC {
+        static constexpr cryptographyoperation Statistic = CRYPTOGRAPHY_OPERATION_HMAC;
+
         static int Init(EVP_MD_CTX* ctx, EVP_PKEY_CTX **pctx, const EVP_MD *type, EVP_PKEY *pkey) {
             return (EVP_DigestSignInit(ctx, pctx, type, nullptr, pkey));
         }
@@ -101,6 +113,144 @@ namespace Operation {
 
 } // namespace Operation
 
+// Setting up a keyed context means exporting the secret from the vault and running the HMAC key
+// schedule. That is done once per vault, key and digest, new HMAC calculators start off from a copy.
+// The vault drops the contexts of a key as soon as the key is deleted (see Evict()).
+class KeyContextCache {
+private:
+    static constexpr uint8_t MAX_ENTRIES = 32;
+
+    struct Entry {
+        const Implementation::Vault* Vault;
+        const EVP_MD* Digest;
+        uint32_t KeyId;
+        EVP_MD_CTX* Context;
+    };
+
+    KeyContextCache()
+        : _lock()
+        , _entries()
+    {
+    }
+
+public:
+    KeyContextCache(const KeyContextCache&) = delete;
+    KeyContextCache& operator=(const KeyContextCache&) = delete;
+
+    ~KeyContextCache()
+    {
+        for (Entry& entry : _entries) {
+            EVP_MD_CTX_destroy(entry.Context);
+        }
+    }
+
+    static KeyContextCache& Instance()
+    {
+        static KeyContextCache instance;
+        return (instance);
+    }
+
+public:
+    bool Clone(const Implementation::Vault* vault, const EVP_MD* digest, const uint32_t keyId, const uint16_t keyLength, EVP_MD_CTX* context)
+    {
+        bool result = false;
+
+        ASSERT(vault != nullptr);
+        ASSERT(context != nullptr);
+
+        // Held while preparing as well, so a key deleted meanwhile is evicted after it got in
+        WPEFramework::Core::SafeSyncType<WPEFramework::Core::CriticalSection> lock(_lock);
+
+        auto entry = std::find_if(_entries.begin(), _entries.end(), [&](const Entry& element) {
+            return ((element.Vault == vault) && (element.Digest == digest) && (element.KeyId == keyId));
+        });
+
+        EVP_MD_CTX* prepared = nullptr;
+
+        if (entry != _entries.end()) {
+            _entries.splice(_entries.begin(), _entries, entry);
+            prepared = entry->Context;
+        } else {
+            prepared = Prepare(vault, digest, keyId, keyLength);
+
+            if (prepared != nullptr) {
+                _entries.push_front({ vault, digest, keyId, prepared });
+
+                if (_entries.size() > MAX_ENTRIES) {
+                    EVP_MD_CTX_destroy(_entries.back().Context);
+                    _entries.pop_back();
+                }
+            }
+        }
+
+        if (prepared != nullptr) {
+            result = (EVP_MD_CTX_copy_ex(context, prepared) != 0);
+        }
+
+        return (result);
+    }
+
+    void Evict(const Implementation::Vault* vault, const uint32_t keyId)
+    {
+        WPEFramework::Core::SafeSyncType<WPEFramework::Core::CriticalSection> lock(_lock);
+
+        auto entry = _entries.begin();
+
+        while (entry != _entries.end()) {
+            if ((entry->Vault == vault) && (entry->KeyId == keyId)) {
+                EVP_MD_CTX_destroy(entry->Context);
+                entry = _entries.erase(entry);
+            } else {
+                ++entry;
+            }
+        }
+    }
+
+private:
+    EVP_MD_CTX* Prepare(const Implementation::Vault* vault, const EVP_MD* digest, const uint32_t keyId, const uint16_t keyLength) const
+    {
+        EVP_MD_CTX* context = nullptr;
+
+        uint8_t* secret = reinterpret_cast<uint8_t*>(ALLOCA(keyLength));
+        ASSERT(secret != nullptr);
+
+        uint16_t secretLen = vault->Export(keyId, keyLength, secret, true);
+        ASSERT(secretLen != 0);
+
+        if (secretLen != 0) {
+            EVP_PKEY* pkey = EVP_PKEY_new_mac_key(EVP_PKEY_HMAC, nullptr, secret, secretLen);
+            ASSERT(pkey != nullptr);
+
+            ::memset(secret, 0xFF, secretLen);
+
+            if (pkey != nullptr) {
+                context = EVP_MD_CTX_create();
+                ASSERT(context != nullptr);
+
+                if (Operation::HMAC::Init(context, nullptr, digest, pkey) == 0) {
+                    TRACE_L1("Init() failed");
+                    EVP_MD_CTX_destroy(context);
+                    context = nullptr;
+                }
+
+                // The context holds its own reference
+                EVP_PKEY_free(pkey);
+            }
+        }
+
+        return (context);
+    }
+
+private:
+    WPEFramework::Core::CriticalSection _lock;
+    std::list<Entry> _entries;
+};
+
+void EvictKey(const Vault* vault, const uint32_t keyId)
+{
+    KeyContextCache::Instance().Evict(vault, keyId);
+}
+
 template<typename OPERATION>
 class HashType : public HashImplementation {
 public:
@@ -109,8 +259,8 @@ public:
 
     HashType(const EVP_MD* digest)
         : _ctx(nullptr)
-        , _pkey(nullptr)
-        , _vault(nullptr)
+        , _initial(nullptr)
+        , _batchCtx(nullptr)
         , _size(0)
         , _failure(false)
     {
@@ -119,41 +269,38 @@ public:
         _ctx = EVP_MD_CTX_create();
         ASSERT(_ctx != nullptr);
 
-        if (EVP_DigestInit_ex(_ctx, digest, NULL) == 0) {
-            TRACE_L1("EVP_DigestInit_ex() failed");
+        if (OPERATION::Init(_ctx, nullptr, digest, nullptr) == 0) {
+            TRACE_L1("Init() failed");
             _failure = true;
         } else {
             _size = EVP_MD_size(digest);
             ASSERT(_size != 0);
+            Keep();
         }
     }
 
     HashType(const Implementation::Vault* vault, const EVP_MD* digest, const uint32_t secretId, const uint16_t secretLength)
-        : HashType(digest)
+        : _ctx(nullptr)
+        , _initial(nullptr)
+        , _batchCtx(nullptr)
+        , _size(0)
+        , _failure(false)
     {
         ASSERT(vault != nullptr);
+        ASSERT(digest != nullptr);
         ASSERT(secretId != 0);
         ASSERT(secretLength != 0);
-        _vault = vault;
-
-        if (_failure == false) {
-            uint8_t* secret = reinterpret_cast<uint8_t*>(ALLOCA(secretLength));
-            ASSERT(secret != nullptr);
 
-            uint16_t secretLen = _vault->Export(secretId, secretLength, secret, true);
-            ASSERT(secretLen != 0);
-
-            if (secretLen != 0) {
-                _pkey = EVP_PKEY_new_mac_key(EVP_PKEY_HMAC, nullptr, secret, secretLen);
-                ASSERT(_pkey != nullptr);
-
-                ::memset(secret, 0xFF, secretLen);
+        _ctx = EVP_MD_CTX_create();
+        ASSERT(_ctx != nullptr);
 
-                if (OPERATION::Init(_ctx, nullptr, digest, _pkey) == 0) {
-                    TRACE_L1("Init() failed");
-                    _failure = true;
-                }
-            }
+        if (KeyContextCache::Instance().Clone(vault, digest, secretId, secretLength, _ctx) == false) {
+            TRACE_L1("Failed to set up a keyed context for secret id 0x%08x", secretId);
+            _failure = true;
+        } else {
+            _size = EVP_MD_size(digest);
+            ASSERT(_size != 0);
+            Keep();
         }
     }
 
@@ -162,11 +309,19 @@ public:
         if (_ctx != nullptr) {
             EVP_MD_CTX_destroy(_ctx);
         }
+        if (_initial != nullptr) {
+            EVP_MD_CTX_destroy(_initial);
+        }
+        if (_batchCtx != nullptr) {
+            EVP_MD_CTX_destroy(_batchCtx);
+        }
     }
 
 public:
     uint32_t Ingest(const uint32_t length, const uint8_t* data) override
     {
+        Statistics::Scope scope(OPERATION::Statistic, _size, 0, length);
+
         ASSERT(data != nullptr);
 
         if (_failure == false) {
@@ -204,14 +359,203 @@ public:
         return (result);
     }
 
+    uint16_t Batch(const uint16_t count, const uint32_t inputLength, const uint8_t input[],
+                   const uint32_t maxOutputLength, uint8_t output[]) override
+    {
+        uint16_t result = 0;
+        uint32_t offset = 0;
+
+        Statistics::Scope scope(OPERATION::Statistic, _size, 0, inputLength);
+
+        ASSERT(input != nullptr);
+        ASSERT(output != nullptr);
+
+        if (_initial == nullptr) {
+            TRACE_L1("Hash calculation failure");
+        } else if (maxOutputLength < (static_cast<uint32_t>(count) * _size)) {
+            TRACE_L1("Output buffer to small, need %i bytes, got %i bytes", (count * _size), maxOutputLength);
+        } else {
+            if (_batchCtx == nullptr) {
+                _batchCtx = EVP_MD_CTX_create();
+                ASSERT(_batchCtx != nullptr);
+            }
+
+            // All messages start off from a copy of the initial (keyed) state.
+            while ((result < count) && ((inputLength - offset) >= sizeof(uint32_t))) {
+                uint32_t length;
+                ::memcpy(&length, (input + offset), sizeof(length));
+                offset += sizeof(length);
+
+                size_t len = _size;
+
+                if ((length > (inputLength - offset))
+                    || (EVP_MD_CTX_copy_ex(_batchCtx, _initial) == 0)
+                    || (OPERATION::Update(_batchCtx, (input + offset), length) == 0)
+                    || (OPERATION::Final(_batchCtx, (output + (result * _size)), &len) == 0)) {
+                    TRACE_L1("Failed to calculate hash %i of the batch", result);
+                    break;
+                }
+
+                ASSERT(len == _size);
+                offset += length;
+                result++;
+            }
+
+            TRACE_L2("Calculated %i of %i hashes in the batch", result, count);
+        }
+
+        return (result);
+    }
+
+    uint32_t Reset() override
+    {
+        uint32_t result = WPEFramework::Core::ERROR_GENERAL;
+
+        // Rewind to the initial (keyed) state, so the object can be reused for the next message.
+        if (_initial == nullptr) {
+            TRACE_L1("Hash calculation failure");
+        } else if (EVP_MD_CTX_copy_ex(_ctx, _initial) == 0) {
+            TRACE_L1("Failed to restore the initial hash state");
+            _failure = true;
+        } else {
+            _failure = false;
+            result = WPEFramework::Core::ERROR_NONE;
+        }
+
+        return (result);
+    }
+
+private:
+    void Keep()
+    {
+        // Remember the pristine state, to start new calculations from.
+        _initial = EVP_MD_CTX_create();
+        ASSERT(_initial != nullptr);
+
+        if (EVP_MD_CTX_copy_ex(_initial, _ctx) == 0) {
+            TRACE_L1("Failed to copy the initial hash context");
+            EVP_MD_CTX_destroy(_initial);
+            _initial = nullptr;
+        }
+    }
+
 private:
     EVP_MD_CTX* _ctx;
-    EVP_PKEY* _pkey;
-    const Implementation::Vault* _vault;
+    EVP_MD_CTX* _initial;
+    EVP_MD_CTX* _batchCtx;
     uint16_t _size;
     bool _failure;
 };
 
+// HKDF as per RFC 5869, the secret never leaves this function other than as sealed vault blobs.
+uint32_t DeriveKeys(Implementation::Vault* vault, const EVP_MD* digest, const uint32_t secretId,
+                    const uint16_t saltLength, const uint8_t salt[], const uint16_t infoLength, const uint8_t info[],
+                    const uint8_t count, const uint16_t keyLengths[], uint32_t keyIds[])
+{
+    ASSERT(vault != nullptr);
+    ASSERT(digest != nullptr);
+    ASSERT((count == 0) || ((keyLengths != nullptr) && (keyIds != nullptr)));
+
+    uint32_t result = WPEFramework::Core::ERROR_GENERAL;
+
+    const uint8_t hashSize = EVP_MD_size(digest);
+    const uint16_t secretLength = vault->Size(secretId, true);
+
+    // The keys are consecutive pieces of the output keying material
+    uint32_t okmLength = 0;
+    bool empty = (count == 0);
+
+    for (uint8_t index = 0; index < count; index++) {
+        okmLength += keyLengths[index];
+        empty = (empty || (keyLengths[index] == 0));
+    }
+
+    if ((empty == true) || (okmLength > (255 * hashSize))) {
+        TRACE_L1("Invalid derived key lengths, %i keys of %i bytes in total", count, okmLength);
+        result = WPEFramework::Core::ERROR_BAD_REQUEST;
+    } else if (secretLength == 0) {
+        TRACE_L1("Failed to retrieve secret id 0x%08x", secretId);
+        result = WPEFramework::Core::ERROR_UNKNOWN_KEY;
+    } else {
+        static const uint8_t zeros[EVP_MAX_MD_SIZE] = { 0 };
+
+        uint8_t* secret = reinterpret_cast<uint8_t*>(ALLOCA(secretLength));
+        uint8_t* okm = reinterpret_cast<uint8_t*>(ALLOCA(okmLength));
+        uint8_t* block = reinterpret_cast<uint8_t*>(ALLOCA(hashSize + infoLength + 1));
+        uint8_t prk[EVP_MAX_MD_SIZE];
+        uint32_t prkLength = 0;
+
+        if (vault->Export(secretId, secretLength, secret, true) != secretLength) {
+            TRACE_L1("Failed to export secret id 0x%08x", secretId);
+        } else if (::HMAC(digest, (saltLength != 0 ? salt : zeros), (saltLength != 0 ? saltLength : hashSize),
+                          secret, secretLength, prk, &prkLength) == nullptr) {
+            // No salt means a string of zeros the length of the hash
+            TRACE_L1("HKDF extract failed");
+        } else {
+            // The block holds T(i - 1) | info | i, T(0) being empty
+            uint32_t offset = 0;
+            uint8_t counter = 1;
+            bool failed = false;
+
+            if (infoLength != 0) {
+                ::memcpy(block + hashSize, info, infoLength);
+            }
+
+            while ((offset < okmLength) && (failed == false)) {
+                const uint8_t* data = (counter == 1 ? (block + hashSize) : block);
+                const uint32_t dataLength = ((counter == 1 ? 0 : hashSize) + infoLength + 1);
+                uint32_t length = 0;
+
+                block[hashSize + infoLength] = counter;
+
+                if (::HMAC(digest, prk, prkLength, data, dataLength, block, &length) == nullptr) {
+                    failed = true;
+                } else {
+                    const uint32_t chunk = std::min((okmLength - offset), length);
+                    ::memcpy(okm + offset, block, chunk);
+                    offset += chunk;
+                    counter++;
+                }
+            }
+
+            if (failed == true) {
+                TRACE_L1("HKDF expand failed");
+            } else {
+                uint8_t index = 0;
+
+                offset = 0;
+
+                // Derived keys are always sealed
+                while ((index < count) && ((keyIds[index] = vault->Import(keyLengths[index], (okm + offset), false)) != 0)) {
+                    offset += keyLengths[index];
+                    index++;
+                }
+
+                if (index == count) {
+                    result = WPEFramework::Core::ERROR_NONE;
+                } else {
+                    TRACE_L1("Failed to store derived key %i of %i", (index + 1), count);
+
+                    while (index > 0) {
+                        index--;
+                        vault->Delete(keyIds[index]);
+                        keyIds[index] = 0;
+                    }
+                }
+            }
+
+            // shred :)
+            ::memset(prk, 0xFF, sizeof(prk));
+            ::memset(block, 0xFF, (hashSize + infoLength + 1));
+            ::memset(okm, 0xFF, okmLength);
+        }
+
+        ::memset(secret, 0xFF, secretLength);
+    }
+
+    return (result);
+}
+
 } // namespace Implementation
 
 extern "C" {
@@ -265,4 +609,62 @@ uint8_t hash_calculate(HashImplementation* hash, const uint8_t max_length, uint8
     return (hash->Calculate(max_length, data));
 }
 
+uint16_t hash_batch(HashImplementation* hash, const uint16_t count, const uint32_t input_length, const uint8_t input[],
+                    const uint32_t max_output_length, uint8_t output[])
+{
+    ASSERT(hash != nullptr);
+    return (hash->Batch(count, input_length, input, max_output_length, output));
+}
+
+uint32_t hash_reset(HashImplementation* hash)
+{
+    ASSERT(hash != nullptr);
+    return (hash->Reset());
+}
+
+bool hash_verify(HashImplementation* hash, const uint8_t length, const uint8_t expected[])
+{
+    ASSERT(hash != nullptr);
+    ASSERT(expected != nullptr);
+
+    bool result = false;
+    uint8_t digest[EVP_MAX_MD_SIZE];
+
+    const uint8_t size = hash->Calculate(sizeof(digest), digest);
+
+    // Truncated values are accepted down to half of the digest size (RFC 2104)
+    if ((size == 0) || (length > size) || ((length * 2) < size)) {
+        TRACE_L1("Can't verify a %i byte value against a %i byte digest", length, size);
+    } else {
+        result = (CRYPTO_memcmp(digest, expected, length) == 0);
+    }
+
+    return (result);
+}
+
+uint32_t hash_derive_keys(VaultImplementation* vault, const hash_type type, const uint32_t secret_id,
+                          const uint16_t salt_length, const uint8_t salt[], const uint16_t info_length, const uint8_t info[],
+                          const uint8_t count, const uint16_t key_lengths[], uint32_t key_ids[])
+{
+    ASSERT(vault != nullptr);
+    Implementation::Vault *vaultImpl = reinterpret_cast<Implementation::Vault*>(vault);
+    uint32_t result = WPEFramework::Core::ERROR_NOT_SUPPORTED;
+
+    const EVP_MD* md = Implementation::Algorithm(type);
+
+    uint32_t length = 0;
+    for (uint8_t index = 0; index < count; index++) {
+        length += key_lengths[index];
+        key_ids[index] = 0;
+    }
+
+    Implementation::Statistics::Scope scope(CRYPTOGRAPHY_OPERATION_KEY_DERIVE, (md != nullptr ? static_cast<uint8_t>(EVP_MD_size(md)) : 0), 0, length);
+
+    if (md != nullptr) {
+        result = Implementation::DeriveKeys(vaultImpl, md, secret_id, salt_length, salt, info_length, info, count, key_lengths, key_ids);
+    }
+
+    return (result);
+}
+
 } // extern "C"
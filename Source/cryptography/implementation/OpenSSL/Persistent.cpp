@@ -0,0 +1,505 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 Metrological
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../../Module.h"
+
+#include <persistent_implementation.h>
+#include <vault_implementation.h>
+
+#include <openssl/rand.h>
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include "Storage.h"
+#include "Vault.h"
+
+namespace Implementation {
+
+// Keys created through IPersistent are kept in a single file, in the very same sealed form the vault
+// holds them in memory. The file is mapped read-only and starts with an index sorted on the hash of
+// the locators, so loading a key is a binary search and a copy of the sealed blob into the vault; it
+// is only unsealed once an operation actually uses it. New keys are collected in memory and written
+// out in one go on Flush(), by replacing the whole file. The file is private to the user running the
+// library, a store that is not is ignored.
+class Persistent {
+private:
+    static constexpr uint32_t MAGIC = 0x53504354; // "TCPS"
+    static constexpr uint16_t VERSION = 1;
+    static constexpr uint8_t MAX_SEALED_SIZE = 64;
+
+#pragma pack(push, 1)
+    struct Header {
+        uint32_t Magic;
+        uint16_t Version;
+        uint16_t Count;
+    };
+
+    struct Index {
+        uint32_t Hash;
+        uint32_t Offset;
+    };
+
+    struct Record {
+        uint8_t Type;
+        uint8_t LocatorLength;
+        uint16_t BlobLength;
+    };
+#pragma pack(pop)
+
+    struct Entry {
+        key_type Type;
+        std::vector<uint8_t> Blob;
+    };
+
+public:
+    Persistent() = delete;
+    Persistent(const Persistent&) = delete;
+    Persistent& operator=(const Persistent&) = delete;
+
+    Persistent(Vault& vault, const string& path)
+        : _lock()
+        , _vault(vault)
+        , _path(path)
+        , _region(nullptr)
+        , _pending()
+        , _loaded()
+    {
+        Map();
+    }
+
+    ~Persistent()
+    {
+        Flush();
+
+        if (_region != nullptr) {
+            delete _region;
+        }
+    }
+
+    static Persistent& Instance()
+    {
+        static Persistent instance(Vault::PlatformInstance(), Path());
+        return (instance);
+    }
+
+public:
+    bool Exists(const string& locator) const
+    {
+        Entry entry;
+
+        _lock.Lock();
+        bool result = Lookup(locator, entry);
+        _lock.Unlock();
+
+        return (result);
+    }
+
+    uint32_t Load(const string& locator, uint32_t& id)
+    {
+        uint32_t result = WPEFramework::Core::ERROR_UNKNOWN_KEY;
+        Entry entry;
+
+        _lock.Lock();
+
+        auto loaded = _loaded.find(locator);
+
+        if ((loaded != _loaded.end()) && (_vault.Size(loaded->second, true) != 0)) {
+            id = loaded->second;
+            result = WPEFramework::Core::ERROR_NONE;
+        } else if (Lookup(locator, entry) == true) {
+            // Still sealed, the vault unseals it on use
+            id = _vault.Put(static_cast<uint16_t>(entry.Blob.size()), entry.Blob.data());
+
+            if (id != 0) {
+                _loaded[locator] = id;
+                result = WPEFramework::Core::ERROR_NONE;
+            } else {
+                result = WPEFramework::Core::ERROR_GENERAL;
+            }
+        } else {
+            TRACE_L1("Key '%s' not found in the persistent store", locator.c_str());
+        }
+
+        _lock.Unlock();
+
+        return (result);
+    }
+
+    uint32_t Create(const string& locator, const key_type type, uint32_t& id)
+    {
+        uint32_t result = WPEFramework::Core::ERROR_GENERAL;
+        const uint8_t length = KeyLength(type);
+
+        id = 0;
+
+        if ((locator.empty() == true) || (locator.size() > UCHAR_MAX) || (length == 0)) {
+            TRACE_L1("Invalid persistent key request for '%s'", locator.c_str());
+            result = WPEFramework::Core::ERROR_BAD_REQUEST;
+        } else {
+            uint8_t key[32];
+            uint8_t sealed[MAX_SEALED_SIZE];
+            uint16_t sealedSize = 0;
+
+            ASSERT(length <= sizeof(key));
+
+            if (RAND_bytes(key, length) != 1) {
+                TRACE_L1("Failed to generate a %i byte key", length);
+            } else {
+                id = _vault.Import(length, key, false /* persistent keys are never exportable */);
+
+                if (id != 0) {
+                    sealedSize = _vault.Get(id, sizeof(sealed), sealed);
+                }
+            }
+
+            // shred :)
+            ::memset(key, 0xFF, sizeof(key));
+
+            if (sealedSize != 0) {
+                _lock.Lock();
+
+                Entry& entry(_pending[locator]);
+                entry.Type = type;
+                entry.Blob.assign(sealed, sealed + sealedSize);
+                _loaded[locator] = id;
+
+                _lock.Unlock();
+
+                TRACE_L2("Created persistent key '%s' as id 0x%08x", locator.c_str(), id);
+                result = WPEFramework::Core::ERROR_NONE;
+            } else if (id != 0) {
+                _vault.Delete(id);
+                id = 0;
+            }
+        }
+
+        return (result);
+    }
+
+    uint32_t Flush()
+    {
+        uint32_t result = WPEFramework::Core::ERROR_NONE;
+
+        _lock.Lock();
+
+        if (_pending.empty() == false) {
+            std::map<string, Entry> records;
+
+            // Whatever is already on disk and was not replaced by a new key
+            if (_region != nullptr) {
+                const uint8_t* base = _region->Buffer();
+                const Index* index = reinterpret_cast<const Index*>(base + sizeof(Header));
+                const uint16_t count = reinterpret_cast<const Header*>(base)->Count;
+
+                for (uint16_t i = 0; i < count; i++) {
+                    const Record* record = reinterpret_cast<const Record*>(base + index[i].Offset);
+                    const uint8_t* data = reinterpret_cast<const uint8_t*>(record + 1);
+                    const string locator(reinterpret_cast<const char*>(data), record->LocatorLength);
+
+                    if (_pending.find(locator) == _pending.end()) {
+                        Entry& entry(records[locator]);
+                        entry.Type = static_cast<key_type>(record->Type);
+                        entry.Blob.assign(data + record->LocatorLength, data + record->LocatorLength + record->BlobLength);
+                    }
+                }
+            }
+
+            for (auto& entry : _pending) {
+                records[entry.first] = entry.second;
+            }
+
+            std::vector<uint8_t> image;
+
+            if (Serialize(records, image) == false) {
+                TRACE_L1("Too many keys for the persistent store");
+                result = WPEFramework::Core::ERROR_GENERAL;
+            } else if (_path.empty() == true) {
+                TRACE_L1("No location for the persistent store");
+                result = WPEFramework::Core::ERROR_OPENING_FAILED;
+            } else if (Storage::Write(_path, static_cast<uint32_t>(image.size()), image.data()) == false) {
+                TRACE_L1("Failed to write the persistent store %s", _path.c_str());
+                result = WPEFramework::Core::ERROR_WRITE_ERROR;
+            } else {
+                TRACE_L2("Flushed %i new keys, %i keys in the persistent store", static_cast<uint32_t>(_pending.size()), static_cast<uint32_t>(records.size()));
+                _pending.clear();
+                Map();
+            }
+        }
+
+        _lock.Unlock();
+
+        return (result);
+    }
+
+private:
+    static string Path()
+    {
+        string path;
+
+        if ((WPEFramework::Core::SystemInfo::GetEnvironment(_T("PERSISTENT_VAULT"), path) == false) || (path.empty() == true)) {
+            path = Storage::Location(_T("persistent.vault"));
+        }
+
+        return (path);
+    }
+
+    static uint8_t KeyLength(const key_type type)
+    {
+        uint8_t length = 0;
+
+        switch (type) {
+        case key_type::AES128:
+        case key_type::HMAC128:
+            length = 16;
+            break;
+        case key_type::HMAC160:
+            length = 20;
+            break;
+        case key_type::AES256:
+        case key_type::HMAC256:
+            length = 32;
+            break;
+        default:
+            TRACE_L1("Key type %i not supported", type);
+            break;
+        }
+
+        return (length);
+    }
+
+    // FNV-1a
+    static uint32_t Hash(const char locator[], const uint8_t length)
+    {
+        uint32_t hash = 0x811C9DC5;
+
+        for (uint8_t i = 0; i < length; i++) {
+            hash = ((hash ^ static_cast<uint8_t>(locator[i])) * 0x01000193);
+        }
+
+        return (hash);
+    }
+
+    bool Lookup(const string& locator, Entry& entry) const
+    {
+        bool found = false;
+
+        auto pending = _pending.find(locator);
+
+        if (pending != _pending.end()) {
+            entry = pending->second;
+            found = true;
+        } else if ((_region != nullptr) && (locator.size() <= UCHAR_MAX)) {
+            const uint8_t* base = _region->Buffer();
+            const Index* first = reinterpret_cast<const Index*>(base + sizeof(Header));
+            const Index* last = (first + reinterpret_cast<const Header*>(base)->Count);
+            const uint32_t hash = Hash(locator.c_str(), static_cast<uint8_t>(locator.size()));
+
+            auto index = std::lower_bound(first, last, hash, [](const Index& element, const uint32_t value) { return (element.Hash < value); });
+
+            while ((found == false) && (index != last) && (index->Hash == hash)) {
+                const Record* record = reinterpret_cast<const Record*>(base + index->Offset);
+                const uint8_t* data = reinterpret_cast<const uint8_t*>(record + 1);
+
+                if ((record->LocatorLength == locator.size()) && (::memcmp(data, locator.c_str(), record->LocatorLength) == 0)) {
+                    entry.Type = static_cast<key_type>(record->Type);
+                    entry.Blob.assign(data + record->LocatorLength, data + record->LocatorLength + record->BlobLength);
+                    found = true;
+                }
+
+                index++;
+            }
+        }
+
+        return (found);
+    }
+
+    static bool Serialize(const std::map<string, Entry>& records, std::vector<uint8_t>& image)
+    {
+        bool result = (records.size() <= USHRT_MAX);
+
+        if (result == true) {
+            const uint32_t offset = static_cast<uint32_t>(sizeof(Header) + (records.size() * sizeof(Index)));
+            std::vector<Index> index;
+
+            image.resize(offset);
+
+            for (auto& entry : records) {
+                Record record;
+                record.Type = static_cast<uint8_t>(entry.second.Type);
+                record.LocatorLength = static_cast<uint8_t>(entry.first.size());
+                record.BlobLength = static_cast<uint16_t>(entry.second.Blob.size());
+
+                index.push_back({ Hash(entry.first.c_str(), record.LocatorLength), static_cast<uint32_t>(image.size()) });
+
+                const uint8_t* raw = reinterpret_cast<const uint8_t*>(&record);
+                image.insert(image.end(), raw, raw + sizeof(record));
+                image.insert(image.end(), entry.first.begin(), entry.first.end());
+                image.insert(image.end(), entry.second.Blob.begin(), entry.second.Blob.end());
+            }
+
+            std::sort(index.begin(), index.end(), [](const Index& lhs, const Index& rhs) { return (lhs.Hash < rhs.Hash); });
+
+            Header* header = reinterpret_cast<Header*>(image.data());
+            header->Magic = MAGIC;
+            header->Version = VERSION;
+            header->Count = static_cast<uint16_t>(records.size());
+
+            if (index.empty() == false) {
+                ::memcpy(image.data() + sizeof(Header), index.data(), (index.size() * sizeof(Index)));
+            }
+        }
+
+        return (result);
+    }
+
+    // Map the store and check it once, so lookups can trust the offsets.
+    void Map()
+    {
+        if (_region != nullptr) {
+            delete _region;
+            _region = nullptr;
+        }
+
+        if ((_path.empty() == true) || (WPEFramework::Core::File(_path).Exists() == false)) {
+            TRACE_L2("No persistent store at %s", _path.c_str());
+        } else if (Storage::IsPrivate(_path) == false) {
+            // Someone else could have planted or read the keys
+            TRACE_L1("Persistent store %s is not owned by this user or accessible by others, ignoring it", _path.c_str());
+        } else {
+            WPEFramework::Core::DataElementFile* region = new WPEFramework::Core::DataElementFile(_path, WPEFramework::Core::File::USER_READ);
+            ASSERT(region != nullptr);
+
+            if (region->IsValid() == false) {
+                TRACE_L1("Failed to map the persistent store %s", _path.c_str());
+                delete region;
+            } else if (Validate(region->Buffer(), region->Size()) == false) {
+                TRACE_L1("Persistent store %s is corrupt, ignoring it", _path.c_str());
+                delete region;
+            } else {
+                _region = region;
+            }
+        }
+    }
+
+    static bool Validate(const uint8_t base[], const uint64_t size)
+    {
+        bool valid = (size >= sizeof(Header));
+
+        if (valid == true) {
+            const Header* header = reinterpret_cast<const Header*>(base);
+            const Index* index = reinterpret_cast<const Index*>(base + sizeof(Header));
+
+            valid = ((header->Magic == MAGIC) && (header->Version == VERSION) && (size >= (sizeof(Header) + (header->Count * sizeof(Index)))));
+
+            for (uint16_t i = 0; ((valid == true) && (i < header->Count)); i++) {
+                const uint64_t offset = index[i].Offset;
+
+                valid = ((offset + sizeof(Record)) <= size);
+
+                if (valid == true) {
+                    const Record* record = reinterpret_cast<const Record*>(base + offset);
+                    valid = (((offset + sizeof(Record) + record->LocatorLength + record->BlobLength) <= size)
+                        && (record->BlobLength != 0) && (record->BlobLength <= MAX_SEALED_SIZE)
+                        && (Hash(reinterpret_cast<const char*>(record + 1), record->LocatorLength) == index[i].Hash)
+                        && ((i == 0) || (index[i - 1].Hash <= index[i].Hash)));
+                }
+            }
+        }
+
+        return (valid);
+    }
+
+private:
+    mutable WPEFramework::Core::CriticalSection _lock;
+    Vault& _vault;
+    const string _path;
+    WPEFramework::Core::DataElementFile* _region;
+    std::map<string, Entry> _pending;
+    std::map<string, uint32_t> _loaded;
+};
+
+static Persistent* Store(VaultImplementation* vault)
+{
+    // Only the platform vault is backed by persistent storage
+    Persistent* store = nullptr;
+
+    if (reinterpret_cast<Vault*>(vault) == &Vault::PlatformInstance()) {
+        store = &Persistent::Instance();
+    } else {
+        TRACE_L1("Persistent storage is not available for this vault");
+    }
+
+    return (store);
+}
+
+} // namespace Implementation
+
+extern "C" {
+
+uint32_t persistent_key_exists(struct VaultImplementation* vault, const char locator[], bool* result)
+{
+    ASSERT(vault != nullptr);
+    ASSERT(locator != nullptr);
+    ASSERT(result != nullptr);
+
+    uint32_t error = WPEFramework::Core::ERROR_UNAVAILABLE;
+    Implementation::Persistent* store = Implementation::Store(vault);
+
+    if (store != nullptr) {
+        (*result) = store->Exists(locator);
+        error = WPEFramework::Core::ERROR_NONE;
+    }
+
+    return (error);
+}
+
+uint32_t persistent_key_load(struct VaultImplementation* vault, const char locator[], uint32_t* id)
+{
+    ASSERT(vault != nullptr);
+    ASSERT(locator != nullptr);
+    ASSERT(id != nullptr);
+
+    Implementation::Persistent* store = Implementation::Store(vault);
+
+    return (store != nullptr ? store->Load(locator, *id) : WPEFramework::Core::ERROR_UNAVAILABLE);
+}
+
+uint32_t persistent_key_create(struct VaultImplementation* vault, const char locator[], const key_type keyType, uint32_t* id)
+{
+    ASSERT(vault != nullptr);
+    ASSERT(locator != nullptr);
+    ASSERT(id != nullptr);
+
+    Implementation::Persistent* store = Implementation::Store(vault);
+
+    return (store != nullptr ? store->Create(locator, keyType, *id) : WPEFramework::Core::ERROR_UNAVAILABLE);
+}
+
+uint32_t persistent_flush(struct VaultImplementation* vault)
+{
+    ASSERT(vault != nullptr);
+
+    Implementation::Persistent* store = Implementation::Store(vault);
+
+    return (store != nullptr ? store->Flush() : WPEFramework::Core::ERROR_UNAVAILABLE);
+}
+
+} // extern "C"
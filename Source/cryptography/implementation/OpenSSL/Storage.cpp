@@ -0,0 +1,110 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 Metrological
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../../Module.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Storage.h"
+
+#ifndef PERSISTENT_PATH
+#define PERSISTENT_PATH "/var/lib"
+#endif
+
+namespace Implementation {
+
+namespace Storage {
+
+static bool IsPrivate(const struct stat& info, const mode_t type)
+{
+    return (((info.st_mode & S_IFMT) == type) && (info.st_uid == ::geteuid()) && ((info.st_mode & (S_IRWXG | S_IRWXO)) == 0));
+}
+
+string Location(const string& name)
+{
+    static const string directory(_T(PERSISTENT_PATH "/cryptography"));
+
+    string result;
+    struct stat info;
+
+    if (((::mkdir(directory.c_str(), S_IRWXU) == 0) || (errno == EEXIST))
+        && (::lstat(directory.c_str(), &info) == 0) && (IsPrivate(info, S_IFDIR) == true)) {
+        result = directory + _T('/') + name;
+    } else {
+        TRACE_L1("Storage directory %s is not available or not private", directory.c_str());
+    }
+
+    return (result);
+}
+
+bool IsPrivate(const string& path)
+{
+    struct stat info;
+
+    return ((::lstat(path.c_str(), &info) == 0) && (IsPrivate(info, S_IFREG) == true) && (info.st_nlink == 1));
+}
+
+bool Write(const string& path, const uint32_t length, const uint8_t data[])
+{
+    bool result = false;
+
+    const string temporary(path + _T(".new"));
+
+    ::unlink(temporary.c_str());
+
+    const int fd = ::open(temporary.c_str(), (O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC), (S_IRUSR | S_IWUSR));
+
+    if (fd < 0) {
+        TRACE_L1("Failed to create %s", temporary.c_str());
+    } else {
+        uint32_t written = 0;
+
+        while (written < length) {
+            const ssize_t size = ::write(fd, (data + written), (length - written));
+
+            if (size > 0) {
+                written += static_cast<uint32_t>(size);
+            } else if ((size < 0) && (errno == EINTR)) {
+                continue;
+            } else {
+                break;
+            }
+        }
+
+        result = ((written == length) && (::fsync(fd) == 0));
+        ::close(fd);
+
+        // Readers either see the old or the new file, never a partial one
+        if ((result == false) || (::rename(temporary.c_str(), path.c_str()) != 0)) {
+            TRACE_L1("Failed to write %s", path.c_str());
+            ::unlink(temporary.c_str());
+            result = false;
+        }
+    }
+
+    return (result);
+}
+
+} // namespace Storage
+
+} // namespace Implementation
@@ -0,0 +1,42 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 Metrological
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "../../Module.h"
+
+
+namespace Implementation {
+
+// Files holding (sealed) key material are only accessible by the user running the library.
+namespace Storage {
+
+// Default location of a file of this library, in a private directory under the persistent path. Returns an empty
+// string if that directory can not be created or is accessible by others.
+string Location(const string& name);
+
+// Plain file (not a link), owned by this user and not accessible by anyone else
+bool IsPrivate(const string& path);
+
+// Atomically replaces the file by the given data, created with owner only permissions
+bool Write(const string& path, const uint32_t length, const uint8_t data[]);
+
+} // namespace Storage
+
+} // namespace Implementation
@@ -19,7 +19,6 @@
 
 #include "../../Module.h"
 
-#include <persistent_implementation.h>
 #include <vault_implementation.h>
 
 #include <cryptalgo/cryptalgo.h>
@@ -34,6 +33,7 @@ using namespace WPEFramework;
 #include <openssl/evp.h>
 #include <openssl/rand.h>
 
+#include "../Statistics.h"
 #include "Derive.h"
 #include "Vault.h"
 
@@ -64,14 +64,66 @@ namespace Netflix {
 
     static constexpr uint8_t MAX_ESN_SIZE = 64;
 
+#ifdef __WINDOWS__
+#pragma warning(disable : 4200)
+#endif
+#pragma pack(push, 1)
+    struct NetflixData {
+        uint8_t salt[16];
+        uint8_t kpe[16];
+        uint8_t kph[32];
+        uint8_t esn[0];
+    };
+#pragma pack(pop)
+#ifdef __WINDOWS__
+#pragma warning(default : 4200)
+#endif
+
+    static constexpr uint16_t MAX_DATA_SIZE = (sizeof(NetflixData) + MAX_ESN_SIZE);
+
 } // namespace Netflix
 
 /* static */ Vault& Vault::NetflixInstance()
 {
+    // Takes the clear provisioning data (salt, kpe, kph and ESN) into the vault
+    auto load = [](Vault& vault, const uint16_t size, const uint8_t blob[]) -> bool {
+        bool result = false;
+
+        if (size > sizeof(Netflix::NetflixData)) {
+            const Netflix::NetflixData* data = reinterpret_cast<const Netflix::NetflixData*>(blob);
+
+            VARIABLE_IS_NOT_USED uint32_t kpeId = vault.Reserve(Netflix::KPE_ID, sizeof(Netflix::NetflixData::kpe), data->kpe, false);
+            ASSERT(kpeId == Netflix::KPE_ID);
+
+            VARIABLE_IS_NOT_USED uint32_t kphId = vault.Reserve(Netflix::KPH_ID, sizeof(Netflix::NetflixData::kph), data->kph, false);
+            ASSERT(kphId == Netflix::KPH_ID);
+
+            uint8_t kpw[32];
+            // kpe and kph are already concatenated in the correct order
+            Netflix::DeriveWrappingKey(data->kpe, (sizeof(data->kpe) + sizeof(data->kph)), sizeof(kpw), kpw);
+            VARIABLE_IS_NOT_USED uint32_t kdwId = vault.Reserve(Netflix::KPW_ID, 16, kpw, false); // take the first 16 bytes only!
+            ASSERT(kdwId == Netflix::KPW_ID);
+
+            // shred :)
+            ::memset(kpw, 0xFF, sizeof(kpw));
+
+            // Let's (ab)use the vault to hold the ESN as well
+            VARIABLE_IS_NOT_USED uint32_t esnId = vault.Reserve(Netflix::ESN_ID, (size - sizeof(Netflix::NetflixData)), data->esn, true);
+            ASSERT(esnId == Netflix::ESN_ID);
+
+            result = true;
+        }
+
+        return (result);
+    };
+
 #if defined(USE_PROVISIONING)
     static const uint8_t key[] = { 0x41, 0xde, 0xba, 0x86, 0x9f, 0xcf, 0x2e, 0xb1, 0xcc, 0x0c, 0x15, 0xb7, 0x4e, 0xd0, 0x9d, 0x90 };
 
-    auto ctor = [](Vault& vault) {
+    // The clear provisioning data is not kept anywhere but in the vault: sealed with the vault key only (which is
+    // built into the library) it would not be protected at all. Every process provisions again, but only once one
+    // of the Netflix keys is asked for.
+    auto ctor = [load](Vault& vault) {
         auto engine = Core::ProxyType<RPC::InvokeServerType<1, 0, 4>>::Create();
         auto client = Core::ProxyType<RPC::CommunicatorClient>::Create(Core::NodeId(GetEndPoint().c_str()), Core::ProxyType<Core::IIPCServer>(engine));
 
@@ -88,21 +140,6 @@ namespace Netflix {
                     printf("%s:%d [%s] Set label to default \"%s\"\n", __FILE__, __LINE__, __func__, label.c_str());
                 }
 
-#ifdef __WINDOWS__
-#pragma warning(disable : 4200)
-#endif
-#pragma pack(push, 1)
-                struct NetflixData {
-                    uint8_t salt[16];
-                    uint8_t kpe[16];
-                    uint8_t kph[32];
-                    uint8_t esn[0];
-                };
-#pragma pack(pop)
-#ifdef __WINDOWS__
-#pragma warning(default : 4200)
-#endif
-
                 uint8_t encrypted_data[1024];
                 uint16_t encrypted_data_size = sizeof(encrypted_data);
 
@@ -110,41 +147,26 @@ namespace Netflix {
 
                 if (error == Core::ERROR_NONE) {
                     uint8_t netflix_data[256];
-                    uint16_t netflix_data_size = sizeof(netflix_data);
-
-                    netflix_data_size = ClearBlob(encrypted_data_size, reinterpret_cast<const char*>(encrypted_data), sizeof(netflix_data), reinterpret_cast<char*>(netflix_data));
+                    uint16_t netflix_data_size = ClearBlob(encrypted_data_size, reinterpret_cast<const char*>(encrypted_data), sizeof(netflix_data), reinterpret_cast<char*>(netflix_data));
 
-                    if (netflix_data_size > 0) {
+                    if ((netflix_data_size > 0) && (load(vault, netflix_data_size, netflix_data) == true)) {
                         printf("%s:%d [%s] Received Provision Info for '%s' with length [%d].\n", __FILE__, __LINE__, __func__, label.c_str(), netflix_data_size);
 
-                        NetflixData* data = reinterpret_cast<NetflixData*>(netflix_data);
-
-                        VARIABLE_IS_NOT_USED uint32_t kpeId = vault.Import(sizeof(NetflixData::kpe), data->kpe, false);
-                        ASSERT(kpeId == Netflix::KPE_ID);
-
-                        VARIABLE_IS_NOT_USED uint32_t kphId = vault.Import(sizeof(NetflixData::kph), data->kph, false);
-                        ASSERT(kphId == Netflix::KPH_ID);
-
-                        uint8_t kpw[32];
-                        // kpe and kph are already concatenated in the correct order
-                        Netflix::DeriveWrappingKey(data->kpe, (sizeof(data->kpe) + sizeof(data->kph)), sizeof(kpw), kpw);
-                        VARIABLE_IS_NOT_USED uint32_t kdwId = vault.Import(16, kpw, false); // take the first 16 bytes only!
-                        ASSERT(kdwId == Netflix::KPW_ID);
-
-                        // Let's (ab)use the vault to hold the ESN as well
-                        vault._lastHandle = (Netflix::ESN_ID - 1);
-                        VARIABLE_IS_NOT_USED uint32_t esnId = vault.Import((netflix_data_size - sizeof(NetflixData)), data->esn, true);
-                        ASSERT(esnId == Netflix::ESN_ID);
-
                         TRACE_L1("Imported pre-shared keys and ESN () into the Netflix vault");
 
                     } else {
                         printf("%s:%d [%s] Failed to get %s\n", __FILE__, __LINE__, __func__, label.c_str());
                     }
+
+                    // shred :)
+                    ::memset(netflix_data, 0xFF, sizeof(netflix_data));
                 } else {
                     printf("%s:%d [%s] Failed to extract %s provisioning. Error code %d.\n", __FILE__, __LINE__, __func__, label.c_str(), error);
                 }
 
+                // shred :)
+                ::memset(encrypted_data, 0xFF, sizeof(encrypted_data));
+
                 provisioning->Release();
             }
         }
@@ -152,62 +174,41 @@ namespace Netflix {
 #else
     static const uint8_t key[] = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff, 0x11 };
 
-    auto ctor = [](Vault& vault) {
-        std::string path;
-        WPEFramework::Core::SystemInfo::GetEnvironment(_T("NETFLIX_VAULT"), path);
+    // Reads and unseals a file holding IV and the provisioning data, encrypted with the vault key (blob takes MAX_DATA_SIZE bytes)
+    auto read = [](const Vault& vault, const string& path, uint8_t blob[]) -> uint16_t {
+        uint16_t result = 0;
         WPEFramework::Core::File file(path);
 
         if (file.Open(true) == true) {
-#ifdef __WINDOWS__
-#pragma warning(disable : 4200)
-#endif
-#pragma pack(push, 1)
-            struct NetflixData {
-                uint8_t salt[16];
-                uint8_t kpe[16];
-                uint8_t kph[32];
-                uint8_t esn[0];
-            };
-#pragma pack(pop)
-#ifdef __WINDOWS__
-#pragma warning(default : 4200)
-#endif
+            const uint64_t fileSize = file.Size();
 
-            uint64_t fileSize = file.Size();
+            if ((fileSize > (IV_SIZE + sizeof(Netflix::NetflixData))) && (fileSize <= (IV_SIZE + Netflix::MAX_DATA_SIZE))) {
+                uint8_t input[IV_SIZE + Netflix::MAX_DATA_SIZE];
 
-            if ((fileSize > (IV_SIZE + sizeof(NetflixData))) && (fileSize <= (IV_SIZE + sizeof(NetflixData) + Netflix::MAX_ESN_SIZE))) {
-                uint16_t blobSize = (static_cast<uint16_t>(fileSize) - IV_SIZE);
-                uint8_t* decryptedBlob = reinterpret_cast<uint8_t*>(ALLOCA(blobSize));
-                uint8_t* input = reinterpret_cast<uint8_t*>(ALLOCA(fileSize));
-                file.Read(input, static_cast<uint32_t>(fileSize));
-                blobSize = vault.Cipher(false, (IV_SIZE + blobSize), input, blobSize, decryptedBlob);
-
-                if (blobSize >= sizeof(NetflixData)) {
-                    NetflixData* data = reinterpret_cast<NetflixData*>(decryptedBlob);
-
-                    VARIABLE_IS_NOT_USED uint32_t kpeId = vault.Import(sizeof(NetflixData::kpe), data->kpe, false);
-                    ASSERT(kpeId == Netflix::KPE_ID);
+                if (file.Read(input, static_cast<uint32_t>(fileSize)) == fileSize) {
+                    result = vault.Cipher(false, static_cast<uint16_t>(fileSize), input, Netflix::MAX_DATA_SIZE, blob);
+                }
+            }
 
-                    VARIABLE_IS_NOT_USED uint32_t kphId = vault.Import(sizeof(NetflixData::kph), data->kph, false);
-                    ASSERT(kphId == Netflix::KPH_ID);
+            file.Close();
+        }
 
-                    uint8_t kpw[32];
-                    // kpe and kph are already concatenated in the correct order
-                    Netflix::DeriveWrappingKey(data->kpe, (sizeof(data->kpe) + sizeof(data->kph)), sizeof(kpw), kpw);
-                    VARIABLE_IS_NOT_USED uint32_t kdwId = vault.Import(16, kpw, false); // take the first 16 bytes only!
-                    ASSERT(kdwId == Netflix::KPW_ID);
+        return (result);
+    };
 
-                    // Let's (ab)use the vault to hold the ESN as well
-                    vault._lastHandle = (Netflix::ESN_ID - 1);
-                    VARIABLE_IS_NOT_USED uint32_t esnId = vault.Import((blobSize - sizeof(NetflixData)), data->esn, true);
-                    ASSERT(esnId == Netflix::ESN_ID);
+    auto ctor = [load, read](Vault& vault) {
+        std::string path;
+        WPEFramework::Core::SystemInfo::GetEnvironment(_T("NETFLIX_VAULT"), path);
 
-                    TRACE_L1("Imported pre-shared keys and ESN into the Netflix vault");
-                }
-            }
+        uint8_t netflix_data[Netflix::MAX_DATA_SIZE];
+        const uint16_t netflix_data_size = read(vault, path, netflix_data);
 
-            file.Close();
+        if ((netflix_data_size > 0) && (load(vault, netflix_data_size, netflix_data) == true)) {
+            TRACE_L1("Imported pre-shared keys and ESN into the Netflix vault");
         }
+
+        // shred :)
+        ::memset(netflix_data, 0xFF, sizeof(netflix_data));
     };
 
 #endif
@@ -219,6 +220,7 @@ namespace Netflix {
         vault.Delete(Netflix::KPE_ID);
     };
 
+    // The keys are only brought in once one of them is asked for, see Bootstrap()
     static Vault instance(string(reinterpret_cast<const char*>(key), sizeof(key)), ctor, dtor);
     return (instance);
 }
@@ -232,17 +234,12 @@ namespace Netflix {
 }
 
 Vault::Vault(const string key, const Callback& ctor, const Callback& dtor)
-    : _lock()
-    , _items()
-    , _lastHandle(0)
+    : _table(SHARDS)
     , _vaultKey(key)
+    , _ctor(ctor)
     , _dtor(dtor)
+    , _bootstrap()
 {
-    if (ctor != nullptr) {
-        ctor(*this);
-    }
-
-    _lastHandle = 0x80000000;
 }
 
 Vault::~Vault()
@@ -289,31 +286,50 @@ uint16_t Vault::Cipher(bool encrypt, const uint16_t inSize, const uint8_t input[
         EVP_CipherInit_ex(ctx, EVP_aes_128_ctr(), nullptr, reinterpret_cast<const unsigned char*>(_vaultKey.data()), iv, encrypt);
         EVP_CipherUpdate(ctx, outputBuffer, &outLen, inputBuffer, inputSize);
         totalLen += outLen;
+        outputBuffer += outLen;
         outLen = 0;
-        EVP_EncryptFinal_ex(ctx, (outputBuffer + totalLen), &outLen);
+        EVP_CipherFinal_ex(ctx, outputBuffer, &outLen);
         totalLen += outLen;
 
-#if OPENSSL_VERSION_NUMBER >= 0x10100000L
-        EVP_CIPHER_CTX_reset(ctx);
-#else
-        EVP_CIPHER_CTX_cleanup(ctx);
-#endif
+        EVP_CIPHER_CTX_free(ctx);
     }
 
     return (totalLen);
 }
 
+uint32_t Vault::Reserve(const uint32_t id, const uint16_t size, const uint8_t blob[], bool exportable)
+{
+    ASSERT(id < HandleTable::RESERVED);
+
+    uint32_t result = 0;
+
+    if (size > 0) {
+        uint8_t* buf = reinterpret_cast<uint8_t*>(ALLOCA(size + IV_SIZE));
+        uint16_t len = Cipher(true, size, blob, (size + IV_SIZE), buf);
+
+        result = _table.Insert(len, buf, exportable, id);
+
+        if (result != 0) {
+            TRACE_L2("Added a %s data blob of size %i as internal id 0x%08x", (exportable ? "clear" : "sealed"), size, id);
+        }
+    }
+
+    return (result);
+}
+
 uint16_t Vault::Size(const uint32_t id, bool allowSealed) const
 {
     uint16_t size = 0;
 
-    _lock.Lock();
-    auto it = _items.find(id);
-    if (it != _items.end()) {
-        if ((allowSealed == true) || (*it).second.IsExportable() == true) {
-            size = ((*it).second.Size() - IV_SIZE);
+    Bootstrap(id);
+    bool exportable = false;
+
+    uint16_t sealedSize = _table.Copy(id, 0, nullptr, exportable);
+    if (sealedSize != 0) {
+        if ((allowSealed == true) || (exportable == true)) {
+            size = (sealedSize - IV_SIZE);
             TRACE_L2("%sBlob id 0x%08x size: %i",
-                (((allowSealed == true) || ((*it).second.IsExportable() == false)) ? "Internal: " : ""), id, size);
+                (((allowSealed == true) || (exportable == false)) ? "Internal: " : ""), id, size);
         } else {
             TRACE_L2("Blob id 0x%08x is sealed, won't tell its size", id);
             size = USHRT_MAX;
@@ -321,7 +337,6 @@ uint16_t Vault::Size(const uint32_t id, bool allowSealed) const
     } else {
         TRACE_L1("Failed to look up blob id 0x%08x", id);
     }
-    _lock.Unlock();
 
     return (size);
 }
@@ -331,22 +346,14 @@ uint32_t Vault::Import(const uint16_t size, const uint8_t blob[], bool exportabl
     uint32_t id = 0;
 
     if (size > 0) {
-        _lock.Lock();
-        id = (_lastHandle + 1);
+        uint8_t* buf = reinterpret_cast<uint8_t*>(ALLOCA(size + IV_SIZE));
+        uint16_t len = Cipher(true, size, blob, (size + IV_SIZE), buf);
 
-        if (id != 0) {
-            uint8_t* buf = reinterpret_cast<uint8_t*>(ALLOCA(USHRT_MAX));
-            uint16_t len = Cipher(true, size, blob, USHRT_MAX, buf);
-
-            _items.emplace(std::piecewise_construct,
-                std::forward_as_tuple(id),
-                std::forward_as_tuple(exportable, len, buf));
-
-            _lastHandle = id;
+        id = _table.Insert(len, buf, exportable);
 
+        if (id != 0) {
             TRACE_L2("Added a %s data blob of size %i as id 0x%08x", (exportable ? "clear" : "sealed"), (len - IV_SIZE), id);
         }
-        _lock.Unlock();
     }
 
     return (id);
@@ -356,22 +363,36 @@ uint16_t Vault::Export(const uint32_t id, const uint16_t size, uint8_t blob[], b
 {
     uint16_t outSize = 0;
 
+    Bootstrap(id);
+
     if (size > 0) {
-        _lock.Lock();
-        auto it = _items.find(id);
-        if (it != _items.end()) {
-            if ((allowSealed == true) || ((*it).second.IsExportable() == true)) {
-                outSize = Cipher(false, (*it).second.Size(), (*it).second.Buffer(), size, blob);
+        // Most blobs are keys, which fit the stack buffer, anything bigger takes a second copy
+        uint8_t local[HandleTable::INLINE_SIZE];
+        uint8_t* sealed = local;
+        bool exportable = false;
+
+        uint16_t sealedSize = _table.Copy(id, sizeof(local), sealed, exportable);
+
+        if (sealedSize > sizeof(local)) {
+            sealed = reinterpret_cast<uint8_t*>(ALLOCA(sealedSize));
+            sealedSize = _table.Copy(id, sealedSize, sealed, exportable);
+        }
+
+        if (sealedSize != 0) {
+            if ((allowSealed == true) || (exportable == true)) {
+                outSize = Cipher(false, sealedSize, sealed, size, blob);
 
                 TRACE_L2("%sExported %i bytes from blob id 0x%08x",
-                    (((allowSealed == true) || ((*it).second.IsExportable() == false)) ? "Internal: " : ""), outSize, id);
+                    (((allowSealed == true) || (exportable == false)) ? "Internal: " : ""), outSize, id);
             } else {
                 TRACE_L1("Blob id 0x%08x is sealed, can't export", id);
             }
+
+            // shred :)
+            ::memset(sealed, 0xFF, sealedSize);
         } else {
             TRACE_L1("Failed to look up blob id 0x%08x", id);
         }
-        _lock.Unlock();
     }
 
     return (outSize);
@@ -382,18 +403,11 @@ uint32_t Vault::Put(const uint16_t size, const uint8_t blob[])
     uint32_t id = 0;
 
     if (size > 0) {
-        _lock.Lock();
-        id = (_lastHandle + 1);
-        if (id != 0) {
-            _items.emplace(std::piecewise_construct,
-                std::forward_as_tuple(id),
-                std::forward_as_tuple(false, size, blob));
-
-            _lastHandle = id;
+        id = _table.Insert(size, blob, false);
 
+        if (id != 0) {
             TRACE_L2("Inserted a sealed data blob of size %i as id 0x%08x", size, id);
         }
-        _lock.Unlock();
     }
 
     return (id);
@@ -403,31 +417,35 @@ uint16_t Vault::Get(const uint32_t id, const uint16_t size, uint8_t blob[]) cons
 {
     uint16_t result = 0;
 
+    Bootstrap(id);
+
     if (size > 0) {
-        _lock.Lock();
-        auto it = _items.find(id);
-        if (it != _items.end()) {
-            result = std::min(size, static_cast<uint16_t>((*it).second.Size()));
-            ::memcpy(blob, (*it).second.Buffer(), result);
+        bool exportable = false;
+        uint16_t sealedSize = _table.Copy(id, size, blob, exportable);
+
+        if (sealedSize != 0) {
+            result = std::min(size, sealedSize);
             TRACE_L2("Retrieved a sealed data blob id 0x%08x of size %i bytes", id, result);
         }
-        _lock.Unlock();
     }
 
     return (result);
 }
 
+uint64_t Vault::Serial(const uint32_t id) const
+{
+    Bootstrap(id);
+
+    return (_table.Serial(id));
+}
+
 bool Vault::Delete(const uint32_t id)
 {
-    bool result = false;
+    bool result = _table.Remove(id);
 
-    _lock.Lock();
-    auto it = _items.find(id);
-    if (it != _items.end()) {
-        _items.erase(it);
-        result = true;
+    if (result == true) {
+        EvictKey(this, id);
     }
-    _lock.Unlock();
 
     return (result);
 }
@@ -468,6 +486,7 @@ uint32_t vault_import(VaultImplementation* vault, const uint16_t length, const u
 {
     ASSERT(vault != nullptr);
     Implementation::Vault* vaultImpl = reinterpret_cast<Implementation::Vault*>(vault);
+    Implementation::Statistics::Scope scope(CRYPTOGRAPHY_OPERATION_VAULT_IMPORT, 0, 0, length);
     return (vaultImpl->Import(length, data, true /* imported in clear is always exportable */));
 }
 
@@ -475,13 +494,17 @@ uint16_t vault_export(const VaultImplementation* vault, const uint32_t id, const
 {
     ASSERT(vault != nullptr);
     const Implementation::Vault* vaultImpl = reinterpret_cast<const Implementation::Vault*>(vault);
-    return (vaultImpl->Export(id, max_length, data));
+    Implementation::Statistics::Scope scope(CRYPTOGRAPHY_OPERATION_VAULT_EXPORT, 0);
+    const uint16_t length = vaultImpl->Export(id, max_length, data);
+    scope.Bytes(length);
+    return (length);
 }
 
 uint32_t vault_set(VaultImplementation* vault, const uint16_t length, const uint8_t data[])
 {
     ASSERT(vault != nullptr);
     Implementation::Vault* vaultImpl = reinterpret_cast<Implementation::Vault*>(vault);
+    Implementation::Statistics::Scope scope(CRYPTOGRAPHY_OPERATION_VAULT_SET, 0, 0, length);
     return (vaultImpl->Put(length, data));
 }
 
@@ -489,13 +512,17 @@ uint16_t vault_get(const VaultImplementation* vault, const uint32_t id, const ui
 {
     ASSERT(vault != nullptr);
     const Implementation::Vault* vaultImpl = reinterpret_cast<const Implementation::Vault*>(vault);
-    return (vaultImpl->Get(id, max_length, data));
+    Implementation::Statistics::Scope scope(CRYPTOGRAPHY_OPERATION_VAULT_GET, 0);
+    const uint16_t length = vaultImpl->Get(id, max_length, data);
+    scope.Bytes(length);
+    return (length);
 }
 
 bool vault_delete(VaultImplementation* vault, const uint32_t id)
 {
     ASSERT(vault != nullptr);
     Implementation::Vault* vaultImpl = reinterpret_cast<Implementation::Vault*>(vault);
+    Implementation::Statistics::Scope scope(CRYPTOGRAPHY_OPERATION_VAULT_DELETE, 0);
     return (vaultImpl->Delete(id));
 }
 
@@ -525,24 +552,4 @@ uint32_t netflix_security_wrapping_key(void)
     return (Implementation::Vault::NetflixInstance().Size(Implementation::Netflix::KPW_ID) != 0 ? Implementation::Netflix::KPW_ID : 0);
 }
 
-uint32_t persistent_key_exists(struct VaultImplementation* /* vault */, const char* /* locator[] */, bool* /* result */)
-{
-    return (WPEFramework::Core::ERROR_UNAVAILABLE);
-}
-
-uint32_t persistent_key_load(struct VaultImplementation* /* vault */, const char* /* locator[] */, uint32_t* /* id */)
-{
-    return (WPEFramework::Core::ERROR_UNAVAILABLE);
-}
-
-uint32_t persistent_key_create(struct VaultImplementation* /* vault */, const char* /* locator[] */, const key_type /* keyType */, uint32_t* /* id */)
-{
-    return (WPEFramework::Core::ERROR_UNAVAILABLE);
-}
-
-uint32_t persistent_flush(struct VaultImplementation* /* vault */)
-{
-    return (WPEFramework::Core::ERROR_UNAVAILABLE);
-}
-
 } // extern "C"
@@ -18,8 +18,10 @@
  */
 
 #include "../../Module.h"
-#include <map>
 #include <climits>
+#include <mutex>
+
+#include "../HandleTable.h"
 
 
 namespace Implementation {
@@ -39,31 +41,6 @@ public:
     Vault(Vault const&) = delete;
     void operator=(Vault const&) = delete;
 
-public:
-    class Element : public WPEFramework::Core::DataStore {
-    public:
-        Element(bool exportable, const uint16_t size)
-            : WPEFramework::Core::DataStore(size)
-            , _exportable(exportable)
-        {
-        }
-
-        Element(bool exportable, const uint16_t size, const uint8_t* buffer)
-            : WPEFramework::Core::DataStore(size)
-            , _exportable(exportable)
-        {
-            Copy(buffer, size);
-        }
-
-        bool IsExportable() const
-        {
-            return _exportable;
-        }
-
-    private:
-        bool _exportable;
-    };
-
 public:
     uint16_t Size(const uint32_t id, bool allowSealed = false) const;
     uint32_t Import(const uint16_t size, const uint8_t blob[], bool exportable = false);
@@ -72,15 +49,37 @@ public:
     uint16_t Get(const uint32_t id, const uint16_t size, uint8_t blob[]) const;
     bool Delete(const uint32_t id);
 
+    // Never the same for two blobs, allows for validation of state derived from a blob (0 if the id is not valid).
+    uint64_t Serial(const uint32_t id) const;
+
+private:
+    // Blobs are spread over a number of independently locked shards of the handle table, a lock
+    // is only held to copy a (sealed) blob in or out. The expensive unsealing is done outside of
+    // any lock, on the copy.
+    static constexpr uint8_t SHARDS = 8;
+
 private:
+    // The reserved blobs (i.e. the Netflix keys) are only set up by the constructor callback once
+    // one of them is asked for, so processes that never use them do not pay for it.
+    void Bootstrap(const uint32_t id) const
+    {
+        if ((id < HandleTable::RESERVED) && (_ctor != nullptr)) {
+            std::call_once(_bootstrap, _ctor, std::ref(const_cast<Vault&>(*this)));
+        }
+    }
+
+    uint32_t Reserve(const uint32_t id, const uint16_t size, const uint8_t blob[], bool exportable);
     uint16_t Cipher(bool encrypt, const uint16_t inSize, const uint8_t input[], const uint16_t maxOutSize, uint8_t output[]) const;
 
 private:
-    mutable WPEFramework::Core::CriticalSection _lock;
-    std::map<uint32_t, Element> _items;
-    uint32_t _lastHandle;
+    HandleTable _table;
     string _vaultKey;
+    Callback _ctor;
     Callback _dtor;
+    mutable std::once_flag _bootstrap;
 };
 
+// Drops the prepared HMAC contexts of a deleted key (see Hash.cpp)
+void EvictKey(const Vault* vault, const uint32_t keyId);
+
 } // namespace Implementation
@@ -0,0 +1,234 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 Metrological
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "../Module.h"
+
+#include <stdint.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <functional>
+#include <list>
+
+namespace Implementation {
+
+    // Small pool of worker threads to spread a single large cipher operation over the available cores.
+    // Only modes where every chunk can be processed independently (CTR, CBC decryption) are split up.
+    class Parallel {
+    public:
+#ifdef PARALLEL_CIPHER
+        static constexpr bool Enabled = true;
+#else
+        static constexpr bool Enabled = false;
+#endif
+
+        // Inputs below this size are not worth the hand-over to other threads
+        static constexpr uint32_t Threshold = (1024 * 1024);
+        static constexpr uint32_t MinimumChunk = (256 * 1024);
+        static constexpr uint8_t MaxWorkers = 4;
+        static constexpr uint8_t BlockSize = 16;
+
+    private:
+        struct Batch {
+            Batch(const std::function<bool(const uint8_t)>& job, const uint8_t count)
+                : Job(job)
+                , Pending(count)
+                , Success(true)
+                , Done(false, true)
+            {
+            }
+
+            const std::function<bool(const uint8_t)>& Job;
+            uint8_t Pending;
+            bool Success;
+            WPEFramework::Core::Event Done;
+        };
+
+        struct Task {
+            Batch* Owner;
+            uint8_t Index;
+        };
+
+        class Minion : public WPEFramework::Core::Thread {
+        public:
+            Minion() = delete;
+            Minion(const Minion&) = delete;
+            Minion& operator=(const Minion&) = delete;
+
+            Minion(Parallel& parent)
+                : WPEFramework::Core::Thread(WPEFramework::Core::Thread::DefaultStackSize(), _T("CryptographyParallel"))
+                , _parent(parent)
+            {
+            }
+            ~Minion() override
+            {
+                Stop();
+                Wait(WPEFramework::Core::Thread::STOPPED, WPEFramework::Core::infinite);
+            }
+
+        private:
+            uint32_t Worker() override
+            {
+                return (_parent.Process(*this));
+            }
+
+        private:
+            Parallel& _parent;
+        };
+
+    public:
+        Parallel(const Parallel&) = delete;
+        Parallel& operator=(const Parallel&) = delete;
+
+        Parallel()
+            : _lock()
+            , _tasks()
+            , _minions()
+            , _idle()
+        {
+            const long online = ::sysconf(_SC_NPROCESSORS_ONLN);
+            const uint8_t cores = static_cast<uint8_t>(std::min(std::max(online, 1L), static_cast<long>(MaxWorkers)));
+
+            // The calling thread always takes a chunk itself
+            for (uint8_t index = 1; index < cores; index++) {
+                _minions.emplace_back(*this);
+                _idle.push_back(&_minions.back());
+            }
+        }
+
+        ~Parallel()
+        {
+            for (Minion& minion : _minions) {
+                minion.Stop();
+            }
+
+            _minions.clear();
+        }
+
+        static Parallel& Instance()
+        {
+            static Parallel instance;
+            return (instance);
+        }
+
+    public:
+        // Number of chunks to cut the input in, 1 means: do it serially
+        uint8_t Chunks(const uint32_t length) const
+        {
+            const uint32_t chunks = std::min(static_cast<uint32_t>(_minions.size() + 1), (length / MinimumChunk));
+            return (length < Threshold ? 1 : static_cast<uint8_t>(std::max(chunks, static_cast<uint32_t>(1))));
+        }
+
+        // Offset of a chunk in the input, all but the last chunk are of equal size and block aligned
+        static uint32_t Offset(const uint32_t length, const uint8_t chunks, const uint8_t index)
+        {
+            return (((length / BlockSize) / chunks) * BlockSize * index);
+        }
+
+        // Runs job(0) up to job(count - 1), job(0) on the calling thread, and returns once all completed.
+        bool Run(const uint8_t count, const std::function<bool(const uint8_t)>& job)
+        {
+            Batch batch(job, count);
+
+            if (count > 1) {
+                _lock.Lock();
+
+                for (uint8_t index = 1; index < count; index++) {
+                    _tasks.push_back({ &batch, index });
+
+                    if (_idle.empty() == false) {
+                        _idle.front()->Run();
+                        _idle.pop_front();
+                    }
+                }
+
+                _lock.Unlock();
+            }
+
+            Complete(batch, job(0));
+
+            batch.Done.Lock(WPEFramework::Core::infinite);
+
+            // The last one to complete may still be on its way out of Complete()
+            _lock.Lock();
+            _lock.Unlock();
+
+            return (batch.Success);
+        }
+
+        // Counter block for the given block offset into the stream, the counter spans the full 128 bits.
+        static void Advance(uint8_t counter[BlockSize], uint32_t blocks)
+        {
+            for (int8_t index = (BlockSize - 1); ((index >= 0) && (blocks != 0)); index--) {
+                const uint32_t sum = (counter[index] + (blocks & 0xFF));
+                counter[index] = static_cast<uint8_t>(sum);
+                blocks = ((blocks >> 8) + (sum >> 8));
+            }
+        }
+
+    private:
+        void Complete(Batch& batch, const bool success)
+        {
+            _lock.Lock();
+
+            batch.Success = (batch.Success && success);
+            batch.Pending--;
+
+            if (batch.Pending == 0) {
+                batch.Done.SetEvent();
+            }
+
+            _lock.Unlock();
+        }
+
+        uint32_t Process(Minion& minion)
+        {
+            uint32_t result = 0;
+
+            _lock.Lock();
+
+            if (_tasks.empty() == true) {
+                // Until Run() hands out the next chunk
+                _idle.push_back(&minion);
+                minion.Block();
+                result = WPEFramework::Core::infinite;
+
+                _lock.Unlock();
+            } else {
+                Task task = _tasks.front();
+                _tasks.pop_front();
+
+                _lock.Unlock();
+
+                Complete(*task.Owner, task.Owner->Job(task.Index));
+            }
+
+            return (result);
+        }
+
+    private:
+        WPEFramework::Core::CriticalSection _lock;
+        std::list<Task> _tasks;
+        std::list<Minion> _minions;
+        std::list<Minion*> _idle;
+    };
+
+} // namespace Implementation
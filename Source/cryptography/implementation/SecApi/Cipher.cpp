@@ -21,6 +21,10 @@
 #include <core/core.h>
 #include <cryptalgo/cryptalgo.h>
 
+#include <vector>
+
+#include "../Statistics.h"
+
  /*Secapi headers */
 #include <sec_security.h>
 #include <sec_security_utils.h>
@@ -93,6 +97,29 @@ namespace Implementation {
         return (Operation(false, ivLength, iv, inputLength, input, maxOutputLength, output));
     }
 
+    /*********************************************************************
+     * @function Function OutputSize
+     *
+     * @brief   brief Output buffer size needed for an operation on a blob of data
+     *
+     * @param[in] encrypt - mode :true for enc and false for decrypt
+     * @param[in] inputLength - Length of input blob
+     *
+     * @return Exact size when encrypting, upper bound when decrypting with padding
+     *
+     *********************************************************************/
+    uint32_t Cipher::OutputSize(const bool encrypt, const uint32_t inputLength) const
+    {
+        uint32_t result = inputLength;
+
+        if ((encrypt == true) && ((_algorithm == SEC_CIPHERALGORITHM_AES_ECB_PKCS7_PADDING) || (_algorithm == SEC_CIPHERALGORITHM_AES_CBC_PKCS7_PADDING))) {
+            // A full block of padding if the input is block aligned
+            result = (inputLength + (16 - (inputLength % 16)));
+        }
+
+        return (result);
+    }
+
     /*********************************************************************
      * @function Function Operation
      *
@@ -118,13 +145,14 @@ namespace Implementation {
         ASSERT(input != nullptr);
         ASSERT(inputLength != 0);
 
+        const uint32_t required = OutputSize(encrypt, inputLength);
+
         if (ivLength != _ivLength) {
             TRACE_L1(_T("SEC: Invalid IV length! [%i]"), ivLength);
         }
-        else if (maxOutputLength < inputLength) {
-            // Note: Pitfall, AES CBC/ECB will use padding
-            TRACE_L1(_T("Too small output buffer, expected: %i bytes"), inputLength);
-            OutputLength = (-inputLength) + (16 - (inputLength % 16));
+        else if (maxOutputLength < required) {
+            TRACE_L1(_T("Too small output buffer, expected: %i bytes"), required);
+            OutputLength = -static_cast<int32_t>(required);
         }
         else {
             Sec_CipherHandle* cipher_handle = NULL;
@@ -252,6 +280,8 @@ extern "C" {
                 /*Get the algorithm and mode from AESCipher() and create an instance with Implementation::Cipher*/
                 const Sec_CipherAlgorithm cryptoAlg = Implementation::AESCipher(mode);
                 implementation = new Implementation::Cipher(vaultImpl, cryptoAlg, key_id, keyLength, 16);
+                implementation->KeyLength = static_cast<uint8_t>(keyLength);
+                implementation->Mode = static_cast<uint8_t>(mode);
             }
         }
         else if (Implementation::vaultId == CRYPTOGRAPHY_VAULT_NETFLIX)
@@ -263,6 +293,8 @@ extern "C" {
             }
             else {
                 implementation = new Implementation::CipherNetflix(vaultImplNetflix, key_id);
+                implementation->KeyLength = static_cast<uint8_t>(key_Length);
+                implementation->Mode = static_cast<uint8_t>(mode);
             }
         }
         return (implementation);
@@ -278,6 +310,7 @@ extern "C" {
         const uint32_t input_length, const uint8_t input[], const uint32_t max_output_length, uint8_t output[])
     {
         ASSERT(cipher != nullptr);
+        Implementation::Statistics::Scope scope(CRYPTOGRAPHY_OPERATION_ENCRYPT, cipher->KeyLength, cipher->Mode, input_length);
         return (cipher->Encrypt(iv_length, iv, input_length, input, max_output_length, output));
     }
 
@@ -285,9 +318,141 @@ extern "C" {
         const uint32_t input_length, const uint8_t input[], const uint32_t max_output_length, uint8_t output[])
     {
         ASSERT(cipher != nullptr);
+        Implementation::Statistics::Scope scope(CRYPTOGRAPHY_OPERATION_DECRYPT, cipher->KeyLength, cipher->Mode, input_length);
         return (cipher->Decrypt(iv_length, iv, input_length, input, max_output_length, output));
     }
 
+    uint32_t cipher_output_size(const struct CipherImplementation* cipher, const bool encrypt, const uint32_t input_length)
+    {
+        ASSERT(cipher != nullptr);
+        return (cipher->OutputSize(encrypt, input_length));
+    }
+
+    // SecCipher_Process() is not specified to work in place, the input goes through a copy.
+    static int32_t cipher_in_place(const struct CipherImplementation* cipher, const bool encrypt, const uint8_t iv_length, const uint8_t iv[],
+        const uint32_t length, const uint32_t max_length, uint8_t data[])
+    {
+        int32_t result = 0;
+
+        ASSERT(cipher != nullptr);
+
+        Implementation::Statistics::Scope scope((encrypt == true ? CRYPTOGRAPHY_OPERATION_ENCRYPT : CRYPTOGRAPHY_OPERATION_DECRYPT), cipher->KeyLength, cipher->Mode, length);
+
+        const uint32_t required = cipher->OutputSize(encrypt, length);
+
+        if (max_length < required) {
+            TRACE_L1(_T("Too small output buffer, expected: %i bytes"), required);
+            result = -static_cast<int32_t>(required);
+        }
+        else {
+            std::vector<uint8_t> input(data, (data + length));
+
+            result = (encrypt == true ? cipher->Encrypt(iv_length, iv, length, input.data(), max_length, data)
+                                      : cipher->Decrypt(iv_length, iv, length, input.data(), max_length, data));
+
+            // shred :)
+            std::fill(input.begin(), input.end(), 0xFF);
+        }
+
+        return (result);
+    }
+
+    int32_t cipher_encrypt_in_place(const struct CipherImplementation* cipher, const uint8_t iv_length, const uint8_t iv[],
+        const uint32_t length, const uint32_t max_length, uint8_t data[])
+    {
+        return (cipher_in_place(cipher, true, iv_length, iv, length, max_length, data));
+    }
+
+    int32_t cipher_decrypt_in_place(const struct CipherImplementation* cipher, const uint8_t iv_length, const uint8_t iv[],
+        const uint32_t length, const uint32_t max_length, uint8_t data[])
+    {
+        return (cipher_in_place(cipher, false, iv_length, iv, length, max_length, data));
+    }
+
+    int32_t cipher_batch(const struct CipherImplementation* cipher, const bool encrypt, const uint8_t iv_length, const uint16_t count,
+        const uint32_t input_length, const uint8_t input[], const uint32_t max_output_length, uint8_t output[])
+    {
+        ASSERT(cipher != nullptr);
+
+        Implementation::Statistics::Scope scope((encrypt == true ? CRYPTOGRAPHY_OPERATION_ENCRYPT : CRYPTOGRAPHY_OPERATION_DECRYPT), cipher->KeyLength, cipher->Mode, input_length);
+
+        // No batch support in SecApi, run the records one by one.
+        const uint32_t header = (iv_length + sizeof(uint32_t));
+        uint32_t offset = 0;
+        uint32_t written = 0;
+        uint16_t index = 0;
+
+        while ((index < count) && ((input_length - offset) >= header) && ((max_output_length - written) > sizeof(uint32_t))) {
+            uint32_t length;
+            std::memcpy(&length, (input + offset + iv_length), sizeof(length));
+
+            if (length > (input_length - offset - header)) {
+                break;
+            }
+
+            const uint8_t* iv = (input + offset);
+            const uint8_t* data = (input + offset + header);
+            uint8_t* result = (output + written + sizeof(uint32_t));
+            const uint32_t space = (max_output_length - written - sizeof(uint32_t));
+
+            int32_t processed = (encrypt == true ? cipher->Encrypt(iv_length, iv, length, data, space, result)
+                                                 : cipher->Decrypt(iv_length, iv, length, data, space, result));
+            if (processed <= 0) {
+                break;
+            }
+
+            std::memcpy((output + written), &processed, sizeof(uint32_t));
+            written += (sizeof(uint32_t) + processed);
+            offset += (header + length);
+            index++;
+        }
+
+        if (index != count) {
+            TRACE_L1(_T("SEC: batch failed at record %i of %i"), index, count);
+            written = 0;
+        }
+
+        return (written);
+    }
+
+    uint32_t cipher_stream_initialize(struct CipherImplementation* cipher, const bool /* encrypt */, const uint8_t /* iv_length */, const uint8_t /* iv */[])
+    {
+        ASSERT(cipher != nullptr);
+        TRACE_L1(_T("SEC: streaming cipher operations are not supported"));
+        return (WPEFramework::Core::ERROR_UNAVAILABLE);
+    }
+
+    int32_t cipher_stream_update(struct CipherImplementation* cipher, const uint32_t /* input_length */, const uint8_t /* input */[],
+        const uint32_t /* max_output_length */, uint8_t /* output */[])
+    {
+        ASSERT(cipher != nullptr);
+        return (0);
+    }
+
+    int32_t cipher_stream_finalize(struct CipherImplementation* cipher, const uint32_t /* max_output_length */, uint8_t /* output */[])
+    {
+        ASSERT(cipher != nullptr);
+        return (0);
+    }
+
+    int32_t cipher_encrypt_authenticated(const struct CipherImplementation* cipher, const uint8_t /* iv_length */, const uint8_t /* iv */[],
+        const uint32_t /* aad_length */, const uint8_t /* aad */[],
+        const uint32_t /* input_length */, const uint8_t /* input */[], const uint32_t /* max_output_length */, uint8_t /* output */[])
+    {
+        ASSERT(cipher != nullptr);
+        TRACE_L1(_T("SEC: authenticated cipher modes are not supported"));
+        return (0);
+    }
+
+    int32_t cipher_decrypt_authenticated(const struct CipherImplementation* cipher, const uint8_t /* iv_length */, const uint8_t /* iv */[],
+        const uint32_t /* aad_length */, const uint8_t /* aad */[],
+        const uint32_t /* input_length */, const uint8_t /* input */[], const uint32_t /* max_output_length */, uint8_t /* output */[])
+    {
+        ASSERT(cipher != nullptr);
+        TRACE_L1(_T("SEC: authenticated cipher modes are not supported"));
+        return (0);
+    }
+
 
 } // extern "C"
 
@@ -30,13 +30,25 @@
 
 
 struct CipherImplementation {
+    CipherImplementation()
+        : KeyLength(0)
+        , Mode(0)
+    {
+    }
+
     virtual int32_t Encrypt(const uint8_t ivLength, const uint8_t iv[], const uint32_t inputLength,
         const uint8_t input[], const uint32_t maxOutputLength, uint8_t output[]) const = 0;
 
     virtual int32_t Decrypt(const uint8_t ivLength, const uint8_t iv[], const uint32_t inputLength,
         const uint8_t input[], const uint32_t maxOutputLength, uint8_t output[]) const = 0;
 
+    virtual uint32_t OutputSize(const bool encrypt, const uint32_t inputLength) const = 0;
+
     virtual ~CipherImplementation() { }
+
+    // Key size (in bytes) and AES mode the statistics of the operations are recorded under
+    uint8_t KeyLength;
+    uint8_t Mode;
 };
 
 
@@ -64,6 +76,8 @@ namespace Implementation {
         int32_t Decrypt(const uint8_t ivLength, const uint8_t iv[], const uint32_t inputLength,
             const uint8_t input[], const uint32_t maxOutputLength, uint8_t output[]) const override;
 
+        uint32_t OutputSize(const bool encrypt, const uint32_t inputLength) const override;
+
     private:
 
         const Implementation::Vault* _vault;
@@ -96,6 +110,8 @@ namespace Implementation {
         int32_t Decrypt(const uint8_t ivLength, const uint8_t iv[], const uint32_t inputLength,
             const uint8_t input[], const uint32_t maxOutputLength, uint8_t output[]) const override;
 
+        uint32_t OutputSize(const bool encrypt, const uint32_t inputLength) const override;
+
         int32_t Operation(bool encrypt, const uint8_t ivLength, const uint8_t iv[], const uint32_t inputLength,
             const uint8_t input[], const uint32_t maxOutputLength, uint8_t output[]) const;
     };
@@ -89,6 +89,22 @@ namespace Implementation {
         return (Operation(false, ivLength, iv, inputLength, input, maxOutputLength, output));
     }
 
+    /*********************************************************************
+     * @function Function OutputSize
+     *
+     * @brief   brief Output buffer size needed for an AES-CBC operation (PKCS#7 padded)
+     *
+     * @param[in] encrypt - mode :true for enc and false for decrypt
+     * @param[in] inputLength - Length of input blob
+     *
+     * @return Exact size when encrypting, upper bound when decrypting
+     *
+     *********************************************************************/
+    uint32_t CipherNetflix::OutputSize(const bool encrypt, const uint32_t inputLength) const
+    {
+        return (encrypt == true ? (inputLength + (AES_128_BLOCK_SIZE - (inputLength % AES_128_BLOCK_SIZE))) : inputLength);
+    }
+
     /*********************************************************************
      * @function Function Operation
      *
@@ -22,6 +22,7 @@
 #include <diffiehellman_implementation.h>
 
 #include "Vault.h"
+#include "../Statistics.h"
 
 namespace Implementation {
     /*********************************************************************
@@ -151,10 +152,24 @@ extern "C" {
         ASSERT(private_key_id != nullptr);
         ASSERT(public_key_id != nullptr);
 
+        Implementation::Statistics::Scope scope(CRYPTOGRAPHY_OPERATION_DH_GENERATE, 0, 0, modulusSize);
+
         Implementation::VaultNetflix* _vault = reinterpret_cast<Implementation::VaultNetflix*>(vault);
         return (Implementation::GenerateDiffieHellmanKeys(_vault, generator, modulusSize, modulus, (*private_key_id), (*public_key_id)));
     }
 
+    uint32_t diffiehellman_generate_ec(struct VaultImplementation* vault, const curve_type curve,
+        uint32_t* private_key_id, uint32_t* public_key_id)
+    {
+        ASSERT(vault != nullptr);
+        ASSERT(private_key_id != nullptr);
+        ASSERT(public_key_id != nullptr);
+
+        //Not Implemented
+        TRACE_L1(_T("SEC: elliptic curve key agreement is not supported, curve %d \n"), curve);
+        return (-1);
+    }
+
     uint32_t diffiehellman_derive(struct VaultImplementation* vault, const uint32_t private_key_id, const uint32_t peer_public_key_id, uint32_t* secret_id)
     {
         ASSERT(vault != nullptr);
@@ -173,6 +188,8 @@ extern "C" {
         ASSERT(hmac_key_id != nullptr);
         ASSERT(wrapping_key_id != nullptr);
 
+        Implementation::Statistics::Scope scope(CRYPTOGRAPHY_OPERATION_DH_DERIVE, 0);
+
         Implementation::VaultNetflix* _vault = &Implementation::VaultNetflix::NetflixInstance();
         return (Implementation::Netflix::DiffieHellmanAuthenticatedDeriveSecret(_vault, private_dh_key_id, peer_public_dh_key_id, derivation_key_id,
             (*encryption_key_id), (*hmac_key_id), (*wrapping_key_id)));
@@ -95,6 +95,24 @@ namespace Implementation {
                 return SecDigest_Release(hndle->digest_handle, digestOutput, digestSize);
             }
 
+           /*********************************************************************
+             * @function Acquire (Digest)
+             *
+             * @brief Wrapper for obtaining a fresh digest handle
+             *
+             * @param[in] proc - sec processor handle
+             * @param[in] digestAlg - digest algorithm
+             * @param[in] macAlg - unused
+             * @param[in] key - unused
+             * @param[out] hndle - digest/mac handle
+             *
+             * @return Sec_Result indicating success or otherwise
+             *
+             *********************************************************************/
+            static Sec_Result  Acquire(Sec_ProcessorHandle* proc, const Sec_DigestAlgorithm digestAlg, const Sec_MacAlgorithm /* macAlg */, Sec_KeyHandle* /* key */, Handle* hndle) {
+                return SecDigest_GetInstance(proc, digestAlg, &(hndle->digest_handle));
+            }
+
         };
 
         struct HMAC {
@@ -131,6 +149,24 @@ namespace Implementation {
                 return SecMac_Release(hndle->mac_handle, hmacOutput, hmacSize);
             }
 
+            /*********************************************************************
+             * @function Acquire (HMAC)
+             *
+             * @brief Wrapper for obtaining a fresh mac handle for the same key
+             *
+             * @param[in] proc - sec processor handle
+             * @param[in] digestAlg - unused
+             * @param[in] macAlg - mac algorithm
+             * @param[in] key - key handle
+             * @param[out] hndle - digest/mac handle
+             *
+             * @return Sec_Result indicating success or otherwise
+             *
+             *********************************************************************/
+            static Sec_Result Acquire(Sec_ProcessorHandle* proc, const Sec_DigestAlgorithm /* digestAlg */, const Sec_MacAlgorithm macAlg, Sec_KeyHandle* key, Handle* hndle) {
+                return SecMac_GetInstance(proc, macAlg, key, &(hndle->mac_handle));
+            }
+
         };
 
     } // namespace Operation
@@ -161,6 +197,8 @@ namespace Implementation {
                 }
                 else {
                     _size = digestSize;
+                    _digestAlg = digestAlg;
+                    _active = true;
                     ASSERT(_size != 0);
                 }
             }
@@ -201,6 +239,8 @@ namespace Implementation {
                     }
                     else {
                         _size = macSize;
+                        _macAlg = macAlg;
+                        _active = true;
                         ASSERT(_size != 0);
                     }
                 }
@@ -283,6 +323,7 @@ namespace Implementation {
             else {
                 size_t len = maxLength;
                 Sec_Result res = OPERATION::Final(handle, data, &len);
+                _active = false;
                 if (res != SEC_RESULT_SUCCESS) {
                     TRACE_L1(_T("Final() failed retVal = %d"),res);
                     _failure = true;
@@ -298,7 +339,46 @@ namespace Implementation {
 
     }
 
+    template<typename OPERATION>
+    /*********************************************************************
+     * @function Reset
+     *
+     * @brief    Re-arm the digest/hmac for a new message, keeping the
+     *           algorithm and key
+     *
+     * @return status success/failure
+     *
+     *********************************************************************/
+    uint32_t Implementation::HashType<OPERATION>::Reset()
+    {
+        uint32_t result = WPEFramework::Core::ERROR_GENERAL;
+        const Implementation::Vault* vault = (_vault_digest != nullptr ? _vault_digest : _vault);
+
+        if (_size == 0) {
+            TRACE_L1(_T("SEC : Hash reset() failed, hash was never set up"));
+        }
+        else {
+            if (true == _active) {
+                // Release the pending handle, the intermediate result is of no use.
+                SEC_BYTE* scratch = reinterpret_cast<SEC_BYTE*>(ALLOCA(_size));
+                SEC_SIZE len = _size;
+                OPERATION::Final(handle, scratch, &len);
+                _active = false;
+            }
 
+            Sec_Result res = OPERATION::Acquire(vault->getSecProcHandle(), _digestAlg, _macAlg, sec_key, handle);
+            if (res != SEC_RESULT_SUCCESS) {
+                TRACE_L1(_T("SEC : Acquire() failed retVal = %d"), res);
+                _failure = true;
+            }
+            else {
+                _active = true;
+                _failure = false;
+                result = WPEFramework::Core::ERROR_NONE;
+            }
+        }
+        return (result);
+    }
 
 } // namespace Implementation
 
@@ -317,6 +397,7 @@ extern "C" {
             Sec_DigestAlgorithm digest_alg = secalg->digest_alg;
             uint16_t size = secalg->size;
             implementation = new Implementation::HashType<Implementation::Operation::Digest>(digest_alg, size);
+            implementation->Size = static_cast<uint8_t>(size);
         }
         delete secalg;
         return (implementation);
@@ -340,6 +421,8 @@ extern "C" {
                     Sec_MacAlgorithm mac_alg = secalg->mac_alg;
                     uint16_t size = secalg->size;
                     implementation = new Implementation::HashType<Implementation::Operation::HMAC>(vaultImpl, mac_alg, size, secret_id, secretLength);
+                    implementation->Statistic = CRYPTOGRAPHY_OPERATION_HMAC;
+                    implementation->Size = static_cast<uint8_t>(size);
                     delete secalg;
 
                 }
@@ -348,6 +431,9 @@ extern "C" {
         else if (Implementation::vaultId == CRYPTOGRAPHY_VAULT_NETFLIX) {
             const Implementation::VaultNetflix* vaultImplNetflix = reinterpret_cast<const Implementation::VaultNetflix*>(vault);
             implementation = new Implementation::HashTypeNetflix(vaultImplNetflix, secret_id);
+            // SecNetflix_Hmac() is HMAC-SHA256
+            implementation->Statistic = CRYPTOGRAPHY_OPERATION_HMAC;
+            implementation->Size = HASH_TYPE_SHA256;
         }
 
 
@@ -363,6 +449,7 @@ extern "C" {
     uint32_t hash_ingest(HashImplementation* hash, const uint32_t length, const uint8_t data[])
     {
         ASSERT(hash != nullptr);
+        Implementation::Statistics::Scope scope(hash->Statistic, hash->Size, 0, length);
         return (hash->Ingest(length, data));
     }
 
@@ -372,5 +459,53 @@ extern "C" {
         return (hash->Calculate(max_length, data));
     }
 
+    uint16_t hash_batch(HashImplementation* hash, const uint16_t /* count */, const uint32_t /* input_length */, const uint8_t /* input */[],
+                        const uint32_t /* max_output_length */, uint8_t /* output */[])
+    {
+        ASSERT(hash != nullptr);
+        TRACE_L1(_T("SEC: batch hashing is not supported"));
+        return (0);
+    }
+
+    uint32_t hash_reset(HashImplementation* hash)
+    {
+        ASSERT(hash != nullptr);
+        return (hash->Reset());
+    }
+
+    bool hash_verify(HashImplementation* hash, const uint8_t length, const uint8_t expected[])
+    {
+        ASSERT(hash != nullptr);
+        ASSERT(expected != nullptr);
+
+        uint8_t digest[HASH_TYPE_SHA512];
+        uint8_t difference = 0;
+
+        const uint8_t size = hash->Calculate(sizeof(digest), digest);
+
+        // Truncated values are accepted down to half of the digest size (RFC 2104)
+        if ((size == 0) || (length > size) || ((length * 2) < size)) {
+            TRACE_L1(_T("SEC: can't verify a %i byte value against a %i byte digest"), length, size);
+            difference = 1;
+        } else {
+            // Constant time, every byte is compared
+            for (uint8_t index = 0; index < length; index++) {
+                difference |= (digest[index] ^ expected[index]);
+            }
+        }
+
+        return (difference == 0);
+    }
+
+    uint32_t hash_derive_keys(VaultImplementation* vault, const hash_type /* type */, const uint32_t /* secret_id */,
+                              const uint16_t /* salt_length */, const uint8_t /* salt */[], const uint16_t /* info_length */, const uint8_t /* info */[],
+                              const uint8_t /* count */, const uint16_t /* key_lengths */[], uint32_t /* key_ids */[])
+    {
+        ASSERT(vault != nullptr);
+        // SEC processor keys can only be derived from the root key, not from arbitrary vault secrets
+        TRACE_L1(_T("SEC: HKDF key derivation is not supported"));
+        return (WPEFramework::Core::ERROR_NOT_SUPPORTED);
+    }
+
 } // extern "C"
 
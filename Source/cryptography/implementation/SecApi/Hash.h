@@ -26,12 +26,24 @@
 #include <hash_implementation.h>
 #include <core/core.h>
 #include "Vault.h"
+#include "../Statistics.h"
 
 struct HashImplementation {
+    HashImplementation()
+        : Statistic(CRYPTOGRAPHY_OPERATION_HASH)
+        , Size(0)
+    {
+    }
+
     virtual uint32_t Ingest(const uint32_t length, const uint8_t data[]) = 0;
     virtual uint8_t Calculate(const uint8_t maxLength, uint8_t data[]) = 0;
+    virtual uint32_t Reset() = 0;
 
     virtual ~HashImplementation() { }
+
+    // Operation and digest size the statistics of the ingested data are recorded under
+    cryptographyoperation Statistic;
+    uint8_t Size;
 };
 
 struct HashAlg {
@@ -65,10 +77,14 @@ namespace Implementation {
         Handle* handle = new Handle;
         Sec_KeyHandle* sec_key = nullptr;
         SEC_OBJECTID _id_sec;
+        Sec_DigestAlgorithm _digestAlg = SEC_DIGESTALGORITHM_NUM;
+        Sec_MacAlgorithm _macAlg = SEC_MACALGORITHM_NUM;
+        bool _active = false;
 
     public:
         uint32_t Ingest(const uint32_t length, const uint8_t* data) override;
         uint8_t Calculate(const uint8_t maxLength, uint8_t* data) override;
+        uint32_t Reset() override;
 
     };
 
@@ -84,6 +100,7 @@ namespace Implementation {
         HashTypeNetflix(const Implementation::VaultNetflix* vault, const uint32_t secretId);
         uint32_t Ingest(const uint32_t length, const uint8_t* data) override;
         uint8_t Calculate(const uint8_t maxLength, uint8_t* data) override;
+        uint32_t Reset() override;
     };
 
 } // namespace Implementation
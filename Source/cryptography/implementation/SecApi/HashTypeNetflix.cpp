@@ -99,3 +99,17 @@ uint8_t Implementation::HashTypeNetflix::Calculate(const uint8_t maxLength, uint
     return (result);
 }
 
+/*********************************************************************
+ * @function Reset
+ *
+ * @brief    Drop the ingested data, so a new hmac can be calculated
+ *           with the same key
+ *
+ * @return status success/failure
+ *
+ *********************************************************************/
+uint32_t Implementation::HashTypeNetflix::Reset()
+{
+    _buffer.clear();
+    return (_failure ? WPEFramework::Core::ERROR_GENERAL : WPEFramework::Core::ERROR_NONE);
+}
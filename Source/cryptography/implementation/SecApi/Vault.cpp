@@ -21,6 +21,7 @@
 #include <vault_implementation.h>
 #include <cryptalgo/cryptalgo.h>
 #include "Vault.h"
+#include "../Statistics.h"
 
 namespace Implementation {
 
@@ -606,6 +607,7 @@ extern "C" {
     uint32_t vault_import(VaultImplementation* vault, const uint16_t length, const uint8_t data[])
     {
         ASSERT(vault != nullptr);
+        Implementation::Statistics::Scope scope(CRYPTOGRAPHY_OPERATION_VAULT_IMPORT, 0, 0, length);
         if (Implementation::vaultId == CRYPTOGRAPHY_VAULT_NETFLIX) {
             TRACE_L2(_T("SEC:vault_import netflix \n"));
             Implementation::VaultNetflix* vaultnetflixImpl = reinterpret_cast<Implementation::VaultNetflix*>(vault);
@@ -621,6 +623,7 @@ extern "C" {
     uint16_t vault_export(const VaultImplementation* vault, const uint32_t id, const uint16_t max_length, uint8_t data[])
     {
         ASSERT(vault != nullptr);
+        Implementation::Statistics::Scope scope(CRYPTOGRAPHY_OPERATION_VAULT_EXPORT, 0);
         uint16_t size = 0;
         if (Implementation::vaultId == CRYPTOGRAPHY_VAULT_NETFLIX) {
             TRACE_L2(_T("SEC:vault_export netflix \n"));
@@ -632,12 +635,14 @@ extern "C" {
             const Implementation::Vault* vaultImpl = reinterpret_cast<const Implementation::Vault*>(vault);
             size = vaultImpl->Export(id, max_length, data);
         }
+        scope.Bytes(size);
         return size;
     }
 
     uint32_t vault_set(VaultImplementation* vault, const uint16_t length, const uint8_t data[])
     {
         ASSERT(vault != nullptr);
+        Implementation::Statistics::Scope scope(CRYPTOGRAPHY_OPERATION_VAULT_SET, 0, 0, length);
         if (Implementation::vaultId == CRYPTOGRAPHY_VAULT_NETFLIX) {
             TRACE_L2(_T("SEC:vault_set netflix\n"));
             Implementation::VaultNetflix* vaultnetflixImpl = reinterpret_cast<Implementation::VaultNetflix*>(vault);
@@ -653,6 +658,7 @@ extern "C" {
     uint16_t vault_get(const VaultImplementation* vault, const uint32_t id, const uint16_t max_length, uint8_t data[])
     {
         ASSERT(vault != nullptr);
+        Implementation::Statistics::Scope scope(CRYPTOGRAPHY_OPERATION_VAULT_GET, 0);
         uint16_t size = 0;
         if (Implementation::vaultId == CRYPTOGRAPHY_VAULT_NETFLIX) {
             TRACE_L2(_T("SEC:vault_get \n"));
@@ -664,12 +670,14 @@ extern "C" {
             const Implementation::Vault* vaultImpl = reinterpret_cast<const Implementation::Vault*>(vault);
             size = vaultImpl->Get(id, max_length, data);
         }
+        scope.Bytes(size);
         return size;
     }
 
     bool vault_delete(VaultImplementation* vault, const uint32_t id)
     {
         ASSERT(vault != nullptr);
+        Implementation::Statistics::Scope scope(CRYPTOGRAPHY_OPERATION_VAULT_DELETE, 0);
         if (Implementation::vaultId == CRYPTOGRAPHY_VAULT_NETFLIX) {
             TRACE_L2(_T("SEC:vault_delete netflix \n"));
             Implementation::VaultNetflix* vaultnetflixImpl = reinterpret_cast<Implementation::VaultNetflix*>(vault);
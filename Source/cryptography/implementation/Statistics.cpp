@@ -0,0 +1,155 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 Metrological
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../Module.h"
+
+#include "Statistics.h"
+
+namespace Implementation {
+
+/* static */ std::atomic<bool> Statistics::_enabled(::getenv(_T("CRYPTOGRAPHY_STATISTICS")) != nullptr);
+
+/* static */ Statistics& Statistics::Instance()
+{
+    static Statistics instance;
+    return (instance);
+}
+
+Statistics::Statistics()
+{
+    for (uint8_t operation = 0; operation < OPERATIONS; operation++) {
+        for (Counters& counters : _counters[operation]) {
+            counters.Key = 0;
+        }
+    }
+
+    Reset();
+}
+
+void Statistics::Record(const cryptographyoperation operation, const uint8_t algorithm, const uint8_t mode, const uint32_t bytes, const uint64_t nanoseconds)
+{
+    ASSERT(operation < OPERATIONS);
+
+    const uint16_t key = (((static_cast<uint16_t>(algorithm) << 8) | mode) + 1);
+    Counters* entry = nullptr;
+
+    if (operation < OPERATIONS) {
+        // Claim a free slot for a combination seen for the first time
+        for (uint8_t index = 0; (index < VARIANTS) && (entry == nullptr); index++) {
+            Counters& counters(_counters[operation][index]);
+            uint16_t current = counters.Key.load(std::memory_order_relaxed);
+
+            if ((current == 0) && (counters.Key.compare_exchange_strong(current, key) == true)) {
+                entry = &counters;
+            } else if (current == key) {
+                entry = &counters;
+            }
+        }
+    }
+
+    if (entry != nullptr) {
+        const uint64_t microseconds = (nanoseconds / 1000);
+        uint8_t bucket = 0;
+
+        while ((bucket < (CRYPTOGRAPHY_LATENCY_BUCKETS - 1)) && ((microseconds >> bucket) != 0)) {
+            bucket++;
+        }
+
+        entry->Calls.fetch_add(1, std::memory_order_relaxed);
+        entry->Bytes.fetch_add(bytes, std::memory_order_relaxed);
+        entry->Nanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+        entry->Latency[bucket].fetch_add(1, std::memory_order_relaxed);
+    } else {
+        TRACE_L1("No room for the statistics of operation %i, algorithm %i, mode %i", operation, algorithm, mode);
+    }
+}
+
+uint16_t Statistics::Query(const uint16_t maxCount, cryptographystatistics records[]) const
+{
+    uint16_t result = 0;
+
+    for (uint8_t operation = 0; (operation < OPERATIONS) && (result < maxCount); operation++) {
+        for (uint8_t index = 0; (index < VARIANTS) && (result < maxCount); index++) {
+            const Counters& counters(_counters[operation][index]);
+            const uint16_t key = counters.Key.load(std::memory_order_relaxed);
+            const uint64_t calls = counters.Calls.load(std::memory_order_relaxed);
+
+            if ((key != 0) && (calls != 0)) {
+                cryptographystatistics& record(records[result++]);
+
+                ::memset(&record, 0, sizeof(record));
+                record.operation = operation;
+                record.algorithm = static_cast<uint8_t>((key - 1) >> 8);
+                record.mode = static_cast<uint8_t>((key - 1) & 0xFF);
+                record.calls = calls;
+                record.bytes = counters.Bytes.load(std::memory_order_relaxed);
+                record.nanoseconds = counters.Nanoseconds.load(std::memory_order_relaxed);
+
+                for (uint8_t bucket = 0; bucket < CRYPTOGRAPHY_LATENCY_BUCKETS; bucket++) {
+                    record.latency[bucket] = counters.Latency[bucket].load(std::memory_order_relaxed);
+                }
+            }
+        }
+    }
+
+    return (result);
+}
+
+void Statistics::Reset()
+{
+    // Slots stay claimed, a combination that was used once is likely to be used again
+    for (uint8_t operation = 0; operation < OPERATIONS; operation++) {
+        for (Counters& counters : _counters[operation]) {
+            counters.Calls = 0;
+            counters.Bytes = 0;
+            counters.Nanoseconds = 0;
+
+            for (std::atomic<uint32_t>& bucket : counters.Latency) {
+                bucket = 0;
+            }
+        }
+    }
+}
+
+} // namespace Implementation
+
+extern "C" {
+
+void statistics_enable(const bool enable)
+{
+    Implementation::Statistics::Enable(enable);
+}
+
+bool statistics_enabled(void)
+{
+    return (Implementation::Statistics::IsEnabled());
+}
+
+uint16_t statistics_query(const uint16_t max_count, struct cryptographystatistics records[])
+{
+    ASSERT((max_count == 0) || (records != nullptr));
+    return (Implementation::Statistics::Instance().Query(max_count, records));
+}
+
+void statistics_reset(void)
+{
+    Implementation::Statistics::Instance().Reset();
+}
+
+} // extern "C"
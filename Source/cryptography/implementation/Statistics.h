@@ -0,0 +1,124 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 Metrological
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+
+#include "statistics_implementation.h"
+
+namespace Implementation {
+
+    // Call counts, bytes processed and a latency histogram per operation, algorithm and mode. Operations are
+    // instrumented with a Scope, which only tests a flag when the collection is switched off. All counters are
+    // atomics, so recording an operation takes no locks either.
+    class Statistics {
+    public:
+        static constexpr uint8_t OPERATIONS = (CRYPTOGRAPHY_OPERATION_VAULT_DELETE + 1);
+
+        // Distinct algorithm and mode combinations per operation, enough for all AES modes and key sizes
+        static constexpr uint8_t VARIANTS = 24;
+
+    private:
+        struct Counters {
+            std::atomic<uint16_t> Key; // 0 while unused, otherwise ((algorithm << 8) | mode) + 1
+            std::atomic<uint64_t> Calls;
+            std::atomic<uint64_t> Bytes;
+            std::atomic<uint64_t> Nanoseconds;
+            std::atomic<uint32_t> Latency[CRYPTOGRAPHY_LATENCY_BUCKETS];
+        };
+
+    public:
+        class Scope {
+        public:
+            Scope() = delete;
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+            Scope(const cryptographyoperation operation, const uint8_t algorithm, const uint8_t mode = 0, const uint32_t bytes = 0)
+                : _enabled(Statistics::IsEnabled())
+                , _operation(operation)
+                , _algorithm(algorithm)
+                , _mode(mode)
+                , _bytes(bytes)
+                , _start()
+            {
+                if (_enabled == true) {
+                    _start = std::chrono::steady_clock::now();
+                }
+            }
+
+            ~Scope()
+            {
+                if (_enabled == true) {
+                    const std::chrono::nanoseconds duration(std::chrono::steady_clock::now() - _start);
+                    Statistics::Instance().Record(_operation, _algorithm, _mode, _bytes, static_cast<uint64_t>(duration.count()));
+                }
+            }
+
+        public:
+            // For operations that only know how much data they processed once done
+            void Bytes(const uint32_t bytes)
+            {
+                _bytes = bytes;
+            }
+
+        private:
+            const bool _enabled;
+            const cryptographyoperation _operation;
+            const uint8_t _algorithm;
+            const uint8_t _mode;
+            uint32_t _bytes;
+            std::chrono::steady_clock::time_point _start;
+        };
+
+    public:
+        Statistics(const Statistics&) = delete;
+        Statistics& operator=(const Statistics&) = delete;
+
+        static Statistics& Instance();
+
+        static bool IsEnabled()
+        {
+            return (_enabled.load(std::memory_order_relaxed));
+        }
+
+        static void Enable(const bool enable)
+        {
+            _enabled.store(enable, std::memory_order_relaxed);
+        }
+
+    public:
+        void Record(const cryptographyoperation operation, const uint8_t algorithm, const uint8_t mode, const uint32_t bytes, const uint64_t nanoseconds);
+        uint16_t Query(const uint16_t maxCount, cryptographystatistics records[]) const;
+        void Reset();
+
+    private:
+        Statistics();
+        ~Statistics() = default;
+
+    private:
+        static std::atomic<bool> _enabled;
+        Counters _counters[OPERATIONS][VARIANTS];
+    };
+
+} // namespace Implementation
@@ -31,6 +31,7 @@
 struct SigningImplementation {
     virtual void Ingest(const uint16_t length, const uint8_t data[]) = 0;
     virtual uint8_t Calculate(const uint8_t maxLength, uint8_t data[]) = 0;
+    virtual uint32_t Reset() = 0;
 
     virtual ~SigningImplementation() { }
 };
@@ -105,6 +106,19 @@ public:
         return (length);
     }
 
+    uint32_t Reset() override
+    {
+        uint32_t result = WPEFramework::Core::ERROR_GENERAL;
+
+        if (_hash != nullptr) {
+            // The HMAC flavours re-apply the inner key pad on reset.
+            _hash->Reset();
+            result = WPEFramework::Core::ERROR_NONE;
+        }
+
+        return (result);
+    }
+
 private:
     HASH* _hash;
 };
@@ -196,4 +210,11 @@ uint8_t signing_calculate(SigningImplementation* signing, const uint8_t max_leng
     return (signing->Calculate(max_length, data));
 }
 
+uint32_t signing_reset(SigningImplementation* signing)
+{
+    ASSERT(signing != nullptr);
+
+    return (signing->Reset());
+}
+
 } // extern "C"
@@ -41,9 +41,7 @@ const uint32_t encryptionIVId = 2;
 }
 
 Vault::Vault()
-    : _lock()
-    , _items()
-    , _lastHandle(0x80000000)
+    : _table(1)
 {
     typedef uint8_t pkey[16];
 
@@ -54,13 +52,10 @@ Vault::Vault()
         { 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff, 0x11, 0x22, 0x33 },
     };
 
-    _lock.Lock();
     for (uint8_t i = 0; i < (sizeof(privateKeys) / sizeof(pkey)); i++) {
-        _items.emplace(std::piecewise_construct,
-                    std::forward_as_tuple(i + 1),
-                    std::forward_as_tuple(false, sizeof(privateKeys[i]), privateKeys[i]));
+        VARIABLE_IS_NOT_USED uint32_t id = _table.Insert(sizeof(privateKeys[i]), privateKeys[i], false, (i + 1));
+        ASSERT(id == static_cast<uint32_t>(i + 1));
     }
-    _lock.Unlock();
 }
 
 uint16_t Vault::Cipher(bool encrypt, const uint16_t inSize, const uint8_t input[], const uint16_t maxOutSize, uint8_t output[]) const
@@ -81,13 +76,11 @@ uint16_t Vault::Cipher(bool encrypt, const uint16_t inSize, const uint8_t input[
 
 uint16_t Vault::Size(const uint32_t id, bool allowSealed) const
 {
-    uint16_t size = 0;
+    bool exportable = false;
+    uint16_t size = _table.Copy(id, 0, nullptr, exportable);
 
-    _lock.Lock();
-    auto it = _items.find(id);
-    if (it != _items.end()) {
-        if ((allowSealed == true) || (*it).second.IsExportable() == true) {
-            size = (*it).second.Size();
+    if (size != 0) {
+        if ((allowSealed == true) || (exportable == true)) {
             TRACE_L2(_T("Blob id 0x%08x size: %i"), id, size);
         } else {
             TRACE_L2(_T("Blob id 0x%08x is sealed"), id);
@@ -96,7 +89,6 @@ uint16_t Vault::Size(const uint32_t id, bool allowSealed) const
     } else {
         TRACE_L1(_T("Failed to look up blob id 0x%08x"), id);
     }
-    _lock.Unlock();
 
     return (size);
 }
@@ -106,22 +98,17 @@ uint32_t Vault::Import(const uint16_t size, const uint8_t blob[], bool exportabl
     uint32_t id = 0;
 
     if (size > 0) {
-        _lock.Lock();
-        id = (_lastHandle + 1);
+        uint8_t* buf = reinterpret_cast<uint8_t*>(ALLOCA(USHRT_MAX));
+        uint16_t len = Cipher(true, size, blob, USHRT_MAX, buf);
 
-        if (id != 0) {
-            uint8_t* buf = reinterpret_cast<uint8_t*>(ALLOCA(USHRT_MAX));
-            uint16_t len = Cipher(true, size, blob, USHRT_MAX, buf);
-
-            _items.emplace(std::piecewise_construct,
-                           std::forward_as_tuple(id),
-                           std::forward_as_tuple(exportable, len, buf));
+        id = _table.Insert(len, buf, exportable);
 
-            _lastHandle = id;
+        // shred :)
+        ::memset(buf, 0xFF, len);
 
+        if (id != 0) {
             TRACE_L2(_T("Added a %s data blob of size %i as id 0x%08x"), (exportable? "clear": "sealed"), len, id);
         }
-        _lock.Unlock();
     }
 
     return (id);
@@ -132,20 +119,24 @@ uint16_t Vault::Export(const uint32_t id, const uint16_t size, uint8_t blob[], b
     uint16_t outSize = 0;
 
     if (size > 0) {
-        _lock.Lock();
-        auto it = _items.find(id);
-        if (it != _items.end()) {
-            if ((allowSealed == true) || ((*it).second.IsExportable() == true)) {
-                outSize = Cipher(false, (*it).second.Size(), (*it).second.Buffer(), size, blob);
+        uint8_t* buf = reinterpret_cast<uint8_t*>(ALLOCA(USHRT_MAX));
+        bool exportable = false;
+        const uint16_t length = _table.Copy(id, USHRT_MAX, buf, exportable);
+
+        if (length != 0) {
+            if ((allowSealed == true) || (exportable == true)) {
+                outSize = Cipher(false, length, buf, size, blob);
 
                 TRACE_L2(_T("Exported %i bytes from blob id 0x%08x"), outSize, id);
             } else {
                 TRACE_L1(_T("Blob id 0x%08x is sealed, can't export"), id);
             }
+
+            // shred :)
+            ::memset(buf, 0xFF, length);
         } else {
             TRACE_L1(_T("Failed to look up blob id 0x%08x"), id);
         }
-        _lock.Unlock();
     }
 
     return (outSize);
@@ -156,18 +147,11 @@ uint32_t Vault::Put(const uint16_t size, const uint8_t blob[])
     uint32_t id = 0;
 
     if (size > 0) {
-        _lock.Lock();
-        id = (_lastHandle + 1);
-        if (id != 0) {
-            _items.emplace(std::piecewise_construct,
-                           std::forward_as_tuple(id),
-                           std::forward_as_tuple(false, size, blob));
-
-            _lastHandle = id;
+        id = _table.Insert(size, blob, false);
 
+        if (id != 0) {
             TRACE_L2(_T("Inserted a sealed data blob of size %i as id 0x%08x"), size, id);
         }
-        _lock.Unlock();
     }
 
     return (id);
@@ -178,14 +162,12 @@ uint16_t Vault::Get(const uint32_t id, const uint16_t size, uint8_t blob[]) cons
     uint16_t result = 0;
 
     if (size > 0) {
-        _lock.Lock();
-        auto it = _items.find(id);
-        if (it != _items.end()) {
-            result = std::min(size, static_cast<uint16_t>((*it).second.Size()));
-            ::memcpy(blob, (*it).second.Buffer(), result);
+        bool exportable = false;
+        result = std::min(size, _table.Copy(id, size, blob, exportable));
+
+        if (result != 0) {
             TRACE_L2(_T("Retrieved a sealed data blob id 0x%08x of size %i bytes"), id, result);
         }
-        _lock.Unlock();
     }
 
     return (result);
@@ -193,17 +175,7 @@ uint16_t Vault::Get(const uint32_t id, const uint16_t size, uint8_t blob[]) cons
 
 bool Vault::Dispose(const uint32_t id)
 {
-    bool result = false;
-
-   _lock.Lock();
-    auto it = _items.find(id);
-    if (it != _items.end()) {
-        _items.erase(it);
-        result = true;
-    }
-    _lock.Unlock();
-
-    return (result);
+    return (_table.Remove(id));
 }
 
 } // namespace Implementation
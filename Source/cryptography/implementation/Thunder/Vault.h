@@ -18,7 +18,7 @@
  */
 
 #include "../../Module.h"
-#include <map>
+#include "../HandleTable.h"
 
 namespace Implementation {
 
@@ -34,31 +34,6 @@ public:
     Vault(Vault const&) = delete;
     void operator=(Vault const&) = delete;
 
-public:
-    class Element : public WPEFramework::Core::DataStore {
-    public:
-        Element(bool exportable, const uint16_t size)
-            : WPEFramework::Core::DataStore(size)
-            , _exportable(exportable)
-        {
-        }
-
-        Element(bool exportable, const uint16_t size, const uint8_t* buffer)
-            : WPEFramework::Core::DataStore(size)
-            , _exportable(exportable)
-        {
-            Copy(buffer, size);
-        }
-
-        bool IsExportable() const
-        {
-            return _exportable;
-        }
-
-    private:
-        bool _exportable;
-    };
-
 public:
     uint16_t Size(const uint32_t id, bool allowSealed = false) const;
     uint32_t Import(const uint16_t size, const uint8_t blob[], bool exportable = false);
@@ -71,9 +46,7 @@ private:
     uint16_t Cipher(bool encrypt, const uint16_t inSize, const uint8_t input[], const uint16_t maxOutSize, uint8_t output[]) const;
 
 private:
-    mutable WPEFramework::Core::CriticalSection _lock;
-    std::map<uint32_t, Element> _items;
-    uint32_t _lastHandle;
+    HandleTable _table;
 };
 
 } // namespace Implementation
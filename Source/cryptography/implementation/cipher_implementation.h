@@ -34,6 +34,7 @@ typedef enum {
     AES_MODE_CFB8,
     AES_MODE_CFB128,
     AES_MODE_CTR,
+    AES_MODE_GCM, /* ciphertext is followed by a 16 byte authentication tag, IV is 12 bytes */
 } aes_mode;
 
 struct CipherImplementation;
@@ -50,6 +51,40 @@ int32_t cipher_encrypt(const struct CipherImplementation* cipher, const uint8_t
 int32_t cipher_decrypt(const struct CipherImplementation* cipher, const uint8_t iv_length, const uint8_t iv[],
                         const uint32_t input_length, const uint8_t input[], const uint32_t max_output_length, uint8_t output[]);
 
+
+/* Output buffer size needed for an operation on input_length bytes: exact when encrypting, an upper bound
+   when decrypting with padding (the actual length is only known once the padding is removed) */
+uint32_t cipher_output_size(const struct CipherImplementation* cipher, const bool encrypt, const uint32_t input_length);
+
+/* The result replaces the length bytes of input in data, max_length being the size of the data buffer */
+int32_t cipher_encrypt_in_place(const struct CipherImplementation* cipher, const uint8_t iv_length, const uint8_t iv[],
+                        const uint32_t length, const uint32_t max_length, uint8_t data[]);
+
+int32_t cipher_decrypt_in_place(const struct CipherImplementation* cipher, const uint8_t iv_length, const uint8_t iv[],
+                        const uint32_t length, const uint32_t max_length, uint8_t data[]);
+
+
+int32_t cipher_batch(const struct CipherImplementation* cipher, const bool encrypt, const uint8_t iv_length, const uint16_t count,
+                        const uint32_t input_length, const uint8_t input[], const uint32_t max_output_length, uint8_t output[]);
+
+
+uint32_t cipher_stream_initialize(struct CipherImplementation* cipher, const bool encrypt, const uint8_t iv_length, const uint8_t iv[]);
+
+int32_t cipher_stream_update(struct CipherImplementation* cipher, const uint32_t input_length, const uint8_t input[],
+                        const uint32_t max_output_length, uint8_t output[]);
+
+int32_t cipher_stream_finalize(struct CipherImplementation* cipher, const uint32_t max_output_length, uint8_t output[]);
+
+
+/* Authenticated modes only (AES_MODE_GCM), aad is covered by the tag but neither encrypted nor part of the output */
+int32_t cipher_encrypt_authenticated(const struct CipherImplementation* cipher, const uint8_t iv_length, const uint8_t iv[],
+                        const uint32_t aad_length, const uint8_t aad[],
+                        const uint32_t input_length, const uint8_t input[], const uint32_t max_output_length, uint8_t output[]);
+
+int32_t cipher_decrypt_authenticated(const struct CipherImplementation* cipher, const uint8_t iv_length, const uint8_t iv[],
+                        const uint32_t aad_length, const uint8_t aad[],
+                        const uint32_t input_length, const uint8_t input[], const uint32_t max_output_length, uint8_t output[]);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
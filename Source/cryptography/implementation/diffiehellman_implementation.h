@@ -26,10 +26,19 @@
 extern "C" {
 #endif
 
+typedef enum {
+    CURVE_X25519, /* public key: 32 bytes (RFC 7748) */
+    CURVE_P256 /* public key: 65 bytes, uncompressed point */
+} curve_type;
+
 uint32_t diffiehellman_generate(struct VaultImplementation* vault,
                                 const uint8_t generator, const uint16_t modulusSize, const uint8_t modulus[],
                                 uint32_t* private_key_id, uint32_t* public_key_id);
 
+uint32_t diffiehellman_generate_ec(struct VaultImplementation* vault, const curve_type curve,
+                                   uint32_t* private_key_id, uint32_t* public_key_id);
+
+/* Works for both finite field and elliptic curve private keys, the peer public key has to match */
 uint32_t diffiehellman_derive(struct VaultImplementation* vault,
                               const uint32_t private_key_id, const uint32_t peer_public_key_id, uint32_t* secret_id);
 
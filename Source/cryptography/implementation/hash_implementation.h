@@ -48,6 +48,20 @@ uint32_t hash_ingest(struct HashImplementation* signing, const uint32_t length,
 
 uint8_t hash_calculate(struct HashImplementation* signing, const uint8_t max_length, uint8_t data[]);
 
+uint16_t hash_batch(struct HashImplementation* signing, const uint16_t count, const uint32_t input_length, const uint8_t input[],
+                    const uint32_t max_output_length, uint8_t output[]);
+
+uint32_t hash_reset(struct HashImplementation* signing);
+
+/* Calculate the hash and compare it to the expected (possibly truncated) value in constant time */
+bool hash_verify(struct HashImplementation* signing, const uint8_t length, const uint8_t expected[]);
+
+/* HKDF (RFC 5869) of a vault secret, the output is split into count keys of key_lengths bytes each (in order) which
+   are stored sealed in the same vault, their IDs go to key_ids. Returns an error code, no key is stored on failure */
+uint32_t hash_derive_keys(struct VaultImplementation* vault, const hash_type type, const uint32_t secret_id,
+                          const uint16_t salt_length, const uint8_t salt[], const uint16_t info_length, const uint8_t info[],
+                          const uint8_t count, const uint16_t key_lengths[], uint32_t key_ids[]);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
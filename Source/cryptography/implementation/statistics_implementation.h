@@ -0,0 +1,43 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 Metrological
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cryptography_statistics.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Switch the collection of per-operation statistics on or off (off, unless CRYPTOGRAPHY_STATISTICS is set in the environment) */
+void statistics_enable(const bool enable);
+
+bool statistics_enabled(void);
+
+/* Copy out the statistics of all operations used so far (returns the number of records stored) */
+uint16_t statistics_query(const uint16_t max_count, struct cryptographystatistics records[]);
+
+/* Clear all collected statistics */
+void statistics_reset(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
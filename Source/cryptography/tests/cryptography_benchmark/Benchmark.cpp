@@ -0,0 +1,713 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 Metrological
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures the throughput of the cryptography library for the backend it was built with, through the
+// C API of the implementation, the in-process ICryptography interface and (if a connector is given)
+// the COM-RPC path. Results are written as JSON, so runs on different backends or builds can be compared.
+//
+//   cgbenchmark [--connector <path>] [--netflix] [--paths capi,interface,rpc] [--sizes 16,1024,...]
+//               [--threads 1,2,4] [--duration <ms>] [--filter <operation prefix>] [--output <file>]
+
+#include "Module.h"
+
+#include <cryptography.h>
+
+#include <cipher_implementation.h>
+#include <diffiehellman_implementation.h>
+#include <hash_implementation.h>
+#include <vault_implementation.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef CRYPTOGRAPHY_BACKEND
+#define CRYPTOGRAPHY_BACKEND "unknown"
+#endif
+
+namespace Thunder = WPEFramework;
+
+namespace {
+
+static const uint8_t dhGenerator = 5;
+
+static const uint8_t dhPrime1024[] = {
+    0x96, 0x94, 0xe9, 0xd8, 0xd9, 0x3a, 0x5a, 0xc7, 0x4c, 0x50, 0x9b, 0x4b, 0xbc, 0xe8, 0x5e, 0x92,
+    0x13, 0x2c, 0xd1, 0x9c, 0xce, 0x47, 0x7d, 0x1a, 0x7e, 0x47, 0xd5, 0x27, 0xd9, 0xec, 0x29, 0x15,
+    0x15, 0xf0, 0xb8, 0xb3, 0xe1, 0xea, 0xed, 0x50, 0x06, 0xe1, 0xb1, 0xb9, 0x1e, 0xa2, 0x5b, 0x91,
+    0xa0, 0x1b, 0x10, 0xe2, 0xe8, 0x34, 0xb8, 0xd6, 0x60, 0xb2, 0xe3, 0x21, 0xad, 0x64, 0x4c, 0xe1,
+    0xa8, 0x3b, 0x32, 0x8d, 0x90, 0x14, 0xee, 0x7e, 0x16, 0xf1, 0xe4, 0x4f, 0xfe, 0x89, 0x57, 0x9a,
+    0xc3, 0xee, 0x47, 0xd6, 0x68, 0xb6, 0xb7, 0x66, 0x87, 0xc2, 0xfe, 0x90, 0xa3, 0x5b, 0x5e, 0x60,
+    0x28, 0xfd, 0x04, 0xef, 0xea, 0x88, 0x23, 0x73, 0xec, 0xf6, 0x0b, 0xa2, 0xf6, 0x37, 0xe4, 0xcd,
+    0xaa, 0x1b, 0x60, 0x89, 0xd6, 0xc0, 0xb5, 0x61, 0xa8, 0xe5, 0x20, 0xe7, 0x96, 0xde, 0x27, 0xdf
+};
+
+static const uint8_t aesKey[] = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff, 0x11 };
+
+static const uint8_t hmacKey[] = { 0x4a, 0x65, 0x66, 0x65, 0x4a, 0x65, 0x66, 0x65, 0x4a, 0x65, 0x66, 0x65, 0x4a, 0x65, 0x66, 0x65,
+                                   0x4a, 0x65, 0x66, 0x65, 0x4a, 0x65, 0x66, 0x65, 0x4a, 0x65, 0x66, 0x65, 0x4a, 0x65, 0x66, 0x65 };
+
+static const uint8_t iv[] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+
+// Room for padding or an authentication tag
+static constexpr uint32_t Overhead = 32;
+
+// A single timed call, bound to objects owned by the thread running it
+typedef std::function<bool()> Operation;
+
+// The route into the library that is measured
+class Path {
+public:
+    virtual ~Path() = default;
+
+    virtual const char* Name() const = 0;
+
+    virtual uint32_t Import(const uint16_t length, const uint8_t data[]) = 0;
+    virtual uint16_t Export(const uint32_t id, const uint16_t maxLength, uint8_t data[]) = 0;
+    virtual bool Delete(const uint32_t id) = 0;
+
+    // A key of 0 means a plain hash, HMAC otherwise
+    virtual Operation Hash(const hash_type type, const uint32_t keyId, const uint32_t length, const uint8_t data[]) = 0;
+    virtual Operation Cipher(const aes_mode mode, const uint32_t keyId, const bool encrypt, const uint8_t ivLength,
+                             const uint32_t length, const uint8_t input[], uint8_t output[]) = 0;
+
+    virtual bool Generate(uint32_t& privateKeyId, uint32_t& publicKeyId) = 0;
+    virtual bool Derive(const uint32_t privateKeyId, const uint32_t publicKeyId, uint32_t& secretId) = 0;
+};
+
+class CAPI : public Path {
+public:
+    CAPI(const CAPI&) = delete;
+    CAPI& operator=(const CAPI&) = delete;
+
+    CAPI(VaultImplementation* vault)
+        : _vault(vault)
+    {
+    }
+    ~CAPI() override = default;
+
+public:
+    const char* Name() const override
+    {
+        return ("capi");
+    }
+
+    uint32_t Import(const uint16_t length, const uint8_t data[]) override
+    {
+        return (vault_import(_vault, length, data));
+    }
+    uint16_t Export(const uint32_t id, const uint16_t maxLength, uint8_t data[]) override
+    {
+        return (vault_export(_vault, id, maxLength, data));
+    }
+    bool Delete(const uint32_t id) override
+    {
+        return (vault_delete(_vault, id));
+    }
+
+    Operation Hash(const hash_type type, const uint32_t keyId, const uint32_t length, const uint8_t data[]) override
+    {
+        Operation result;
+
+        HashImplementation* implementation = (keyId == 0 ? hash_create(type) : hash_create_hmac(_vault, type, keyId));
+
+        if (implementation != nullptr) {
+            std::shared_ptr<HashImplementation> hash(implementation, hash_destroy);
+
+            result = [hash, type, length, data]() -> bool {
+                uint8_t digest[64];
+                return ((hash_reset(hash.get()) == 0) && (hash_ingest(hash.get(), length, data) == length) && (hash_calculate(hash.get(), sizeof(digest), digest) == type));
+            };
+        }
+
+        return (result);
+    }
+
+    Operation Cipher(const aes_mode mode, const uint32_t keyId, const bool encrypt, const uint8_t ivLength,
+                     const uint32_t length, const uint8_t input[], uint8_t output[]) override
+    {
+        Operation result;
+
+        CipherImplementation* implementation = cipher_create_aes(_vault, mode, keyId);
+
+        if (implementation != nullptr) {
+            std::shared_ptr<CipherImplementation> cipher(implementation, cipher_destroy);
+
+            result = [cipher, encrypt, ivLength, length, input, output]() -> bool {
+                return ((encrypt == true ? cipher_encrypt(cipher.get(), ivLength, iv, length, input, (length + Overhead), output)
+                                         : cipher_decrypt(cipher.get(), ivLength, iv, length, input, (length + Overhead), output)) > 0);
+            };
+        }
+
+        return (result);
+    }
+
+    bool Generate(uint32_t& privateKeyId, uint32_t& publicKeyId) override
+    {
+        return (diffiehellman_generate(_vault, dhGenerator, sizeof(dhPrime1024), dhPrime1024, &privateKeyId, &publicKeyId) == 0);
+    }
+    bool Derive(const uint32_t privateKeyId, const uint32_t publicKeyId, uint32_t& secretId) override
+    {
+        return (diffiehellman_derive(_vault, privateKeyId, publicKeyId, &secretId) == 0);
+    }
+
+private:
+    VaultImplementation* _vault;
+};
+
+// Both the in-process and the COM-RPC route, depending on how the ICryptography instance was obtained
+class Interface : public Path {
+public:
+    Interface(const Interface&) = delete;
+    Interface& operator=(const Interface&) = delete;
+
+    Interface(const char* name, Thunder::Cryptography::ICryptography* cryptography, Thunder::Cryptography::IVault* vault)
+        : _name(name)
+        , _cryptography(cryptography)
+        , _vault(vault)
+    {
+    }
+    ~Interface() override = default;
+
+public:
+    const char* Name() const override
+    {
+        return (_name);
+    }
+
+    uint32_t Import(const uint16_t length, const uint8_t data[]) override
+    {
+        return (_vault->Import(length, data));
+    }
+    uint16_t Export(const uint32_t id, const uint16_t maxLength, uint8_t data[]) override
+    {
+        return (_vault->Export(id, maxLength, data));
+    }
+    bool Delete(const uint32_t id) override
+    {
+        return (_vault->Delete(id));
+    }
+
+    Operation Hash(const hash_type type, const uint32_t keyId, const uint32_t length, const uint8_t data[]) override
+    {
+        Operation result;
+
+        const Thunder::Cryptography::hashtype hashType = static_cast<Thunder::Cryptography::hashtype>(type);
+        Thunder::Cryptography::IHash* implementation = (keyId == 0 ? _cryptography->Hash(hashType) : _vault->HMAC(hashType, keyId));
+
+        if (implementation != nullptr) {
+            std::shared_ptr<Thunder::Cryptography::IHash> hash(implementation, Release<Thunder::Cryptography::IHash>);
+
+            result = [hash, type, length, data]() -> bool {
+                uint8_t digest[64];
+                return ((hash->Reset() == Thunder::Core::ERROR_NONE) && (hash->Ingest(length, data) == length) && (hash->Calculate(sizeof(digest), digest) == type));
+            };
+        }
+
+        return (result);
+    }
+
+    Operation Cipher(const aes_mode mode, const uint32_t keyId, const bool encrypt, const uint8_t ivLength,
+                     const uint32_t length, const uint8_t input[], uint8_t output[]) override
+    {
+        Operation result;
+
+        Thunder::Cryptography::ICipher* implementation = _vault->AES(static_cast<Thunder::Cryptography::aesmode>(mode), keyId);
+
+        if (implementation != nullptr) {
+            std::shared_ptr<Thunder::Cryptography::ICipher> cipher(implementation, Release<Thunder::Cryptography::ICipher>);
+
+            result = [cipher, encrypt, ivLength, length, input, output]() -> bool {
+                return ((encrypt == true ? cipher->Encrypt(ivLength, iv, length, input, (length + Overhead), output)
+                                         : cipher->Decrypt(ivLength, iv, length, input, (length + Overhead), output)) > 0);
+            };
+        }
+
+        return (result);
+    }
+
+    bool Generate(uint32_t& privateKeyId, uint32_t& publicKeyId) override
+    {
+        bool result = false;
+
+        Thunder::Cryptography::IDiffieHellman* dh = _vault->DiffieHellman();
+
+        if (dh != nullptr) {
+            result = (dh->Generate(dhGenerator, sizeof(dhPrime1024), dhPrime1024, privateKeyId, publicKeyId) == Thunder::Core::ERROR_NONE);
+            dh->Release();
+        }
+
+        return (result);
+    }
+    bool Derive(const uint32_t privateKeyId, const uint32_t publicKeyId, uint32_t& secretId) override
+    {
+        bool result = false;
+
+        Thunder::Cryptography::IDiffieHellman* dh = _vault->DiffieHellman();
+
+        if (dh != nullptr) {
+            result = (dh->Derive(privateKeyId, publicKeyId, secretId) == Thunder::Core::ERROR_NONE);
+            dh->Release();
+        }
+
+        return (result);
+    }
+
+private:
+    template<typename INTERFACE>
+    static void Release(INTERFACE* object)
+    {
+        object->Release();
+    }
+
+private:
+    const char* _name;
+    Thunder::Cryptography::ICryptography* _cryptography;
+    Thunder::Cryptography::IVault* _vault;
+};
+
+// Vault entries and buffers needed by one thread of a measurement, cleaned up once it is done
+class Resources {
+public:
+    Resources(const Resources&) = delete;
+    Resources& operator=(const Resources&) = delete;
+
+    Resources(Path& path)
+        : _path(path)
+        , _keys()
+        , _buffers()
+    {
+    }
+    ~Resources()
+    {
+        for (const uint32_t id : _keys) {
+            _path.Delete(id);
+        }
+    }
+
+public:
+    void Key(const uint32_t id)
+    {
+        _keys.push_back(id);
+    }
+    uint8_t* Buffer(const uint32_t size)
+    {
+        _buffers.emplace_back(size);
+        return (_buffers.back().data());
+    }
+
+private:
+    Path& _path;
+    std::vector<uint32_t> _keys;
+    std::vector<std::vector<uint8_t>> _buffers;
+};
+
+struct Result {
+    std::string Path;
+    std::string Name;
+    uint32_t Size;
+    uint8_t Threads;
+    uint64_t Operations;
+    uint64_t Failures;
+    double Seconds;
+};
+
+class Runner {
+public:
+    // Creates the operation for one thread, returns an empty operation if it can not be set up
+    typedef std::function<Operation(Resources&)> Factory;
+
+    Runner(const Runner&) = delete;
+    Runner& operator=(const Runner&) = delete;
+
+    Runner(const uint32_t duration, const std::string& filter)
+        : _duration(duration)
+        , _filter(filter)
+        , _results()
+    {
+    }
+    ~Runner() = default;
+
+public:
+    void Measure(Path& path, const std::string& name, const uint32_t size, const uint8_t threads, const Factory& factory)
+    {
+        if (name.compare(0, _filter.length(), _filter) == 0) {
+            std::vector<std::unique_ptr<Resources>> resources;
+            std::vector<Operation> operations;
+
+            for (uint8_t index = 0; index < threads; index++) {
+                resources.emplace_back(new Resources(path));
+                operations.push_back(factory(*resources.back()));
+
+                // Warm up, also tells if this works at all on this backend
+                if ((!operations.back()) || (operations.back()() == false)) {
+                    fprintf(stderr, "%s/%s/%u: not available, skipped\n", path.Name(), name.c_str(), size);
+                    operations.clear();
+                    break;
+                }
+            }
+
+            if (operations.empty() == false) {
+                Result result = { path.Name(), name, size, threads, 0, 0, 0 };
+                Run(operations, result);
+                _results.push_back(result);
+
+                fprintf(stderr, "%s/%s/%u/%u: %.0f ops/s\n", path.Name(), name.c_str(), size, threads, (result.Operations / result.Seconds));
+            }
+        }
+    }
+
+    void Report(FILE* output) const
+    {
+        fprintf(output, "{\n  \"backend\": \"%s\",\n  \"duration_ms\": %u,\n  \"results\": [", CRYPTOGRAPHY_BACKEND, _duration);
+
+        for (size_t index = 0; index < _results.size(); index++) {
+            const Result& result = _results[index];
+            const double perSecond = (result.Operations / result.Seconds);
+
+            fprintf(output, "%s\n    { \"path\": \"%s\", \"operation\": \"%s\", \"size\": %u, \"threads\": %u, "
+                            "\"operations\": %llu, \"failures\": %llu, \"seconds\": %.6f, "
+                            "\"ops_per_second\": %.2f, \"mib_per_second\": %.3f, \"ns_per_operation\": %.1f }",
+                (index == 0 ? "" : ","), result.Path.c_str(), result.Name.c_str(), result.Size, result.Threads,
+                static_cast<unsigned long long>(result.Operations), static_cast<unsigned long long>(result.Failures), result.Seconds,
+                perSecond, ((perSecond * result.Size) / (1024.0 * 1024.0)),
+                (result.Operations != 0 ? ((result.Seconds * result.Threads * 1e9) / result.Operations) : 0.0));
+        }
+
+        fprintf(output, "\n  ]\n}\n");
+    }
+
+private:
+    void Run(std::vector<Operation>& operations, Result& result) const
+    {
+        typedef std::chrono::steady_clock Clock;
+
+        std::atomic<bool> start(false);
+        std::vector<uint64_t> counts(operations.size(), 0);
+        std::vector<uint64_t> failures(operations.size(), 0);
+        std::vector<std::thread> threads;
+        Clock::time_point deadline;
+
+        for (size_t index = 0; index < operations.size(); index++) {
+            threads.emplace_back([&, index]() {
+                while (start.load(std::memory_order_acquire) == false) {
+                    std::this_thread::yield();
+                }
+
+                while (Clock::now() < deadline) {
+                    if (operations[index]() == true) {
+                        counts[index]++;
+                    } else {
+                        failures[index]++;
+                    }
+                }
+            });
+        }
+
+        const Clock::time_point begin = Clock::now();
+        deadline = (begin + std::chrono::milliseconds(_duration));
+        start.store(true, std::memory_order_release);
+
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+
+        result.Seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+
+        for (size_t index = 0; index < operations.size(); index++) {
+            result.Operations += counts[index];
+            result.Failures += failures[index];
+        }
+    }
+
+private:
+    uint32_t _duration;
+    std::string _filter;
+    std::vector<Result> _results;
+};
+
+std::vector<uint32_t> List(const char* text)
+{
+    std::vector<uint32_t> result;
+
+    while ((text != nullptr) && (*text != '\0')) {
+        char* end = nullptr;
+        const unsigned long value = ::strtoul(text, &end, 10);
+
+        if (end == text) {
+            break;
+        }
+
+        if (value != 0) {
+            result.push_back(static_cast<uint32_t>(value));
+        }
+
+        text = (*end == ',' ? (end + 1) : end);
+    }
+
+    return (result);
+}
+
+void Benchmark(Runner& runner, Path& path, const std::vector<uint32_t>& sizes, const std::vector<uint32_t>& threadCounts, const uint8_t input[])
+{
+    struct HashType {
+        const char* Name;
+        hash_type Type;
+    };
+
+    struct AESMode {
+        const char* Name;
+        aes_mode Mode;
+        uint8_t IVLength;
+    };
+
+    static const HashType hashes[] = {
+        { "sha1", HASH_TYPE_SHA1 },
+        { "sha256", HASH_TYPE_SHA256 },
+        { "sha384", HASH_TYPE_SHA384 },
+        { "sha512", HASH_TYPE_SHA512 }
+    };
+
+    static const AESMode modes[] = {
+        { "ecb", AES_MODE_ECB, 16 },
+        { "cbc", AES_MODE_CBC, 16 },
+        { "ofb", AES_MODE_OFB, 16 },
+        { "cfb1", AES_MODE_CFB1, 16 },
+        { "cfb8", AES_MODE_CFB8, 16 },
+        { "cfb128", AES_MODE_CFB128, 16 },
+        { "ctr", AES_MODE_CTR, 16 },
+        { "gcm", AES_MODE_GCM, 12 }
+    };
+
+    const uint32_t aesKeyId = path.Import(sizeof(aesKey), aesKey);
+    const uint32_t hmacKeyId = path.Import(sizeof(hmacKey), hmacKey);
+
+    if ((aesKeyId == 0) || (hmacKeyId == 0)) {
+        fprintf(stderr, "%s: failed to import the keys, skipped\n", path.Name());
+    } else {
+        for (const uint32_t threads : threadCounts) {
+            runner.Measure(path, "vault-import-delete", sizeof(aesKey), threads, [&path](Resources&) -> Operation {
+                return ([&path]() -> bool {
+                    const uint32_t id = path.Import(sizeof(aesKey), aesKey);
+                    return ((id != 0) && (path.Delete(id) == true));
+                });
+            });
+
+            runner.Measure(path, "vault-export", sizeof(aesKey), threads, [&path](Resources& resources) -> Operation {
+                Operation result;
+                const uint32_t id = path.Import(sizeof(aesKey), aesKey);
+                if (id != 0) {
+                    resources.Key(id);
+                    uint8_t* buffer = resources.Buffer(sizeof(aesKey));
+                    result = [&path, id, buffer]() -> bool {
+                        return (path.Export(id, sizeof(aesKey), buffer) == sizeof(aesKey));
+                    };
+                }
+                return (result);
+            });
+
+            for (const uint32_t size : sizes) {
+                for (const HashType& hash : hashes) {
+                    runner.Measure(path, std::string("hash-") + hash.Name, size, threads, [&path, &hash, size, input](Resources&) -> Operation {
+                        return (path.Hash(hash.Type, 0, size, input));
+                    });
+                    runner.Measure(path, std::string("hmac-") + hash.Name, size, threads, [&path, &hash, hmacKeyId, size, input](Resources&) -> Operation {
+                        return (path.Hash(hash.Type, hmacKeyId, size, input));
+                    });
+                }
+
+                for (const AESMode& mode : modes) {
+                    runner.Measure(path, std::string("aes-") + mode.Name + "-encrypt", size, threads, [&path, &mode, aesKeyId, size, input](Resources& resources) -> Operation {
+                        return (path.Cipher(mode.Mode, aesKeyId, true, mode.IVLength, size, input, resources.Buffer(size + Overhead)));
+                    });
+
+                    // Decrypt what was encrypted, so padding and tags are valid
+                    runner.Measure(path, std::string("aes-") + mode.Name + "-decrypt", size, threads, [&path, &mode, aesKeyId, size, input](Resources& resources) -> Operation {
+                        Operation result;
+                        uint8_t* encrypted = resources.Buffer(size + Overhead);
+                        Operation encrypt = path.Cipher(mode.Mode, aesKeyId, true, mode.IVLength, size, input, encrypted);
+                        if ((encrypt) && (encrypt() == true)) {
+                            // Ciphertext length as produced for this mode
+                            const uint32_t length = ((mode.Mode == AES_MODE_ECB) || (mode.Mode == AES_MODE_CBC) ? (size + (16 - (size % 16)))
+                                                   : (mode.Mode == AES_MODE_GCM ? (size + 16) : size));
+                            result = path.Cipher(mode.Mode, aesKeyId, false, mode.IVLength, length, encrypted, resources.Buffer(length + Overhead));
+                        }
+                        return (result);
+                    });
+                }
+            }
+
+            runner.Measure(path, "dh-generate", sizeof(dhPrime1024), threads, [&path](Resources&) -> Operation {
+                return ([&path]() -> bool {
+                    uint32_t privateKeyId = 0;
+                    uint32_t publicKeyId = 0;
+                    const bool result = path.Generate(privateKeyId, publicKeyId);
+                    path.Delete(privateKeyId);
+                    path.Delete(publicKeyId);
+                    return (result);
+                });
+            });
+
+            runner.Measure(path, "dh-derive", sizeof(dhPrime1024), threads, [&path](Resources& resources) -> Operation {
+                Operation result;
+                uint32_t privateKeyId = 0;
+                uint32_t publicKeyId = 0;
+                uint32_t peerPrivateKeyId = 0;
+                uint32_t peerPublicKeyId = 0;
+                if ((path.Generate(privateKeyId, publicKeyId) == true) && (path.Generate(peerPrivateKeyId, peerPublicKeyId) == true)) {
+                    resources.Key(privateKeyId);
+                    resources.Key(publicKeyId);
+                    resources.Key(peerPrivateKeyId);
+                    resources.Key(peerPublicKeyId);
+                    result = [&path, privateKeyId, peerPublicKeyId]() -> bool {
+                        uint32_t secretId = 0;
+                        const bool derived = path.Derive(privateKeyId, peerPublicKeyId, secretId);
+                        path.Delete(secretId);
+                        return (derived);
+                    };
+                }
+                return (result);
+            });
+        }
+    }
+
+    path.Delete(aesKeyId);
+    path.Delete(hmacKeyId);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const char* connector = nullptr;
+    const char* output = nullptr;
+    std::string paths("capi,interface,rpc");
+    std::string filter;
+    std::vector<uint32_t> sizes = List("16,256,1024,16384,1048576");
+    std::vector<uint32_t> threads = List("1,2,4");
+    uint32_t duration = 1000;
+    cryptographyvault vaultId = CRYPTOGRAPHY_VAULT_PLATFORM;
+
+    for (int index = 1; index < argc; index++) {
+        const bool hasValue = ((index + 1) < argc);
+
+        if (::strcmp(argv[index], "--netflix") == 0) {
+            vaultId = CRYPTOGRAPHY_VAULT_NETFLIX;
+        } else if ((hasValue == true) && (::strcmp(argv[index], "--connector") == 0)) {
+            connector = argv[++index];
+        } else if ((hasValue == true) && (::strcmp(argv[index], "--paths") == 0)) {
+            paths = argv[++index];
+        } else if ((hasValue == true) && (::strcmp(argv[index], "--sizes") == 0)) {
+            sizes = List(argv[++index]);
+        } else if ((hasValue == true) && (::strcmp(argv[index], "--threads") == 0)) {
+            threads = List(argv[++index]);
+        } else if ((hasValue == true) && (::strcmp(argv[index], "--duration") == 0)) {
+            duration = ::atoi(argv[++index]);
+        } else if ((hasValue == true) && (::strcmp(argv[index], "--filter") == 0)) {
+            filter = argv[++index];
+        } else if ((hasValue == true) && (::strcmp(argv[index], "--output") == 0)) {
+            output = argv[++index];
+        } else {
+            fprintf(stderr, "Usage: %s [--connector <path>] [--netflix] [--paths capi,interface,rpc] [--sizes 16,1024,...]\n"
+                            "          [--threads 1,2,4] [--duration <ms>] [--filter <operation prefix>] [--output <file>]\n", argv[0]);
+            return (1);
+        }
+    }
+
+    uint32_t largest = 0;
+    for (const uint32_t size : sizes) {
+        largest = std::max(largest, size);
+    }
+
+    std::vector<uint8_t> input(largest);
+    for (uint32_t index = 0; index < largest; index++) {
+        input[index] = static_cast<uint8_t>(index * 7);
+    }
+
+    Runner runner(duration, filter);
+
+    if (paths.find("capi") != std::string::npos) {
+        VaultImplementation* vault = vault_instance(vaultId);
+
+        if (vault == nullptr) {
+            fprintf(stderr, "capi: vault %u not available, skipped\n", vaultId);
+        } else {
+            CAPI path(vault);
+            Benchmark(runner, path, sizes, threads, input.data());
+        }
+    }
+
+    if (paths.find("interface") != std::string::npos) {
+        Thunder::Cryptography::ICryptography* cryptography = Thunder::Cryptography::ICryptography::Instance("");
+        Thunder::Cryptography::IVault* vault = (cryptography != nullptr ? cryptography->Vault(vaultId) : nullptr);
+
+        if (vault == nullptr) {
+            fprintf(stderr, "interface: vault %u not available, skipped\n", vaultId);
+        } else {
+            Interface path("interface", cryptography, vault);
+            Benchmark(runner, path, sizes, threads, input.data());
+            vault->Release();
+        }
+
+        if (cryptography != nullptr) {
+            cryptography->Release();
+        }
+    }
+
+    if ((connector != nullptr) && (paths.find("rpc") != std::string::npos)) {
+        Thunder::Cryptography::ICryptography* cryptography = Thunder::Cryptography::ICryptography::Instance(connector);
+        Thunder::Cryptography::IVault* vault = (cryptography != nullptr ? cryptography->Vault(vaultId) : nullptr);
+
+        if (vault == nullptr) {
+            fprintf(stderr, "rpc: no vault %u at %s, skipped\n", vaultId, connector);
+        } else {
+            Interface path("rpc", cryptography, vault);
+            Benchmark(runner, path, sizes, threads, input.data());
+            vault->Release();
+        }
+
+        if (cryptography != nullptr) {
+            cryptography->Release();
+        }
+    }
+
+    FILE* file = (output != nullptr ? ::fopen(output, "w") : stdout);
+
+    if (file == nullptr) {
+        fprintf(stderr, "Failed to open %s\n", output);
+    } else {
+        runner.Report(file);
+
+        if (file != stdout) {
+            ::fclose(file);
+        }
+    }
+
+    Thunder::Core::Singleton::Dispose();
+
+    return (file != nullptr ? 0 : 1);
+}
@@ -26,6 +26,8 @@
 #include <string.h>
 #include <stdbool.h>
 #include <limits.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 #include <openssl/dh.h>
 #include <openssl/hmac.h>
@@ -35,6 +37,8 @@
 #include <implementation/hash_implementation.h>
 #include <implementation/cipher_implementation.h>
 #include <implementation/diffiehellman_implementation.h>
+#include <implementation/persistent_implementation.h>
+#include <implementation/statistics_implementation.h>
 
 #include "Helpers.h"
 #include "Test.h"
@@ -202,6 +206,159 @@ TEST(Vault, SetGet)
     EXPECT_EQ(vault_size(vault, id4), 0);
 }
 
+TEST(Vault, Handles)
+{
+    const uint16_t count = 2000;
+    uint32_t* ids = static_cast<uint32_t*>(malloc(count * sizeof(uint32_t)));
+    uint8_t large[200];
+    uint8_t output[sizeof(large)];
+    uint16_t good = 0;
+
+    for (uint16_t i = 0; i < sizeof(large); i++) {
+        large[i] = static_cast<uint8_t>(i);
+    }
+
+    /* Many keys, each with a handle of its own */
+    for (uint16_t i = 0; i < count; i++) {
+        uint8_t key[16];
+        memset(key, 0, sizeof(key));
+        memcpy(key, &i, sizeof(i));
+        ids[i] = vault_import(vault, sizeof(key), key);
+        good += (ids[i] > 0x80000000U);
+    }
+    EXPECT_EQ(good, count);
+
+    good = 0;
+    for (uint16_t i = 0; i < count; i++) {
+        uint8_t key[16];
+        uint16_t index = 0xFFFF;
+        if (vault_export(vault, ids[i], sizeof(key), key) == sizeof(key)) {
+            memcpy(&index, key, sizeof(index));
+        }
+        good += (index == i);
+    }
+    EXPECT_EQ(good, count);
+
+    /* Recycled slots never bring back a deleted handle */
+    good = 0;
+    for (uint16_t i = 0; i < count; i += 2) {
+        good += (vault_delete(vault, ids[i]) == true);
+    }
+    for (uint16_t i = 0; i < count; i += 2) {
+        uint32_t id = vault_import(vault, sizeof(large), large);
+        good += ((id != 0) && (id != ids[i]) && (vault_size(vault, ids[i]) == 0) && (vault_export(vault, ids[i], sizeof(output), output) == 0)
+                 && (vault_delete(vault, ids[i]) == false));
+        ids[i] = id;
+    }
+    EXPECT_EQ(good, count);
+
+    /* Blobs that do not fit a slot come out intact too */
+    EXPECT_EQ(vault_export(vault, ids[0], sizeof(output), output), sizeof(large));
+    EXPECT_EQ(memcmp(output, large, sizeof(large)), 0);
+
+    good = 0;
+    for (uint16_t i = 0; i < count; i++) {
+        good += (vault_delete(vault, ids[i]) == true);
+    }
+    EXPECT_EQ(good, count);
+
+    /* Handles of internal blobs are not handed out */
+    EXPECT_EQ(vault_size(vault, 31), 0);
+    EXPECT_EQ(vault_delete(vault, 31), false);
+
+    free(ids);
+}
+
+static void PersistentHMAC(struct VaultImplementation* platform, const uint32_t keyId, uint8_t digest[SHA256_DIGEST_LENGTH])
+{
+    const uint8_t data[] = "Etaoin Shrldu";
+
+    struct HashImplementation* hmac = hash_create_hmac(platform, HASH_TYPE_SHA256, keyId);
+    EXPECT_NE(hmac, NULL);
+    if (hmac != NULL) {
+        EXPECT_EQ(hash_ingest(hmac, (sizeof(data) - 1), data), (sizeof(data) - 1));
+        EXPECT_EQ(hash_calculate(hmac, SHA256_DIGEST_LENGTH, digest), SHA256_DIGEST_LENGTH);
+        hash_destroy(hmac);
+    }
+}
+
+TEST(Vault, Persistent)
+{
+    static const char storePath[] = "/tmp/cgimpltests.vault";
+
+    char locator[32];
+    char other[32];
+    snprintf(locator, sizeof(locator), "cgtests.%i.a", getpid());
+    snprintf(other, sizeof(other), "cgtests.%i.b", getpid());
+
+    unlink(storePath);
+    setenv("PERSISTENT_VAULT", storePath, 1);
+
+    struct VaultImplementation* platform = vault_instance(CRYPTOGRAPHY_VAULT_PLATFORM);
+    EXPECT_NE(platform, NULL);
+
+    uint8_t reference[SHA256_DIGEST_LENGTH];
+    uint8_t digest[SHA256_DIGEST_LENGTH];
+    uint32_t id = 0;
+    uint32_t otherId = 0;
+    uint32_t loaded = 0;
+    bool exists = true;
+
+    /* Only the platform vault is backed by storage */
+    EXPECT_NE(persistent_key_create(vault, locator, HMAC256, &id), 0);
+
+    EXPECT_EQ(persistent_key_exists(platform, locator, &exists), 0);
+    EXPECT_EQ(exists, false);
+    EXPECT_NE(persistent_key_load(platform, locator, &loaded), 0);
+    EXPECT_NE(persistent_key_create(platform, "", HMAC256, &id), 0);
+
+    EXPECT_EQ(persistent_key_create(platform, locator, HMAC256, &id), 0);
+    EXPECT_NE(id, 0);
+    EXPECT_EQ(vault_size(platform, id), USHRT_MAX);
+    EXPECT_EQ(persistent_key_create(platform, other, AES128, &otherId), 0);
+    EXPECT_NE(otherId, 0);
+    PersistentHMAC(platform, id, reference);
+
+    /* Known before it is flushed, and loads as the same key */
+    EXPECT_EQ(persistent_key_exists(platform, locator, &exists), 0);
+    EXPECT_EQ(exists, true);
+    EXPECT_EQ(persistent_key_load(platform, locator, &loaded), 0);
+    EXPECT_EQ(loaded, id);
+
+    EXPECT_EQ(persistent_flush(platform), 0);
+    EXPECT_EQ(access(storePath, F_OK), 0);
+
+    /* Only accessible by this user */
+    struct stat info;
+    EXPECT_EQ(stat(storePath, &info), 0);
+    EXPECT_EQ((info.st_mode & (S_IRWXG | S_IRWXO)), 0);
+
+    /* Once gone from the vault the key comes back from the store */
+    EXPECT_EQ(vault_delete(platform, id), true);
+    EXPECT_EQ(persistent_key_load(platform, locator, &loaded), 0);
+    EXPECT_NE(loaded, id);
+    memset(digest, 0, sizeof(digest));
+    PersistentHMAC(platform, loaded, digest);
+    EXPECT_EQ(memcmp(digest, reference, sizeof(digest)), 0);
+    EXPECT_EQ(vault_delete(platform, loaded), true);
+
+    /* Re-creating a key replaces it, the other keys are kept */
+    EXPECT_EQ(persistent_key_create(platform, locator, HMAC256, &id), 0);
+    EXPECT_EQ(persistent_flush(platform), 0);
+    EXPECT_EQ(vault_delete(platform, id), true);
+    EXPECT_EQ(persistent_key_load(platform, locator, &loaded), 0);
+    PersistentHMAC(platform, loaded, digest);
+    EXPECT_NE(memcmp(digest, reference, sizeof(digest)), 0);
+    EXPECT_EQ(vault_delete(platform, otherId), true);
+    EXPECT_EQ(persistent_key_load(platform, other, &otherId), 0);
+    EXPECT_EQ(vault_size(platform, otherId), USHRT_MAX);
+
+    EXPECT_EQ(vault_delete(platform, loaded), true);
+    EXPECT_EQ(vault_delete(platform, otherId), true);
+
+    unlink(storePath);
+}
+
 /*
   ===================================
     HASH
@@ -370,11 +527,296 @@ TEST(Signing, HMAC)
                                         0xEC, 0x47, 0x89, 0x62, 0x89, 0xBF, 0x25, 0x0D, 0x1B, 0x11, 0x28, 0xA6,
                                         0x48, 0xD5, 0x77, 0xF2 };
         TestHMAC("SHA512", HASH_TYPE_SHA512, secret, data, (sizeof(data) - 1), hash_sha512, sizeof(hash_sha512));
+
+        /* A deleted key must not live on in a prepared context */
+        EXPECT_NE(vault_delete(vault, secret), false);
+        struct HashImplementation* stale = hash_create_hmac(vault, HASH_TYPE_SHA256, secret);
+        EXPECT_EQ(stale, NULL);
+        if (stale != NULL) {
+            hash_destroy(stale);
+        }
     } else {
         printf("FATAL: Failed to store secret into vault, HMAC tests are skipped\n");
     }
 }
 
+static void TestBatch(const char* name, struct HashImplementation* batch, const hash_type type, const uint32_t secret)
+{
+    const uint16_t sizes[] = { 0, 1, 55, 64, 200 };
+    const uint16_t count = sizeof(sizes) / sizeof(sizes[0]);
+
+    uint8_t input[512];
+    uint8_t output[count * 64];
+    uint8_t digest[64];
+    uint32_t inputSize = 0;
+
+    printf("> Testing %s batch of %i messages\n", name, count);
+
+    for (uint16_t i = 0; i < count; i++) {
+        const uint32_t length = sizes[i];
+        memcpy(input + inputSize, &length, sizeof(length));
+        inputSize += sizeof(length);
+        for (uint32_t j = 0; j < length; j++) {
+            input[inputSize++] = static_cast<uint8_t>(i + j);
+        }
+    }
+
+    /* Not enough room for all digests */
+    EXPECT_EQ(hash_batch(batch, count, inputSize, input, (type * count) - 1, output), 0);
+    /* Truncated input only produces the complete messages */
+    EXPECT_EQ(hash_batch(batch, count, (inputSize - 1), input, sizeof(output), output), (count - 1));
+
+    EXPECT_EQ(hash_batch(batch, count, inputSize, input, sizeof(output), output), count);
+
+    uint32_t offset = 0;
+    for (uint16_t i = 0; i < count; i++) {
+        struct HashImplementation* single = (secret == 0 ? hash_create(type) : hash_create_hmac(vault, type, secret));
+        EXPECT_NE(single, NULL);
+        if (single != NULL) {
+            EXPECT_EQ(hash_ingest(single, sizes[i], input + offset + sizeof(uint32_t)), sizes[i]);
+            EXPECT_EQ(hash_calculate(single, sizeof(digest), digest), type);
+            EXPECT_EQ(memcmp(digest, output + (i * type), type), 0);
+            hash_destroy(single);
+        }
+        offset += (sizeof(uint32_t) + sizes[i]);
+    }
+}
+
+TEST(Signing, Batch)
+{
+    const uint8_t password[] = "Thunder";
+
+    struct HashImplementation* hash = hash_create(HASH_TYPE_SHA256);
+    EXPECT_NE(hash, NULL);
+    if (hash != NULL) {
+        TestBatch("SHA256", hash, HASH_TYPE_SHA256, 0);
+        hash_destroy(hash);
+    }
+
+    uint32_t secret = vault_import(vault, (sizeof(password) - 1), password);
+    EXPECT_NE(secret, 0);
+    if (secret != 0) {
+        struct HashImplementation* hmac = hash_create_hmac(vault, HASH_TYPE_SHA384, secret);
+        EXPECT_NE(hmac, NULL);
+        if (hmac != NULL) {
+            TestBatch("HMAC-SHA384", hmac, HASH_TYPE_SHA384, secret);
+            hash_destroy(hmac);
+        }
+        EXPECT_NE(vault_delete(vault, secret), false);
+    }
+}
+
+static void TestReset(const char* name, struct HashImplementation* hash, const hash_type type, const uint32_t secret)
+{
+    const uint8_t message[] = "The quick brown fox jumps over the lazy dog";
+    const uint8_t junk[] = "Not part of the message";
+    uint8_t reference[64];
+    uint8_t digest[64];
+
+    printf("> Testing %s reset\n", name);
+
+    struct HashImplementation* single = (secret == 0 ? hash_create(type) : hash_create_hmac(vault, type, secret));
+    EXPECT_NE(single, NULL);
+    if (single != NULL) {
+        EXPECT_EQ(hash_ingest(single, (sizeof(message) - 1), message), (sizeof(message) - 1));
+        EXPECT_EQ(hash_calculate(single, sizeof(reference), reference), type);
+        hash_destroy(single);
+    }
+
+    /* Reset discards data ingested so far */
+    EXPECT_EQ(hash_ingest(hash, (sizeof(junk) - 1), junk), (sizeof(junk) - 1));
+    EXPECT_EQ(hash_reset(hash), 0);
+    EXPECT_EQ(hash_ingest(hash, (sizeof(message) - 1), message), (sizeof(message) - 1));
+    EXPECT_EQ(hash_calculate(hash, sizeof(digest), digest), type);
+    EXPECT_EQ(memcmp(digest, reference, type), 0);
+
+    /* ...and re-arms a finished calculation */
+    for (uint8_t i = 0; i < 3; i++) {
+        memset(digest, 0, sizeof(digest));
+        EXPECT_EQ(hash_reset(hash), 0);
+        EXPECT_EQ(hash_ingest(hash, (sizeof(message) - 1), message), (sizeof(message) - 1));
+        EXPECT_EQ(hash_calculate(hash, sizeof(digest), digest), type);
+        EXPECT_EQ(memcmp(digest, reference, type), 0);
+    }
+}
+
+TEST(Signing, Reset)
+{
+    const uint8_t password[] = "Thunder";
+
+    struct HashImplementation* hash = hash_create(HASH_TYPE_SHA1);
+    EXPECT_NE(hash, NULL);
+    if (hash != NULL) {
+        TestReset("SHA1", hash, HASH_TYPE_SHA1, 0);
+        hash_destroy(hash);
+    }
+
+    uint32_t secret = vault_import(vault, (sizeof(password) - 1), password);
+    EXPECT_NE(secret, 0);
+    if (secret != 0) {
+        struct HashImplementation* hmac = hash_create_hmac(vault, HASH_TYPE_SHA256, secret);
+        EXPECT_NE(hmac, NULL);
+        if (hmac != NULL) {
+            TestReset("HMAC-SHA256", hmac, HASH_TYPE_SHA256, secret);
+            hash_destroy(hmac);
+        }
+        EXPECT_NE(vault_delete(vault, secret), false);
+    }
+}
+
+static void TestDerivedKey(const uint32_t key, const uint16_t keyLength, const uint8_t expected[])
+{
+    const uint8_t message[] = "The quick brown fox jumps over the lazy dog";
+    uint8_t digest[64];
+    uint8_t reference[64];
+    uint8_t blob[256];
+
+    /* Derived keys never leave the vault... */
+    EXPECT_EQ(vault_size(vault, key), USHRT_MAX);
+    EXPECT_EQ(vault_export(vault, key, sizeof(blob), blob), 0);
+
+    /* ...so compare them by their HMAC against the known output keying material */
+    uint32_t known = vault_import(vault, keyLength, expected);
+    EXPECT_NE(known, 0);
+
+    struct HashImplementation* hmac = hash_create_hmac(vault, HASH_TYPE_SHA256, key);
+    struct HashImplementation* check = hash_create_hmac(vault, HASH_TYPE_SHA256, known);
+    EXPECT_NE(hmac, NULL);
+    EXPECT_NE(check, NULL);
+
+    if ((hmac != NULL) && (check != NULL)) {
+        EXPECT_EQ(hash_ingest(hmac, (sizeof(message) - 1), message), (sizeof(message) - 1));
+        EXPECT_EQ(hash_calculate(hmac, sizeof(digest), digest), HASH_TYPE_SHA256);
+        EXPECT_EQ(hash_ingest(check, (sizeof(message) - 1), message), (sizeof(message) - 1));
+        EXPECT_EQ(hash_calculate(check, sizeof(reference), reference), HASH_TYPE_SHA256);
+        EXPECT_EQ(memcmp(digest, reference, HASH_TYPE_SHA256), 0);
+    }
+
+    if (hmac != NULL) {
+        hash_destroy(hmac);
+    }
+    if (check != NULL) {
+        hash_destroy(check);
+    }
+
+    EXPECT_NE(vault_delete(vault, key), false);
+    EXPECT_NE(vault_delete(vault, known), false);
+}
+
+static void TestDerive(const char* name, const hash_type type, const uint32_t secret, const uint16_t saltLength, const uint8_t salt[],
+                       const uint16_t infoLength, const uint8_t info[], const uint16_t keyLength, const uint8_t expected[])
+{
+    uint32_t key = 0;
+
+    printf("> Testing %s key derivation of %i bytes\n", name, keyLength);
+
+    EXPECT_EQ(hash_derive_keys(vault, type, secret, saltLength, salt, infoLength, info, 1, &keyLength, &key), 0);
+    EXPECT_NE(key, 0);
+
+    TestDerivedKey(key, keyLength, expected);
+}
+
+TEST(Signing, Derive)
+{
+    // RFC 5869, test cases 1 and 3, the SHA384 output is computed with the same input as test case 1
+    const uint8_t ikm[] = { 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b,
+                            0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b };
+    const uint8_t salt[] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c };
+    const uint8_t info[] = { 0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9 };
+
+    const uint8_t okm_sha256[] = { 0x3c, 0xb2, 0x5f, 0x25, 0xfa, 0xac, 0xd5, 0x7a, 0x90, 0x43, 0x4f, 0x64, 0xd0, 0x36, 0x2f, 0x2a,
+                                   0x2d, 0x2d, 0x0a, 0x90, 0xcf, 0x1a, 0x5a, 0x4c, 0x5d, 0xb0, 0x2d, 0x56, 0xec, 0xc4, 0xc5, 0xbf,
+                                   0x34, 0x00, 0x72, 0x08, 0xd5, 0xb8, 0x87, 0x18, 0x58, 0x65 };
+    const uint8_t okm_sha256_nosalt[] = { 0x8d, 0xa4, 0xe7, 0x75, 0xa5, 0x63, 0xc1, 0x8f, 0x71, 0x5f, 0x80, 0x2a, 0x06, 0x3c, 0x5a, 0x31,
+                                          0xb8, 0xa1, 0x1f, 0x5c, 0x5e, 0xe1, 0x87, 0x9e, 0xc3, 0x45, 0x4e, 0x5f, 0x3c, 0x73, 0x8d, 0x2d,
+                                          0x9d, 0x20, 0x13, 0x95, 0xfa, 0xa4, 0xb6, 0x1a, 0x96, 0xc8 };
+    const uint8_t okm_sha384[] = { 0x9b, 0x50, 0x97, 0xa8, 0x60, 0x38, 0xb8, 0x05, 0x30, 0x90, 0x76, 0xa4, 0x4b, 0x3a, 0x9f, 0x38,
+                                   0x06, 0x3e, 0x25, 0xb5, 0x16, 0xdc, 0xbf, 0x36, 0x9f, 0x39, 0x4c, 0xfa, 0xb4, 0x36, 0x85, 0xf7,
+                                   0x48, 0xb6, 0x45, 0x77, 0x63, 0xe4, 0xf0, 0x20, 0x4f, 0xc5, 0xd9, 0x5d, 0x1d, 0xa3, 0xe6, 0x25,
+                                   0x87, 0xb2, 0x2e, 0xb8, 0x94, 0x3d, 0x0f, 0xab, 0x6b, 0xb6, 0x31, 0xa2, 0xfe, 0x9d, 0xf1, 0xa6 };
+
+    uint32_t secret = vault_import(vault, sizeof(ikm), ikm);
+    EXPECT_NE(secret, 0);
+    if (secret != 0) {
+        TestDerive("HKDF-SHA256", HASH_TYPE_SHA256, secret, sizeof(salt), salt, sizeof(info), info, sizeof(okm_sha256), okm_sha256);
+        TestDerive("HKDF-SHA256", HASH_TYPE_SHA256, secret, 0, NULL, 0, NULL, sizeof(okm_sha256_nosalt), okm_sha256_nosalt);
+        TestDerive("HKDF-SHA384", HASH_TYPE_SHA384, secret, sizeof(salt), salt, sizeof(info), info, sizeof(okm_sha384), okm_sha384);
+        /* A shorter key is a prefix of the longer one */
+        TestDerive("HKDF-SHA256", HASH_TYPE_SHA256, secret, sizeof(salt), salt, sizeof(info), info, 16, okm_sha256);
+
+        /* Several keys split up the output keying material, in order */
+        const uint16_t lengths[] = { 16, (sizeof(okm_sha256) - 16) };
+        uint32_t keys[2] = { 0, 0 };
+
+        printf("> Testing HKDF-SHA256 derivation of two keys\n");
+        EXPECT_EQ(hash_derive_keys(vault, HASH_TYPE_SHA256, secret, sizeof(salt), salt, sizeof(info), info, 2, lengths, keys), 0);
+        EXPECT_NE(keys[0], 0);
+        EXPECT_NE(keys[1], 0);
+        TestDerivedKey(keys[0], lengths[0], okm_sha256);
+        TestDerivedKey(keys[1], lengths[1], (okm_sha256 + lengths[0]));
+
+        /* Empty keys and more than 255 blocks of output are refused, as a whole */
+        const uint16_t empty[] = { 16, 0 };
+        const uint16_t large[] = { (255 * 16), ((255 * 16) + 1) };
+
+        EXPECT_NE(hash_derive_keys(vault, HASH_TYPE_SHA256, secret, sizeof(salt), salt, sizeof(info), info, 2, empty, keys), 0);
+        EXPECT_EQ(keys[0], 0);
+        EXPECT_NE(hash_derive_keys(vault, HASH_TYPE_SHA256, secret, sizeof(salt), salt, sizeof(info), info, 2, large, keys), 0);
+        EXPECT_NE(hash_derive_keys(vault, HASH_TYPE_SHA256, secret, sizeof(salt), salt, sizeof(info), info, 0, lengths, keys), 0);
+        EXPECT_NE(vault_delete(vault, secret), false);
+        EXPECT_NE(hash_derive_keys(vault, HASH_TYPE_SHA256, secret, sizeof(salt), salt, sizeof(info), info, 1, lengths, keys), 0);
+        EXPECT_EQ(keys[0], 0);
+    }
+}
+
+TEST(Signing, Verify)
+{
+    const uint8_t data[] = "Etaoin Shrldu";
+    const uint8_t password[] = "Thunder";
+    const uint8_t hash_sha256[] = { 0x2D, 0xF5, 0x9C, 0xBE, 0x61, 0x59, 0x7F, 0x14, 0xEC, 0xD2, 0x85, 0x6F,
+                                    0xAB, 0xF1, 0x12, 0xFC, 0xF4, 0x68, 0x6D, 0xFE, 0x93, 0x5F, 0xDB, 0xB7,
+                                    0x34, 0x8C, 0x6C, 0x6B, 0xF1, 0x64, 0xE9, 0x27 };
+    uint8_t expected[sizeof(hash_sha256) + 1];
+
+    uint32_t secret = vault_import(vault, (sizeof(password) - 1), password);
+    EXPECT_NE(secret, 0);
+    if (secret != 0) {
+        struct HashImplementation* hmac = hash_create_hmac(vault, HASH_TYPE_SHA256, secret);
+        EXPECT_NE(hmac, NULL);
+        if (hmac != NULL) {
+            memcpy(expected, hash_sha256, sizeof(hash_sha256));
+            expected[sizeof(hash_sha256)] = 0;
+
+            EXPECT_EQ(hash_ingest(hmac, (sizeof(data) - 1), data), (sizeof(data) - 1));
+            EXPECT_EQ(hash_verify(hmac, sizeof(hash_sha256), expected), true);
+
+            /* Truncated down to half of the digest */
+            EXPECT_EQ(hash_reset(hmac), 0);
+            EXPECT_EQ(hash_ingest(hmac, (sizeof(data) - 1), data), (sizeof(data) - 1));
+            EXPECT_EQ(hash_verify(hmac, (sizeof(hash_sha256) / 2), expected), true);
+
+            /* ...but no further */
+            EXPECT_EQ(hash_reset(hmac), 0);
+            EXPECT_EQ(hash_ingest(hmac, (sizeof(data) - 1), data), (sizeof(data) - 1));
+            EXPECT_EQ(hash_verify(hmac, (sizeof(hash_sha256) / 4), expected), false);
+
+            /* Longer than the digest */
+            EXPECT_EQ(hash_reset(hmac), 0);
+            EXPECT_EQ(hash_ingest(hmac, (sizeof(data) - 1), data), (sizeof(data) - 1));
+            EXPECT_EQ(hash_verify(hmac, sizeof(expected), expected), false);
+
+            /* A single bit off, in the last byte */
+            expected[sizeof(hash_sha256) - 1] ^= 0x01;
+            EXPECT_EQ(hash_reset(hmac), 0);
+            EXPECT_EQ(hash_ingest(hmac, (sizeof(data) - 1), data), (sizeof(data) - 1));
+            EXPECT_EQ(hash_verify(hmac, sizeof(hash_sha256), expected), false);
+
+            hash_destroy(hmac);
+        }
+        EXPECT_NE(vault_delete(vault, secret), false);
+    }
+}
+
 /*
   ===================================
     CIPHER
@@ -526,6 +968,137 @@ TEST(DH, DeriveStandard)
     }
 }
 
+static void SecretHMAC(const uint32_t secretId, uint8_t hmac[SHA256_DIGEST_LENGTH])
+{
+    const char testStr[] = "Thunder";
+
+    struct HashImplementation* himp = hash_create_hmac(vault, HASH_TYPE_SHA256, secretId);
+    EXPECT_NE(himp, NULL);
+    if (himp) {
+        EXPECT_EQ(hash_ingest(himp, sizeof(testStr), (uint8_t*)testStr), sizeof(testStr));
+        EXPECT_EQ(hash_calculate(himp, SHA256_DIGEST_LENGTH, hmac), SHA256_DIGEST_LENGTH);
+        hash_destroy(himp);
+    }
+}
+
+TEST(DH, Repeated)
+{
+    const uint8_t count = 6;
+    uint32_t privateKeyIds[count] = { 0 };
+    uint32_t publicKeyIds[count] = { 0 };
+    uint8_t publicKeys[count][sizeof(testPrime1024)];
+
+    /* Pairs may come out of a pool of pre-generated ones, they still have to be unique and work */
+    for (uint8_t i = 0; i < count; i++) {
+        EXPECT_EQ(diffiehellman_generate(vault, testGenerator, sizeof(testPrime1024), testPrime1024, &privateKeyIds[i], &publicKeyIds[i]), 0);
+        EXPECT_NE(privateKeyIds[i], 0);
+        EXPECT_NE(publicKeyIds[i], 0);
+
+        memset(publicKeys[i], 0, sizeof(publicKeys[i]));
+        EXPECT_NE(vault_export(vault, publicKeyIds[i], sizeof(publicKeys[i]), publicKeys[i]), 0);
+
+        for (uint8_t j = 0; j < i; j++) {
+            EXPECT_NE(memcmp(publicKeys[i], publicKeys[j], sizeof(publicKeys[i])), 0);
+        }
+
+        if (i == 1) {
+            /* Give a background refill a chance */
+            usleep(200 * 1000);
+        }
+    }
+
+    /* Both ends must agree on the secret */
+    for (uint8_t i = 1; i < count; i++) {
+        uint32_t secretId = 0;
+        uint32_t peerSecretId = 0;
+        uint8_t hmac[SHA256_DIGEST_LENGTH] = { 0 };
+        uint8_t peerHmac[SHA256_DIGEST_LENGTH] = { 0 };
+
+        EXPECT_EQ(diffiehellman_derive(vault, privateKeyIds[i - 1], publicKeyIds[i], &secretId), 0);
+        EXPECT_EQ(diffiehellman_derive(vault, privateKeyIds[i], publicKeyIds[i - 1], &peerSecretId), 0);
+
+        SecretHMAC(secretId, hmac);
+        SecretHMAC(peerSecretId, peerHmac);
+        EXPECT_EQ(memcmp(hmac, peerHmac, sizeof(hmac)), 0);
+
+        EXPECT_NE(vault_delete(vault, secretId), false);
+        EXPECT_NE(vault_delete(vault, peerSecretId), false);
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        EXPECT_NE(vault_delete(vault, privateKeyIds[i]), false);
+        EXPECT_NE(vault_delete(vault, publicKeyIds[i]), false);
+    }
+}
+
+static void TestEllipticCurve(const char* name, const curve_type curve, const uint16_t publicKeySize)
+{
+    uint32_t privateKeyId = 0;
+    uint32_t publicKeyId = 0;
+    uint32_t peerPrivateKeyId = 0;
+    uint32_t peerPublicKeyId = 0;
+    uint32_t secretId = 0;
+    uint32_t peerSecretId = 0;
+
+    printf("> Testing %s key agreement\n", name);
+
+    EXPECT_EQ(diffiehellman_generate_ec(vault, curve, &privateKeyId, &publicKeyId), 0);
+    EXPECT_EQ(diffiehellman_generate_ec(vault, curve, &peerPrivateKeyId, &peerPublicKeyId), 0);
+
+    /* Private keys stay sealed, public keys are exported raw */
+    EXPECT_EQ(vault_size(vault, privateKeyId), USHRT_MAX);
+    EXPECT_EQ(vault_size(vault, publicKeyId), publicKeySize);
+    EXPECT_EQ(vault_size(vault, peerPublicKeyId), publicKeySize);
+
+    EXPECT_EQ(diffiehellman_derive(vault, privateKeyId, peerPublicKeyId, &secretId), 0);
+    EXPECT_EQ(diffiehellman_derive(vault, peerPrivateKeyId, publicKeyId, &peerSecretId), 0);
+    EXPECT_EQ(vault_size(vault, secretId), USHRT_MAX);
+
+    uint8_t hmac[SHA256_DIGEST_LENGTH] = { 0 };
+    uint8_t peerHmac[SHA256_DIGEST_LENGTH] = { 0 };
+    SecretHMAC(secretId, hmac);
+    SecretHMAC(peerSecretId, peerHmac);
+    EXPECT_EQ(memcmp(hmac, peerHmac, sizeof(hmac)), 0);
+
+    /* A peer key that is not a valid public key of this curve is refused */
+    uint8_t bogus[65];
+    memset(bogus, 0x5A, sizeof(bogus));
+    uint32_t bogusId = vault_import(vault, (publicKeySize - 1), bogus);
+    uint32_t bogusSecretId = 0;
+    EXPECT_NE(diffiehellman_derive(vault, privateKeyId, bogusId, &bogusSecretId), 0);
+    EXPECT_NE(vault_delete(vault, bogusId), false);
+
+    EXPECT_NE(vault_delete(vault, secretId), false);
+    EXPECT_NE(vault_delete(vault, peerSecretId), false);
+    EXPECT_NE(vault_delete(vault, privateKeyId), false);
+    EXPECT_NE(vault_delete(vault, publicKeyId), false);
+    EXPECT_NE(vault_delete(vault, peerPrivateKeyId), false);
+    EXPECT_NE(vault_delete(vault, peerPublicKeyId), false);
+}
+
+TEST(DH, EllipticCurve)
+{
+    TestEllipticCurve("X25519", CURVE_X25519, 32);
+    TestEllipticCurve("P-256", CURVE_P256, 65);
+
+    /* Keys of different kinds do not mix */
+    uint32_t x25519PrivateKeyId = 0;
+    uint32_t x25519PublicKeyId = 0;
+    uint32_t p256PrivateKeyId = 0;
+    uint32_t p256PublicKeyId = 0;
+    uint32_t secretId = 0;
+
+    EXPECT_EQ(diffiehellman_generate_ec(vault, CURVE_X25519, &x25519PrivateKeyId, &x25519PublicKeyId), 0);
+    EXPECT_EQ(diffiehellman_generate_ec(vault, CURVE_P256, &p256PrivateKeyId, &p256PublicKeyId), 0);
+    EXPECT_NE(diffiehellman_derive(vault, x25519PrivateKeyId, p256PublicKeyId, &secretId), 0);
+    EXPECT_NE(diffiehellman_derive(vault, p256PrivateKeyId, x25519PublicKeyId, &secretId), 0);
+
+    EXPECT_NE(vault_delete(vault, x25519PrivateKeyId), false);
+    EXPECT_NE(vault_delete(vault, x25519PublicKeyId), false);
+    EXPECT_NE(vault_delete(vault, p256PrivateKeyId), false);
+    EXPECT_NE(vault_delete(vault, p256PublicKeyId), false);
+}
+
 static void TestCryptAES(const char *name, const aes_mode mode, const uint32_t key,
                          const uint8_t iv[], const uint16_t ivLength,
                          const uint8_t data[], const uint16_t length,
@@ -702,6 +1275,650 @@ TEST(Cipher, AES_Unpadded)
     }
 }
 
+TEST(Cipher, AES_KeyLifetime)
+{
+    const uint8_t data[] = "0123456789abcdef0123456789abcdef";
+    const uint16_t dataSize = sizeof(data) - 1;
+    const uint8_t iv1[] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+    const uint8_t iv2[] = { 0x0f, 0x0e, 0x0d, 0x0c, 0x0b, 0x0a, 0x09, 0x08, 0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01, 0x00 };
+    const uint8_t key128[] = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff, 0x11 };
+
+    uint8_t output1[64];
+    uint8_t output2[64];
+    uint8_t output3[64];
+
+    uint32_t key128Id = vault_import(vault, sizeof(key128), key128);
+    EXPECT_NE(key128Id, 0);
+
+    struct CipherImplementation* cipher = cipher_create_aes(vault, AES_MODE_CBC, key128Id);
+    EXPECT_NE(cipher, NULL);
+
+    if (cipher != NULL) {
+        /* The same key with a different IV must still give a different result */
+        EXPECT_EQ(cipher_encrypt(cipher, sizeof(iv1), iv1, dataSize, data, sizeof(output1), output1), dataSize + 16);
+        EXPECT_EQ(cipher_encrypt(cipher, sizeof(iv2), iv2, dataSize, data, sizeof(output2), output2), dataSize + 16);
+        EXPECT_NE(memcmp(output1, output2, dataSize), 0);
+        EXPECT_EQ(cipher_encrypt(cipher, sizeof(iv1), iv1, dataSize, data, sizeof(output3), output3), dataSize + 16);
+        EXPECT_EQ(memcmp(output1, output3, dataSize + 16), 0);
+
+        /* Removing an unrelated key must not affect the cipher */
+        uint32_t otherId = vault_import(vault, sizeof(key128), key128);
+        EXPECT_NE(vault_delete(vault, otherId), false);
+        EXPECT_EQ(cipher_decrypt(cipher, sizeof(iv1), iv1, dataSize + 16, output1, sizeof(output3), output3), dataSize);
+        EXPECT_EQ(memcmp(output3, data, dataSize), 0);
+
+        /* Once the key is gone, the cipher must stop working */
+        EXPECT_NE(vault_delete(vault, key128Id), false);
+        EXPECT_EQ(cipher_encrypt(cipher, sizeof(iv1), iv1, dataSize, data, sizeof(output3), output3), 0);
+        EXPECT_EQ(cipher_decrypt(cipher, sizeof(iv1), iv1, dataSize + 16, output1, sizeof(output3), output3), 0);
+
+        /* ...also after its slot is recycled for a new key */
+        uint32_t recycledId = vault_import(vault, sizeof(key128), key128);
+        EXPECT_NE(recycledId, 0);
+        EXPECT_NE(recycledId, key128Id);
+        EXPECT_EQ(cipher_encrypt(cipher, sizeof(iv1), iv1, dataSize, data, sizeof(output3), output3), 0);
+        EXPECT_NE(vault_delete(vault, recycledId), false);
+
+        cipher_destroy(cipher);
+    }
+}
+
+static void TestStreamAES(const char *name, const aes_mode mode, const uint32_t key, const uint16_t chunkSize)
+{
+    const uint8_t iv[] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+    const uint16_t dataSize = 1000;
+    const uint16_t bufferSize = dataSize + 32;
+
+    printf("> Testing %s streaming in chunks of %i bytes\n", name, chunkSize);
+    struct CipherImplementation* cipher = cipher_create_aes(vault, mode, key);
+    EXPECT_NE(cipher, NULL);
+
+    if (cipher != NULL) {
+        uint8_t* data = static_cast<uint8_t*>(malloc(dataSize));
+        uint8_t* expected = static_cast<uint8_t*>(malloc(bufferSize));
+        uint8_t* output = static_cast<uint8_t*>(malloc(bufferSize));
+        uint8_t* clear = static_cast<uint8_t*>(malloc(bufferSize));
+
+        for (uint16_t i = 0; i < dataSize; i++) {
+            data[i] = static_cast<uint8_t>(i * 7);
+        }
+
+        int32_t expectedSize = cipher_encrypt(cipher, sizeof(iv), iv, dataSize, data, bufferSize, expected);
+        EXPECT_GT(expectedSize, 0);
+
+        int32_t outputSize = 0;
+        EXPECT_EQ(cipher_stream_initialize(cipher, true, sizeof(iv), iv), 0);
+        for (uint16_t offset = 0; offset < dataSize; offset += chunkSize) {
+            const uint16_t length = MIN(chunkSize, (dataSize - offset));
+            int32_t len = cipher_stream_update(cipher, length, (data + offset), (bufferSize - outputSize), (output + outputSize));
+            EXPECT_GE(len, 0);
+            outputSize += len;
+        }
+        outputSize += cipher_stream_finalize(cipher, (bufferSize - outputSize), (output + outputSize));
+        EXPECT_EQ(outputSize, expectedSize);
+        EXPECT_EQ(memcmp(output, expected, expectedSize), 0);
+
+        int32_t clearSize = 0;
+        EXPECT_EQ(cipher_stream_initialize(cipher, false, sizeof(iv), iv), 0);
+        for (int32_t offset = 0; offset < outputSize; offset += chunkSize) {
+            const uint16_t length = MIN(chunkSize, (outputSize - offset));
+            int32_t len = cipher_stream_update(cipher, length, (output + offset), (bufferSize - clearSize), (clear + clearSize));
+            EXPECT_GE(len, 0);
+            clearSize += len;
+        }
+        clearSize += cipher_stream_finalize(cipher, (bufferSize - clearSize), (clear + clearSize));
+        EXPECT_EQ(clearSize, dataSize);
+        EXPECT_EQ(memcmp(clear, data, dataSize), 0);
+
+        /* No operation in progress anymore */
+        EXPECT_EQ(cipher_stream_update(cipher, dataSize, data, bufferSize, output), 0);
+
+        free(clear);
+        free(output);
+        free(expected);
+        free(data);
+
+        cipher_destroy(cipher);
+    }
+}
+
+TEST(Cipher, AES_Stream)
+{
+    const uint8_t key128[] = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff, 0x11 };
+
+    uint32_t key128Id = vault_import(vault, sizeof(key128), key128);
+    EXPECT_NE(key128Id, 0);
+    if (key128Id != 0) {
+        TestStreamAES("128-bit AES/CBC", AES_MODE_CBC, key128Id, 7);
+        TestStreamAES("128-bit AES/CBC", AES_MODE_CBC, key128Id, 64);
+        TestStreamAES("128-bit AES/CTR", AES_MODE_CTR, key128Id, 13);
+        TestStreamAES("128-bit AES/CFB8", AES_MODE_CFB8, key128Id, 100);
+        EXPECT_NE(vault_delete(vault, key128Id), false);
+    } else {
+        printf("  FATAL: Failed to store key to vault, AES streaming tests will be skipped\n");
+    }
+}
+
+TEST(Cipher, AES_Batch)
+{
+    const uint8_t key128[] = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff, 0x11 };
+    const uint16_t sizes[] = { 1, 16, 33, 100 };
+    const uint16_t count = sizeof(sizes) / sizeof(sizes[0]);
+
+    uint8_t input[512];
+    uint8_t output[512];
+    uint8_t clear[512];
+    uint8_t record[128];
+    uint32_t inputSize = 0;
+
+    /* Records of [IV][length][data] */
+    for (uint16_t i = 0; i < count; i++) {
+        const uint32_t length = sizes[i];
+        for (uint8_t j = 0; j < 16; j++) {
+            input[inputSize++] = static_cast<uint8_t>(i + j);
+        }
+        memcpy(input + inputSize, &length, sizeof(length));
+        inputSize += sizeof(length);
+        for (uint32_t j = 0; j < length; j++) {
+            input[inputSize++] = static_cast<uint8_t>(j * 3);
+        }
+    }
+
+    uint32_t key128Id = vault_import(vault, sizeof(key128), key128);
+    EXPECT_NE(key128Id, 0);
+
+    struct CipherImplementation* cipher = cipher_create_aes(vault, AES_MODE_CBC, key128Id);
+    EXPECT_NE(cipher, NULL);
+
+    if (cipher != NULL) {
+        /* Too small an output buffer is reported up front */
+        EXPECT_EQ(cipher_batch(cipher, true, 16, count, inputSize, input, 16, output) < 0, true);
+        /* A truncated batch is rejected */
+        EXPECT_EQ(cipher_batch(cipher, true, 16, count, (inputSize - 1), input, sizeof(output), output), 0);
+
+        int32_t outputSize = cipher_batch(cipher, true, 16, count, inputSize, input, sizeof(output), output);
+        EXPECT_GT(outputSize, 0);
+
+        /* Every record must match the result of a single operation */
+        uint32_t in = 0;
+        uint32_t out = 0;
+        uint32_t clearSize = 0;
+        for (uint16_t i = 0; i < count; i++) {
+            uint32_t length = 0;
+            uint32_t resultLength = 0;
+            memcpy(&length, input + in + 16, sizeof(length));
+            memcpy(&resultLength, output + out, sizeof(resultLength));
+            EXPECT_EQ(cipher_encrypt(cipher, 16, input + in, length, input + in + 20, sizeof(record), record), resultLength);
+            EXPECT_EQ(memcmp(record, output + out + 4, resultLength), 0);
+
+            /* Build the decryption batch from the results */
+            memcpy(clear + clearSize, input + in, 16);
+            memcpy(clear + clearSize + 16, &resultLength, sizeof(resultLength));
+            memcpy(clear + clearSize + 20, output + out + 4, resultLength);
+            clearSize += (20 + resultLength);
+
+            in += (20 + length);
+            out += (4 + resultLength);
+        }
+        EXPECT_EQ(out, outputSize);
+
+        outputSize = cipher_batch(cipher, false, 16, count, clearSize, clear, sizeof(output), output);
+        EXPECT_GT(outputSize, 0);
+
+        in = 0;
+        out = 0;
+        for (uint16_t i = 0; i < count; i++) {
+            uint32_t length = 0;
+            uint32_t resultLength = 0;
+            memcpy(&length, input + in + 16, sizeof(length));
+            memcpy(&resultLength, output + out, sizeof(resultLength));
+            EXPECT_EQ(resultLength, length);
+            EXPECT_EQ(memcmp(output + out + 4, input + in + 20, length), 0);
+            in += (20 + length);
+            out += (4 + resultLength);
+        }
+
+        cipher_destroy(cipher);
+    }
+
+    EXPECT_NE(vault_delete(vault, key128Id), false);
+}
+
+static void TestEmptyBatchAES(const char* name, const aes_mode mode, const uint32_t key, const uint8_t ivLength)
+{
+    const uint16_t sizes[] = { 0, 5 };
+    const uint16_t count = sizeof(sizes) / sizeof(sizes[0]);
+
+    uint8_t input[128];
+    uint8_t output[128];
+    uint8_t sealed[128];
+    uint32_t inputSize = 0;
+
+    printf("> Testing %s batch with empty results\n", name);
+
+    for (uint16_t i = 0; i < count; i++) {
+        const uint32_t length = sizes[i];
+        memset(input + inputSize, static_cast<uint8_t>(i), ivLength);
+        inputSize += ivLength;
+        memcpy(input + inputSize, &length, sizeof(length));
+        inputSize += sizeof(length);
+        memset(input + inputSize, 0x5A, length);
+        inputSize += length;
+    }
+
+    struct CipherImplementation* cipher = cipher_create_aes(vault, mode, key);
+    EXPECT_NE(cipher, NULL);
+
+    if (cipher != NULL) {
+        int32_t outputSize = cipher_batch(cipher, true, ivLength, count, inputSize, input, sizeof(output), output);
+        EXPECT_GT(outputSize, 0);
+
+        /* Swap the plain data for the results: the empty record becomes a padding or tag only one */
+        uint32_t in = 0;
+        uint32_t out = 0;
+        uint32_t sealedSize = 0;
+        for (uint16_t i = 0; (i < count) && (outputSize > 0); i++) {
+            uint32_t resultLength = 0;
+            memcpy(&resultLength, output + out, sizeof(resultLength));
+            EXPECT_EQ(resultLength, (mode == AES_MODE_GCM ? (sizes[i] + 16) : 16));
+
+            memcpy(sealed + sealedSize, input + in, ivLength);
+            memcpy(sealed + sealedSize + ivLength, &resultLength, sizeof(resultLength));
+            memcpy(sealed + sealedSize + ivLength + 4, output + out + 4, resultLength);
+            sealedSize += (ivLength + 4 + resultLength);
+
+            in += (ivLength + 4 + sizes[i]);
+            out += (4 + resultLength);
+        }
+
+        /* Decrypting to nothing is a valid result, not a failure of the batch */
+        EXPECT_EQ(cipher_batch(cipher, false, ivLength, count, sealedSize, sealed, sizeof(output), output), (4 + 4 + sizes[1]));
+
+        uint32_t resultLength = 1;
+        memcpy(&resultLength, output, sizeof(resultLength));
+        EXPECT_EQ(resultLength, 0);
+        memcpy(&resultLength, output + 4, sizeof(resultLength));
+        EXPECT_EQ(resultLength, sizes[1]);
+        EXPECT_EQ(memcmp(output + 8, input + (2 * ivLength) + 8, sizes[1]), 0);
+
+        cipher_destroy(cipher);
+    }
+}
+
+TEST(Cipher, AES_BatchEmpty)
+{
+    const uint8_t key128[] = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff, 0x11 };
+
+    uint32_t key128Id = vault_import(vault, sizeof(key128), key128);
+    EXPECT_NE(key128Id, 0);
+    if (key128Id != 0) {
+        TestEmptyBatchAES("128-bit AES/CBC", AES_MODE_CBC, key128Id, 16);
+        TestEmptyBatchAES("128-bit AES/GCM", AES_MODE_GCM, key128Id, 12);
+        EXPECT_NE(vault_delete(vault, key128Id), false);
+    }
+}
+
+static void TestLargeAES(const char *name, const aes_mode mode, const uint32_t key, const uint32_t dataSize)
+{
+    const uint8_t iv[] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0xff, 0xff, 0xfe };
+    const uint32_t bufferSize = dataSize + 32;
+    const uint32_t chunkSize = 65536;
+
+    printf("> Testing %s on %i bytes\n", name, dataSize);
+    struct CipherImplementation* cipher = cipher_create_aes(vault, mode, key);
+    EXPECT_NE(cipher, NULL);
+
+    if (cipher != NULL) {
+        uint8_t* data = static_cast<uint8_t*>(malloc(dataSize));
+        uint8_t* expected = static_cast<uint8_t*>(malloc(bufferSize));
+        uint8_t* output = static_cast<uint8_t*>(malloc(bufferSize));
+
+        for (uint32_t i = 0; i < dataSize; i++) {
+            data[i] = static_cast<uint8_t>((i * 7) ^ (i >> 11));
+        }
+
+        /* Streaming is always serial, a one-shot operation on a large input may be split up */
+        int32_t expectedSize = 0;
+        EXPECT_EQ(cipher_stream_initialize(cipher, true, sizeof(iv), iv), 0);
+        for (uint32_t offset = 0; offset < dataSize; offset += chunkSize) {
+            const uint32_t length = MIN(chunkSize, (dataSize - offset));
+            int32_t len = cipher_stream_update(cipher, length, (data + offset), (bufferSize - expectedSize), (expected + expectedSize));
+            EXPECT_GE(len, 0);
+            expectedSize += len;
+        }
+        expectedSize += cipher_stream_finalize(cipher, (bufferSize - expectedSize), (expected + expectedSize));
+
+        int32_t outputSize = cipher_encrypt(cipher, sizeof(iv), iv, dataSize, data, bufferSize, output);
+        EXPECT_EQ(outputSize, expectedSize);
+        EXPECT_EQ(memcmp(output, expected, expectedSize), 0);
+
+        /* Decrypt in place */
+        EXPECT_EQ(cipher_decrypt(cipher, sizeof(iv), iv, outputSize, output, bufferSize, output), dataSize);
+        EXPECT_EQ(memcmp(output, data, dataSize), 0);
+
+        free(output);
+        free(expected);
+        free(data);
+
+        cipher_destroy(cipher);
+    }
+}
+
+TEST(Cipher, AES_Large)
+{
+    const uint8_t key256[] = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff, 0x11,
+                               0x12, 0x23, 0x34, 0x45, 0x56, 0x67, 0x78, 0x89, 0x9a, 0xab, 0xbc, 0xcd, 0xde, 0xef, 0xf1, 0x13 };
+
+    uint32_t key256Id = vault_import(vault, sizeof(key256), key256);
+    EXPECT_NE(key256Id, 0);
+    if (key256Id != 0) {
+        TestLargeAES("256-bit AES/CBC", AES_MODE_CBC, key256Id, (4 * 1024 * 1024) + 5);
+        TestLargeAES("256-bit AES/CBC", AES_MODE_CBC, key256Id, (3 * 1024 * 1024) - 16);
+        TestLargeAES("256-bit AES/CTR", AES_MODE_CTR, key256Id, (4 * 1024 * 1024) + 37);
+        TestLargeAES("256-bit AES/CTR", AES_MODE_CTR, key256Id, (1024 * 1024));
+        EXPECT_NE(vault_delete(vault, key256Id), false);
+    } else {
+        printf("  FATAL: Failed to store key to vault, large AES tests will be skipped\n");
+    }
+}
+
+TEST(Cipher, AES_GCM)
+{
+    /* NIST GCM test case 2 */
+    const uint8_t key128[16] = { 0 };
+    const uint8_t iv[12] = { 0 };
+    const uint8_t data[16] = { 0 };
+    const uint8_t expected[] = { 0x03, 0x88, 0xda, 0xce, 0x60, 0xb6, 0xa3, 0x92, 0xf3, 0x28, 0xc2, 0xb9, 0x71, 0xb2, 0xfe, 0x78,
+                                 0xab, 0x6e, 0x47, 0xd4, 0x2c, 0xec, 0x13, 0xbd, 0xf5, 0x3a, 0x67, 0xb2, 0x12, 0x57, 0xbd, 0xdf };
+
+    uint8_t output[64];
+    uint8_t clear[64];
+
+    uint32_t key128Id = vault_import(vault, sizeof(key128), key128);
+    EXPECT_NE(key128Id, 0);
+
+    struct CipherImplementation* cipher = cipher_create_aes(vault, AES_MODE_GCM, key128Id);
+    EXPECT_NE(cipher, NULL);
+
+    if (cipher != NULL) {
+        EXPECT_EQ(cipher_encrypt(cipher, sizeof(iv), iv, sizeof(data), data, sizeof(output), output), sizeof(expected));
+        EXPECT_EQ(memcmp(output, expected, sizeof(expected)), 0);
+
+        /* The tag needs room as well */
+        EXPECT_EQ(cipher_encrypt(cipher, sizeof(iv), iv, sizeof(data), data, sizeof(data), output) < 0, true);
+
+        EXPECT_EQ(cipher_decrypt(cipher, sizeof(iv), iv, sizeof(expected), expected, sizeof(clear), clear), sizeof(data));
+        EXPECT_EQ(memcmp(clear, data, sizeof(data)), 0);
+
+        /* Tampering with the ciphertext or the tag must be detected */
+        memcpy(output, expected, sizeof(expected));
+        output[3] ^= 0x01;
+        EXPECT_EQ(cipher_decrypt(cipher, sizeof(iv), iv, sizeof(expected), output, sizeof(clear), clear), 0);
+        memcpy(output, expected, sizeof(expected));
+        output[sizeof(expected) - 1] ^= 0x80;
+        EXPECT_EQ(cipher_decrypt(cipher, sizeof(iv), iv, sizeof(expected), output, sizeof(clear), clear), 0);
+
+        /* A 16 byte IV is not accepted */
+        EXPECT_EQ(cipher_encrypt(cipher, 16, output, sizeof(data), data, sizeof(output), output), 0);
+
+        cipher_destroy(cipher);
+    }
+
+    EXPECT_NE(vault_delete(vault, key128Id), false);
+}
+
+TEST(Cipher, AES_GCM_AAD)
+{
+    /* NIST GCM test case 4 */
+    const uint8_t key128[] = { 0xfe, 0xff, 0xe9, 0x92, 0x86, 0x65, 0x73, 0x1c, 0x6d, 0x6a, 0x8f, 0x94, 0x67, 0x30, 0x83, 0x08 };
+    const uint8_t iv[] = { 0xca, 0xfe, 0xba, 0xbe, 0xfa, 0xce, 0xdb, 0xad, 0xde, 0xca, 0xf8, 0x88 };
+    const uint8_t aad[] = { 0xfe, 0xed, 0xfa, 0xce, 0xde, 0xad, 0xbe, 0xef, 0xfe, 0xed, 0xfa, 0xce, 0xde, 0xad, 0xbe, 0xef,
+                           0xab, 0xad, 0xda, 0xd2 };
+    const uint8_t data[] = { 0xd9, 0x31, 0x32, 0x25, 0xf8, 0x84, 0x06, 0xe5, 0xa5, 0x59, 0x09, 0xc5, 0xaf, 0xf5, 0x26, 0x9a,
+                           0x86, 0xa7, 0xa9, 0x53, 0x15, 0x34, 0xf7, 0xda, 0x2e, 0x4c, 0x30, 0x3d, 0x8a, 0x31, 0x8a, 0x72,
+                           0x1c, 0x3c, 0x0c, 0x95, 0x95, 0x68, 0x09, 0x53, 0x2f, 0xcf, 0x0e, 0x24, 0x49, 0xa6, 0xb5, 0x25,
+                           0xb1, 0x6a, 0xed, 0xf5, 0xaa, 0x0d, 0xe6, 0x57, 0xba, 0x63, 0x7b, 0x39 };
+    const uint8_t expected[] = { 0x42, 0x83, 0x1e, 0xc2, 0x21, 0x77, 0x74, 0x24, 0x4b, 0x72, 0x21, 0xb7, 0x84, 0xd0, 0xd4, 0x9c,
+                           0xe3, 0xaa, 0x21, 0x2f, 0x2c, 0x02, 0xa4, 0xe0, 0x35, 0xc1, 0x7e, 0x23, 0x29, 0xac, 0xa1, 0x2e,
+                           0x21, 0xd5, 0x14, 0xb2, 0x54, 0x66, 0x93, 0x1c, 0x7d, 0x8f, 0x6a, 0x5a, 0xac, 0x84, 0xaa, 0x05,
+                           0x1b, 0xa3, 0x0b, 0x39, 0x6a, 0x0a, 0xac, 0x97, 0x3d, 0x58, 0xe0, 0x91, 0x5b, 0xc9, 0x4f, 0xbc,
+                           0x32, 0x21, 0xa5, 0xdb, 0x94, 0xfa, 0xe9, 0x5a, 0xe7, 0x12, 0x1a, 0x47 };
+
+    uint8_t output[128];
+    uint8_t clear[128];
+
+    uint32_t key128Id = vault_import(vault, sizeof(key128), key128);
+    EXPECT_NE(key128Id, 0);
+
+    struct CipherImplementation* cipher = cipher_create_aes(vault, AES_MODE_GCM, key128Id);
+    EXPECT_NE(cipher, NULL);
+
+    if (cipher != NULL) {
+        EXPECT_EQ(cipher_encrypt_authenticated(cipher, sizeof(iv), iv, sizeof(aad), aad, sizeof(data), data, sizeof(output), output), sizeof(expected));
+        EXPECT_EQ(memcmp(output, expected, sizeof(expected)), 0);
+
+        EXPECT_EQ(cipher_decrypt_authenticated(cipher, sizeof(iv), iv, sizeof(aad), aad, sizeof(expected), expected, sizeof(clear), clear), sizeof(data));
+        EXPECT_EQ(memcmp(clear, data, sizeof(data)), 0);
+
+        /* The additional data is covered by the tag, leaving it out or changing it must be detected */
+        EXPECT_EQ(cipher_decrypt(cipher, sizeof(iv), iv, sizeof(expected), expected, sizeof(clear), clear), 0);
+        memcpy(output, aad, sizeof(aad));
+        output[0] ^= 0x01;
+        EXPECT_EQ(cipher_decrypt_authenticated(cipher, sizeof(iv), iv, sizeof(aad), output, sizeof(expected), expected, sizeof(clear), clear), 0);
+
+        /* No additional data is the same as the plain call */
+        EXPECT_EQ(cipher_encrypt_authenticated(cipher, sizeof(iv), iv, 0, NULL, sizeof(data), data, sizeof(output), output), sizeof(expected));
+        EXPECT_EQ(cipher_encrypt(cipher, sizeof(iv), iv, sizeof(data), data, sizeof(clear), clear), sizeof(expected));
+        EXPECT_EQ(memcmp(output, clear, sizeof(expected)), 0);
+
+        cipher_destroy(cipher);
+    }
+
+    /* Only authenticated modes take additional data */
+    cipher = cipher_create_aes(vault, AES_MODE_CBC, key128Id);
+    EXPECT_NE(cipher, NULL);
+
+    if (cipher != NULL) {
+        EXPECT_EQ(cipher_encrypt_authenticated(cipher, 16, output, sizeof(aad), aad, sizeof(data), data, sizeof(output), output), 0);
+        cipher_destroy(cipher);
+    }
+
+    EXPECT_NE(vault_delete(vault, key128Id), false);
+}
+
+static void TestInPlace(const char* name, const aes_mode mode, const uint32_t keyId, const uint8_t ivLength, const uint32_t length, const uint32_t expectedSize)
+{
+    const uint8_t iv[] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+
+    printf("> Testing %s in place, %i bytes\n", name, length);
+
+    struct CipherImplementation* cipher = cipher_create_aes(vault, mode, keyId);
+    EXPECT_NE(cipher, NULL);
+
+    if (cipher != NULL) {
+        const uint32_t size = cipher_output_size(cipher, true, length);
+        EXPECT_EQ(size, expectedSize);
+        EXPECT_GE(cipher_output_size(cipher, false, size), length);
+
+        uint8_t* input = static_cast<uint8_t*>(malloc(length));
+        uint8_t* reference = static_cast<uint8_t*>(malloc(size));
+        uint8_t* data = static_cast<uint8_t*>(malloc(size));
+
+        for (uint32_t i = 0; i < length; i++) {
+            input[i] = static_cast<uint8_t>(i * 7);
+        }
+
+        EXPECT_EQ(cipher_encrypt(cipher, ivLength, iv, length, input, size, reference), static_cast<int32_t>(size));
+
+        /* Sized exactly, one byte less is reported */
+        memcpy(data, input, length);
+        EXPECT_EQ(cipher_encrypt_in_place(cipher, ivLength, iv, length, (size - 1), data), -static_cast<int32_t>(size));
+
+        EXPECT_EQ(cipher_encrypt_in_place(cipher, ivLength, iv, length, size, data), static_cast<int32_t>(size));
+        EXPECT_EQ(memcmp(data, reference, size), 0);
+
+        EXPECT_EQ(cipher_decrypt_in_place(cipher, ivLength, iv, size, size, data), static_cast<int32_t>(length));
+        EXPECT_EQ(memcmp(data, input, length), 0);
+
+        free(data);
+        free(reference);
+        free(input);
+
+        cipher_destroy(cipher);
+    }
+}
+
+TEST(Cipher, AES_InPlace)
+{
+    const uint8_t key128[] = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff, 0x11 };
+
+    uint32_t key128Id = vault_import(vault, sizeof(key128), key128);
+    EXPECT_NE(key128Id, 0);
+    if (key128Id != 0) {
+        /* Block aligned input gets a full block of padding */
+        TestInPlace("128-bit AES/CBC", AES_MODE_CBC, key128Id, 16, 64, 80);
+        TestInPlace("128-bit AES/CBC", AES_MODE_CBC, key128Id, 16, 100, 112);
+        TestInPlace("128-bit AES/ECB", AES_MODE_ECB, key128Id, 16, 33, 48);
+        TestInPlace("128-bit AES/CTR", AES_MODE_CTR, key128Id, 16, 100, 100);
+        TestInPlace("128-bit AES/GCM", AES_MODE_GCM, key128Id, 12, 100, 116);
+        /* Large enough to be processed in parallel chunks */
+        TestInPlace("128-bit AES/CBC", AES_MODE_CBC, key128Id, 16, (2 * 1024 * 1024), ((2 * 1024 * 1024) + 16));
+        TestInPlace("128-bit AES/CTR", AES_MODE_CTR, key128Id, 16, ((2 * 1024 * 1024) + 5), ((2 * 1024 * 1024) + 5));
+        EXPECT_NE(vault_delete(vault, key128Id), false);
+    } else {
+        printf("  FATAL: Failed to store key to vault, in place AES tests will be skipped\n");
+    }
+}
+
+static const struct cryptographystatistics* FindStatistics(const struct cryptographystatistics records[], const uint16_t count,
+                                                          const enum cryptographyoperation operation, const uint8_t algorithm, const uint8_t mode)
+{
+    const struct cryptographystatistics* result = NULL;
+
+    for (uint16_t i = 0; (i < count) && (result == NULL); i++) {
+        if ((records[i].operation == operation) && (records[i].algorithm == algorithm) && (records[i].mode == mode)) {
+            result = &records[i];
+        }
+    }
+
+    return (result);
+}
+
+TEST(Statistics, Counters)
+{
+    const uint8_t key128[] = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff, 0x11 };
+    const uint8_t iv[] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+
+    struct cryptographystatistics records[64];
+    const struct cryptographystatistics* record;
+    uint8_t data[100];
+    uint8_t output[128];
+    uint16_t count;
+
+    memset(data, 0x5A, sizeof(data));
+
+    statistics_enable(true);
+    statistics_reset();
+    EXPECT_EQ(statistics_enabled(), true);
+    EXPECT_EQ(statistics_query(64, records), 0);
+
+    struct HashImplementation* hash = hash_create(HASH_TYPE_SHA256);
+    EXPECT_NE(hash, NULL);
+    if (hash != NULL) {
+        EXPECT_EQ(hash_ingest(hash, sizeof(data), data), sizeof(data));
+        EXPECT_EQ(hash_ingest(hash, sizeof(data), data), sizeof(data));
+        EXPECT_EQ(hash_ingest(hash, sizeof(data), data), sizeof(data));
+        EXPECT_EQ(hash_calculate(hash, sizeof(output), output), HASH_TYPE_SHA256);
+    }
+
+    uint32_t keyId = vault_import(vault, sizeof(key128), key128);
+    EXPECT_NE(keyId, 0);
+
+    struct CipherImplementation* cipher = cipher_create_aes(vault, AES_MODE_CTR, keyId);
+    EXPECT_NE(cipher, NULL);
+    if (cipher != NULL) {
+        EXPECT_EQ(cipher_encrypt(cipher, sizeof(iv), iv, 64, data, sizeof(output), output), 64);
+        EXPECT_EQ(cipher_encrypt(cipher, sizeof(iv), iv, 64, data, sizeof(output), output), 64);
+        EXPECT_EQ(cipher_decrypt(cipher, sizeof(iv), iv, 32, output, sizeof(output), output), 32);
+        cipher_destroy(cipher);
+    }
+
+    const uint16_t derivedLength = 24;
+    uint32_t derivedId = 0;
+    EXPECT_EQ(hash_derive_keys(vault, HASH_TYPE_SHA384, keyId, 0, NULL, 0, NULL, 1, &derivedLength, &derivedId), 0);
+    EXPECT_NE(derivedId, 0);
+    EXPECT_NE(vault_delete(vault, derivedId), false);
+
+    EXPECT_NE(vault_delete(vault, keyId), false);
+
+    count = statistics_query(64, records);
+    EXPECT_GE(count, 6);
+
+    record = FindStatistics(records, count, CRYPTOGRAPHY_OPERATION_HASH, HASH_TYPE_SHA256, 0);
+    EXPECT_NE(record, NULL);
+    if (record != NULL) {
+        uint64_t total = 0;
+        for (uint8_t i = 0; i < CRYPTOGRAPHY_LATENCY_BUCKETS; i++) {
+            total += record->latency[i];
+        }
+
+        EXPECT_EQ(record->calls, 3);
+        EXPECT_EQ(record->bytes, (3 * sizeof(data)));
+        EXPECT_EQ(total, 3);
+    }
+
+    record = FindStatistics(records, count, CRYPTOGRAPHY_OPERATION_ENCRYPT, sizeof(key128), AES_MODE_CTR);
+    EXPECT_NE(record, NULL);
+    if (record != NULL) {
+        EXPECT_EQ(record->calls, 2);
+        EXPECT_EQ(record->bytes, 128);
+    }
+
+    record = FindStatistics(records, count, CRYPTOGRAPHY_OPERATION_DECRYPT, sizeof(key128), AES_MODE_CTR);
+    EXPECT_NE(record, NULL);
+    if (record != NULL) {
+        EXPECT_EQ(record->calls, 1);
+        EXPECT_EQ(record->bytes, 32);
+    }
+
+    /* Key derivation is recorded under the digest size */
+    record = FindStatistics(records, count, CRYPTOGRAPHY_OPERATION_KEY_DERIVE, 48, 0);
+    EXPECT_NE(record, NULL);
+    if (record != NULL) {
+        EXPECT_EQ(record->calls, 1);
+        EXPECT_EQ(record->bytes, 24);
+    }
+
+    record = FindStatistics(records, count, CRYPTOGRAPHY_OPERATION_VAULT_IMPORT, 0, 0);
+    EXPECT_NE(record, NULL);
+    if (record != NULL) {
+        EXPECT_EQ(record->calls, 1);
+        EXPECT_EQ(record->bytes, sizeof(key128));
+    }
+
+    record = FindStatistics(records, count, CRYPTOGRAPHY_OPERATION_VAULT_DELETE, 0, 0);
+    EXPECT_NE(record, NULL);
+
+    /* Nothing is recorded while switched off */
+    statistics_enable(false);
+
+    if (hash != NULL) {
+        EXPECT_EQ(hash_reset(hash), 0);
+        EXPECT_EQ(hash_ingest(hash, sizeof(data), data), sizeof(data));
+        hash_destroy(hash);
+    }
+
+    count = statistics_query(64, records);
+    record = FindStatistics(records, count, CRYPTOGRAPHY_OPERATION_HASH, HASH_TYPE_SHA256, 0);
+    EXPECT_NE(record, NULL);
+    if (record != NULL) {
+        EXPECT_EQ(record->calls, 3);
+    }
+
+    statistics_reset();
+    EXPECT_EQ(statistics_query(64, records), 0);
+}
+
 /*
   ===================================
 */
@@ -715,15 +1932,33 @@ int main(void)
         CALL(Vault, Common);
         CALL(Vault, ImportExport);
         CALL(Vault, SetGet); // Will not work on Sage
+        CALL(Vault, Handles);
+        CALL(Vault, Persistent);
 
         CALL(Signing, Hash);
         CALL(Signing, HMAC);
+        CALL(Signing, Batch);
+        CALL(Signing, Reset);
+        CALL(Signing, Derive);
+        CALL(Signing, Verify);
 
         CALL(DH, Generate);
         CALL(DH, DeriveStandard); // Will not work on Sage
+        CALL(DH, Repeated);
+        CALL(DH, EllipticCurve);
 
         CALL(Cipher, AES_Padded);
         CALL(Cipher, AES_Unpadded);
+        CALL(Cipher, AES_KeyLifetime);
+        CALL(Cipher, AES_Stream);
+        CALL(Cipher, AES_Batch);
+        CALL(Cipher, AES_BatchEmpty);
+        CALL(Cipher, AES_Large);
+        CALL(Cipher, AES_GCM);
+        CALL(Cipher, AES_GCM_AAD);
+        CALL(Cipher, AES_InPlace);
+
+        CALL(Statistics, Counters);
     }
 
     printf("TOTAL: %i tests; %i PASSED, %i FAILED\n", TotalTests, TotalTestsPassed, (TotalTests - TotalTestsPassed));
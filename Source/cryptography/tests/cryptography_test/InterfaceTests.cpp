@@ -159,6 +159,57 @@ TEST(Hash, Hash)
     }
 }
 
+TEST(Hash, Exchange)
+{
+    static const char regionName[] = "/tmp/cgfacetests.hash";
+    static const uint32_t regionSize = 8192;
+
+    WPEFramework::Core::DataElementFile region(regionName, (WPEFramework::Core::File::USER_READ | WPEFramework::Core::File::USER_WRITE
+                                                            | WPEFramework::Core::File::SHAREABLE | WPEFramework::Core::File::CREATE), regionSize);
+    EXPECT_EQ(region.IsValid(), true);
+
+    WPEFramework::Cryptography::IHash* hashImpl = cg->Hash(WPEFramework::Cryptography::hashtype::SHA256);
+    EXPECT_NE(hashImpl, nullptr);
+    if ((hashImpl != nullptr) && (region.IsValid() == true)) {
+        WPEFramework::Cryptography::IHashExchange* exchange = reinterpret_cast<WPEFramework::Cryptography::IHashExchange*>(hashImpl->QueryInterface(WPEFramework::Cryptography::IHashExchange::ID));
+        EXPECT_NE(exchange, nullptr);
+        if (exchange != nullptr) {
+            uint8_t expected[32];
+            uint8_t output[32];
+
+            for (uint32_t i = 0; i < regionSize; i++) {
+                region.Buffer()[i] = static_cast<uint8_t>(i * 7);
+            }
+
+            EXPECT_EQ(hashImpl->Ingest(regionSize, region.Buffer()), regionSize);
+            EXPECT_EQ(hashImpl->Calculate(sizeof(expected), expected), sizeof(expected));
+
+            /* Nothing attached yet */
+            EXPECT_EQ(exchange->Ingest(0, 16), 0);
+            EXPECT_EQ(exchange->Attach(regionName, regionSize), WPEFramework::Core::ERROR_NONE);
+            /* Outside of the region */
+            EXPECT_EQ(exchange->Ingest(1, regionSize), 0);
+
+            EXPECT_EQ(hashImpl->Reset(), WPEFramework::Core::ERROR_NONE);
+            EXPECT_EQ(exchange->Ingest(0, (regionSize / 2)), (regionSize / 2));
+            EXPECT_EQ(exchange->Ingest((regionSize / 2), (regionSize / 2)), (regionSize / 2));
+            EXPECT_EQ(hashImpl->Calculate(sizeof(output), output), sizeof(output));
+            EXPECT_EQ(::memcmp(output, expected, sizeof(expected)), 0);
+
+            EXPECT_EQ(exchange->Detach(), WPEFramework::Core::ERROR_NONE);
+            EXPECT_EQ(exchange->Ingest(0, 16), 0);
+
+            exchange->Release();
+        }
+    }
+
+    if (hashImpl != nullptr) {
+        hashImpl->Release();
+    }
+
+    WPEFramework::Core::File(string(regionName)).Destroy();
+}
+
 TEST(Hash, HMAC)
 {
     static const uint8_t data[] = "Etaoin Shrldu";
@@ -201,6 +252,94 @@ TEST(Hash, HMAC)
 }
 
 
+TEST(Hash, Verify)
+{
+    static const uint8_t data[] = "Etaoin Shrldu";
+    static const uint8_t password[] = "_Test_Password_";
+
+    static const uint8_t hash_sha256[] =  { 0x5A, 0xFF, 0xD7, 0xA7, 0x70, 0x1D, 0x73, 0x7B, 0xCC, 0x69, 0xBF, 0xDC,
+                                            0xC3, 0x42, 0xC9, 0xCE, 0x47, 0x2F, 0x07, 0xE8, 0xEA, 0x30, 0x21, 0x99,
+                                            0xB7, 0xAC, 0xC9, 0x4F, 0x7C, 0xDA, 0x15, 0x23 };
+    uint8_t tampered[sizeof(hash_sha256)];
+
+    uint32_t keyId = vault->Import(sizeof(password), password);
+    EXPECT_NE(keyId, 0);
+    if (keyId != 0) {
+        WPEFramework::Cryptography::IHash* hashImpl = vault->HMAC(WPEFramework::Cryptography::hashtype::SHA256, keyId);
+        EXPECT_NE(hashImpl, nullptr);
+        if (hashImpl != nullptr) {
+            EXPECT_EQ(hashImpl->Ingest(sizeof(data) - 1, data), sizeof(data) - 1);
+            EXPECT_EQ(hashImpl->Verify(sizeof(hash_sha256), hash_sha256), true);
+
+            ::memcpy(tampered, hash_sha256, sizeof(tampered));
+            tampered[0] ^= 0x80;
+
+            EXPECT_EQ(hashImpl->Reset(), WPEFramework::Core::ERROR_NONE);
+            EXPECT_EQ(hashImpl->Ingest(sizeof(data) - 1, data), sizeof(data) - 1);
+            EXPECT_EQ(hashImpl->Verify(sizeof(tampered), tampered), false);
+
+            hashImpl->Release();
+        }
+        EXPECT_NE(vault->Delete(keyId), false);
+    } else {
+        printf("FATAL: Failed to put key into vault, HMAC verification tests can't be performed\n");
+    }
+}
+
+TEST(Hash, Derive)
+{
+    // RFC 5869, test case 1
+    static const uint8_t ikm[] = { 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b,
+                                   0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b };
+    static const uint8_t salt[] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c };
+    static const uint8_t info[] = { 0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9 };
+    static const uint8_t okm[] = { 0x3c, 0xb2, 0x5f, 0x25, 0xfa, 0xac, 0xd5, 0x7a, 0x90, 0x43, 0x4f, 0x64, 0xd0, 0x36, 0x2f, 0x2a,
+                                   0x2d, 0x2d, 0x0a, 0x90, 0xcf, 0x1a, 0x5a, 0x4c, 0x5d, 0xb0, 0x2d, 0x56, 0xec, 0xc4, 0xc5, 0xbf,
+                                   0x34, 0x00, 0x72, 0x08, 0xd5, 0xb8, 0x87, 0x18, 0x58, 0x65 };
+    static const uint8_t data[] = "Etaoin Shrldu";
+
+    uint32_t secretId = vault->Import(sizeof(ikm), ikm);
+    EXPECT_NE(secretId, 0);
+    if (secretId != 0) {
+        const uint16_t keyLength = sizeof(okm);
+        uint32_t keyId = 0;
+        EXPECT_EQ(vault->Derive(WPEFramework::Cryptography::hashtype::SHA256, secretId, sizeof(salt), salt, sizeof(info), info, 1, &keyLength, &keyId), WPEFramework::Core::ERROR_NONE);
+        EXPECT_NE(keyId, 0);
+        EXPECT_EQ(vault->Size(keyId), USHRT_MAX);
+
+        uint32_t knownId = vault->Import(sizeof(okm), okm);
+        EXPECT_NE(knownId, 0);
+
+        // The derived key is sealed, so compare HMACs calculated with either key
+        WPEFramework::Cryptography::IHash* derived = vault->HMAC(WPEFramework::Cryptography::hashtype::SHA256, keyId);
+        WPEFramework::Cryptography::IHash* known = vault->HMAC(WPEFramework::Cryptography::hashtype::SHA256, knownId);
+        EXPECT_NE(derived, nullptr);
+        EXPECT_NE(known, nullptr);
+        if ((derived != nullptr) && (known != nullptr)) {
+            uint8_t output[32];
+            uint8_t reference[32];
+
+            EXPECT_EQ(derived->Ingest(sizeof(data) - 1, data), sizeof(data) - 1);
+            EXPECT_EQ(derived->Calculate(sizeof(output), output), sizeof(output));
+            EXPECT_EQ(known->Ingest(sizeof(data) - 1, data), sizeof(data) - 1);
+            EXPECT_EQ(known->Calculate(sizeof(reference), reference), sizeof(reference));
+            EXPECT_EQ(::memcmp(output, reference, sizeof(output)), 0);
+        }
+
+        if (derived != nullptr) {
+            derived->Release();
+        }
+        if (known != nullptr) {
+            known->Release();
+        }
+
+        EXPECT_NE(vault->Delete(keyId), false);
+        EXPECT_NE(vault->Delete(knownId), false);
+        EXPECT_NE(vault->Delete(secretId), false);
+    }
+}
+
+
 TEST(Cipher, AES)
 {
     const uint8_t data[] = "Look behind you, a Three-Headed Monkey!";
@@ -257,6 +396,119 @@ TEST(Cipher, AES)
     }
 }
 
+TEST(Cipher, InPlace)
+{
+    const uint8_t data[] = "Look behind you, a Three-Headed Monkey!";
+    const uint16_t dataSize = sizeof(data) - 1;
+    const uint16_t expectedSize = dataSize + (16 - (dataSize % 16));
+
+    const uint8_t iv[] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+
+    const uint8_t key128[] = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff, 0x11 };
+
+    const uint8_t expected_AES_CBC_128[expectedSize] = {
+	    0xB0, 0xF2, 0x9F, 0xB5, 0x55, 0xB2, 0x48, 0x08, 0x3A, 0x0D, 0xD9, 0xDB,
+	    0x6E, 0xD3, 0x37, 0x13, 0x5F, 0x91, 0x92, 0xBB, 0x33, 0xCE, 0x22, 0x21,
+	    0xDB, 0xEC, 0x8C, 0x55, 0xD7, 0xB9, 0xD9, 0x96, 0xEA, 0x5E, 0xE0, 0x84,
+	    0x9F, 0xBA, 0x44, 0x13, 0xCE, 0x2C, 0x63, 0x8A, 0x0A, 0x1D, 0x60, 0xBC
+    };
+
+    uint32_t key128Id = vault->Import(sizeof(key128), key128);
+    EXPECT_NE(key128Id, 0);
+    if (key128Id != 0) {
+        WPEFramework::Cryptography::ICipher* aes = vault->AES(WPEFramework::Cryptography::aesmode::CBC, key128Id);
+        EXPECT_NE(aes, nullptr);
+        if (aes != nullptr) {
+            EXPECT_EQ(aes->OutputSize(true, dataSize), expectedSize);
+
+            uint8_t* buffer = new uint8_t[expectedSize];
+            ::memcpy(buffer, data, dataSize);
+
+            EXPECT_EQ(aes->EncryptInPlace(sizeof(iv), iv, dataSize, expectedSize, buffer), expectedSize);
+            EXPECT_EQ(::memcmp(buffer, expected_AES_CBC_128, expectedSize), 0);
+
+            EXPECT_EQ(aes->DecryptInPlace(sizeof(iv), iv, expectedSize, expectedSize, buffer), dataSize);
+            EXPECT_EQ(::memcmp(buffer, data, dataSize), 0);
+
+            delete[] buffer;
+
+            aes->Release();
+        }
+
+        EXPECT_NE(vault->Delete(key128Id), false);
+    } else {
+        printf("FATAL: Failed to put key into vault, in place AES tests can't be performed\n");
+    }
+}
+
+
+TEST(Cipher, AES_Exchange)
+{
+    static const char regionName[] = "/tmp/cgfacetests.cipher";
+    static const uint32_t regionSize = 8192;
+    static const uint32_t dataSize = 4000;
+    static const uint32_t expectedSize = 4016;
+
+    const uint8_t iv[] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+    const uint8_t key128[] = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff, 0x11 };
+
+    WPEFramework::Core::DataElementFile region(regionName, (WPEFramework::Core::File::USER_READ | WPEFramework::Core::File::USER_WRITE
+                                                            | WPEFramework::Core::File::SHAREABLE | WPEFramework::Core::File::CREATE), regionSize);
+    EXPECT_EQ(region.IsValid(), true);
+
+    uint32_t key128Id = vault->Import(sizeof(key128), key128);
+    EXPECT_NE(key128Id, 0);
+    if ((key128Id != 0) && (region.IsValid() == true)) {
+        WPEFramework::Cryptography::ICipher* aes = vault->AES(WPEFramework::Cryptography::aesmode::CBC, key128Id);
+        EXPECT_NE(aes, nullptr);
+        if (aes != nullptr) {
+            WPEFramework::Cryptography::ICipherExchange* exchange = reinterpret_cast<WPEFramework::Cryptography::ICipherExchange*>(aes->QueryInterface(WPEFramework::Cryptography::ICipherExchange::ID));
+            EXPECT_NE(exchange, nullptr);
+            if (exchange != nullptr) {
+                uint8_t* data = region.Buffer();
+                uint8_t* expected = new uint8_t[expectedSize];
+
+                for (uint32_t i = 0; i < dataSize; i++) {
+                    data[i] = static_cast<uint8_t>(i * 13);
+                }
+
+                EXPECT_EQ(aes->Encrypt(sizeof(iv), iv, dataSize, data, expectedSize, expected), expectedSize);
+
+                /* Nothing attached yet */
+                EXPECT_EQ(exchange->Encrypt(sizeof(iv), iv, 0, dataSize, 4096, 4096), 0);
+                EXPECT_EQ(exchange->Attach(regionName, regionSize), WPEFramework::Core::ERROR_NONE);
+                /* Output outside of the region */
+                EXPECT_EQ(exchange->Encrypt(sizeof(iv), iv, 0, dataSize, 4097, 4096), 0);
+                /* Output overlapping the input */
+                EXPECT_EQ(exchange->Encrypt(sizeof(iv), iv, 0, dataSize, 16, 4096), 0);
+
+                EXPECT_EQ(exchange->Encrypt(sizeof(iv), iv, 0, dataSize, 4096, 4096), expectedSize);
+                EXPECT_EQ(::memcmp(data + 4096, expected, expectedSize), 0);
+
+                ::memset(data, 0, dataSize);
+                EXPECT_EQ(exchange->Decrypt(sizeof(iv), iv, 4096, expectedSize, 0, 4096), dataSize);
+                for (uint32_t i = 0; i < dataSize; i++) {
+                    if (data[i] != static_cast<uint8_t>(i * 13)) {
+                        EXPECT_EQ(data[i], static_cast<uint8_t>(i * 13));
+                        break;
+                    }
+                }
+
+                EXPECT_EQ(exchange->Detach(), WPEFramework::Core::ERROR_NONE);
+                EXPECT_EQ(exchange->Encrypt(sizeof(iv), iv, 0, dataSize, 4096, 4096), 0);
+
+                exchange->Release();
+                delete[] expected;
+            }
+
+            aes->Release();
+        }
+
+        EXPECT_NE(vault->Delete(key128Id), false);
+    }
+
+    WPEFramework::Core::File(string(regionName)).Destroy();
+}
 
 static bool GenerateDHKeyPair(const uint32_t generator, const uint8_t modulus[], const uint16_t modulusSize, uint32_t *privKey, uint32_t *pubKey)
 {
@@ -326,6 +578,164 @@ TEST(DH, Generate)
 
 }
 
+TEST(DH, EllipticCurve)
+{
+    WPEFramework::Cryptography::IDiffieHellman* dh = vault->DiffieHellman();
+    EXPECT_NE(dh, nullptr);
+
+    if (dh != nullptr) {
+        uint32_t privateKeyId = 0;
+        uint32_t publicKeyId = 0;
+        uint32_t peerPrivateKeyId = 0;
+        uint32_t peerPublicKeyId = 0;
+        uint32_t secretId = 0;
+        uint32_t peerSecretId = 0;
+
+        EXPECT_EQ(dh->GenerateEC(WPEFramework::Cryptography::X25519, privateKeyId, publicKeyId), 0);
+        EXPECT_EQ(dh->GenerateEC(WPEFramework::Cryptography::X25519, peerPrivateKeyId, peerPublicKeyId), 0);
+        EXPECT_EQ(vault->Size(privateKeyId), USHRT_MAX);
+        EXPECT_EQ(vault->Size(publicKeyId), 32);
+
+        EXPECT_EQ(dh->Derive(privateKeyId, peerPublicKeyId, secretId), 0);
+        EXPECT_EQ(dh->Derive(peerPrivateKeyId, publicKeyId, peerSecretId), 0);
+        EXPECT_EQ(vault->Size(secretId), USHRT_MAX);
+
+        EXPECT_NE(vault->Delete(secretId), false);
+        EXPECT_NE(vault->Delete(peerSecretId), false);
+        EXPECT_NE(vault->Delete(privateKeyId), false);
+        EXPECT_NE(vault->Delete(publicKeyId), false);
+        EXPECT_NE(vault->Delete(peerPrivateKeyId), false);
+        EXPECT_NE(vault->Delete(peerPublicKeyId), false);
+
+        dh->Release();
+    }
+}
+
+TEST(Cryptography, Statistics)
+{
+    const uint8_t data[] = "Etaoin Shrldu";
+
+    EXPECT_EQ(cg->EnableStatistics(true), WPEFramework::Core::ERROR_NONE);
+
+    /* Start off clean */
+    uint8_t* buffer = new uint8_t[64 * sizeof(cryptographystatistics)];
+    cg->Statistics(true, (64 * sizeof(cryptographystatistics)), buffer);
+
+    WPEFramework::Cryptography::IHash* hashImpl = cg->Hash(WPEFramework::Cryptography::hashtype::SHA256);
+    EXPECT_NE(hashImpl, nullptr);
+    if (hashImpl != nullptr) {
+        uint8_t output[32];
+        EXPECT_EQ(hashImpl->Ingest(sizeof(data) - 1, data), sizeof(data) - 1);
+        EXPECT_EQ(hashImpl->Ingest(sizeof(data) - 1, data), sizeof(data) - 1);
+        EXPECT_EQ(hashImpl->Calculate(sizeof(output), output), sizeof(output));
+        hashImpl->Release();
+    }
+
+    const uint16_t count = cg->Statistics(true, (64 * sizeof(cryptographystatistics)), buffer);
+    EXPECT_GE(count, 1);
+
+    bool found = false;
+    for (uint16_t i = 0; i < count; i++) {
+        cryptographystatistics record;
+        ::memcpy(&record, (buffer + (i * sizeof(record))), sizeof(record));
+
+        if ((record.operation == CRYPTOGRAPHY_OPERATION_HASH) && (record.algorithm == WPEFramework::Cryptography::hashtype::SHA256)) {
+            EXPECT_EQ(record.calls, 2);
+            EXPECT_EQ(record.bytes, (2 * (sizeof(data) - 1)));
+            found = true;
+        }
+    }
+    EXPECT_EQ(found, true);
+
+    /* Cleared by the query before */
+    EXPECT_EQ(cg->Statistics(false, (64 * sizeof(cryptographystatistics)), buffer), 0);
+
+    EXPECT_EQ(cg->EnableStatistics(false), WPEFramework::Core::ERROR_NONE);
+
+    delete[] buffer;
+}
+
+TEST(JobQueue, Operations)
+{
+    using JobQueue = WPEFramework::Cryptography::JobQueue;
+
+    const uint8_t data[] = "Etaoin Shrldu";
+
+    static const uint8_t hash_sha256[] =  { 0x80, 0x72, 0xA8, 0x3C, 0x2C, 0xFB, 0xF3, 0x67, 0xA1, 0x64, 0x1C, 0x22,
+                                            0x03, 0xCD, 0x78, 0x1D, 0x2E, 0x85, 0x13, 0x11, 0x72, 0x7D, 0xCE, 0x8E,
+                                            0xD7, 0x25, 0x51, 0x0F, 0xE1, 0x3B, 0x78, 0x35 };
+
+    const uint8_t iv[] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+    const uint8_t key128[] = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff, 0x11 };
+
+    JobQueue queue(2, 4);
+
+    WPEFramework::Cryptography::IHash* hashImpl = cg->Hash(WPEFramework::Cryptography::hashtype::SHA256);
+    EXPECT_NE(hashImpl, nullptr);
+    if (hashImpl != nullptr) {
+        uint8_t digest[sizeof(hash_sha256)];
+        std::promise<uint8_t> done;
+
+        EXPECT_EQ(queue.Calculate(JobQueue::HIGH, hashImpl, (sizeof(data) - 1), data, sizeof(digest), digest,
+                      [&done](const uint8_t length) { done.set_value(length); }), WPEFramework::Core::ERROR_NONE);
+
+        // The queue holds on to the calculator until the job completed
+        hashImpl->Release();
+
+        EXPECT_EQ(done.get_future().get(), sizeof(hash_sha256));
+        EXPECT_EQ(::memcmp(digest, hash_sha256, sizeof(hash_sha256)), 0);
+    }
+
+    uint32_t key128Id = vault->Import(sizeof(key128), key128);
+    EXPECT_NE(key128Id, 0);
+    if (key128Id != 0) {
+        WPEFramework::Cryptography::ICipher* aes = vault->AES(WPEFramework::Cryptography::aesmode::CBC, key128Id);
+        EXPECT_NE(aes, nullptr);
+        if (aes != nullptr) {
+            uint8_t encrypted[64];
+            uint8_t decrypted[64];
+            std::promise<int32_t> encryptDone;
+            std::promise<int32_t> decryptDone;
+
+            EXPECT_EQ(queue.Encrypt(JobQueue::BULK, aes, sizeof(iv), iv, (sizeof(data) - 1), data, sizeof(encrypted), encrypted,
+                          [&encryptDone](const int32_t length) { encryptDone.set_value(length); }), WPEFramework::Core::ERROR_NONE);
+
+            const int32_t encryptedSize = encryptDone.get_future().get();
+            EXPECT_EQ(encryptedSize, 16);
+
+            EXPECT_EQ(queue.Decrypt(JobQueue::NORMAL, aes, sizeof(iv), iv, encryptedSize, encrypted, sizeof(decrypted), decrypted,
+                          [&decryptDone](const int32_t length) { decryptDone.set_value(length); }), WPEFramework::Core::ERROR_NONE);
+
+            EXPECT_EQ(decryptDone.get_future().get(), (sizeof(data) - 1));
+            EXPECT_EQ(::memcmp(decrypted, data, (sizeof(data) - 1)), 0);
+
+            aes->Release();
+        }
+
+        EXPECT_NE(vault->Delete(key128Id), false);
+    }
+
+    std::future<uint32_t> answer = queue.Submit<uint32_t>(JobQueue::NORMAL, std::function<uint32_t()>([]() { return (42); }));
+    EXPECT_EQ(answer.valid(), true);
+    EXPECT_EQ(answer.get(), 42);
+
+    /* Bounded: with the only worker busy a queue of depth 1 takes one job only */
+    JobQueue small(1, 1);
+    std::promise<void> release;
+    std::shared_future<void> released(release.get_future().share());
+    std::promise<void> started;
+
+    EXPECT_EQ(small.Submit(JobQueue::BULK, [&started, released]() { started.set_value(); released.wait(); }), WPEFramework::Core::ERROR_NONE);
+    started.get_future().wait();
+
+    EXPECT_EQ(small.Submit(JobQueue::HIGH, []() {}), WPEFramework::Core::ERROR_NONE);
+    EXPECT_EQ(small.Submit(JobQueue::HIGH, []() {}), WPEFramework::Core::ERROR_UNAVAILABLE);
+    EXPECT_EQ(small.Submit<uint32_t>(JobQueue::HIGH, std::function<uint32_t()>([]() { return (0); })).valid(), false);
+    EXPECT_EQ(small.Submit(JobQueue::NORMAL, []() {}), WPEFramework::Core::ERROR_NONE);
+
+    release.set_value();
+}
+
 int main(int argc, char **argv)
 {
     cg = WPEFramework::Cryptography::ICryptography::Instance("");
@@ -374,10 +784,22 @@ int main(int argc, char **argv)
 
             CALL(Hash, Hash);
             CALL(Hash, HMAC);
+            CALL(Hash, Verify);
+            CALL(Hash, Exchange);
+#ifdef OpenSSL
+            CALL(Hash, Derive); // Not supported by SecApi
+#endif
 
             CALL(Cipher, AES);
+            CALL(Cipher, InPlace);
+            CALL(Cipher, AES_Exchange);
 
             CALL(DH, Generate);
+            CALL(DH, EllipticCurve);
+
+            CALL(JobQueue, Operations);
+
+            CALL(Cryptography, Statistics);
         } else {
             printf("FATAL: Failed to acquire IVault, Vault tests can't be performed\n");
         }
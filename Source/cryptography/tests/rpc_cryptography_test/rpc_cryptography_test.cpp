@@ -25,6 +25,11 @@
 
 #include <cryptography.h>
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
 namespace Thunder = WPEFramework;
 
 static constexpr uint32_t TimeOut = 1000; //Thunder::Core::infinite;
@@ -434,6 +439,69 @@ TEST_F(BasicTest, VaultHMACIngest65K)
     }
 }
 
+TEST_F(BasicTest, VaultHMACInterleaved)
+{
+    uint8_t firstBuffer[20];
+    uint8_t secondBuffer[20];
+    memset(firstBuffer, 0, sizeof(firstBuffer));
+    memset(secondBuffer, 0, sizeof(secondBuffer));
+
+    uint8_t hashExpected[] = {
+        130, 119, 142, 1, 91,
+        110, 173, 90, 240, 86,
+        248, 76, 153, 38, 170,
+        216, 150, 153, 123, 119
+    };
+
+    ASSERT_EQ(controller.ActivatePlugin(TestData::plugin), Thunder::Core::ERROR_NONE);
+    ASSERT_TRUE(controller.IsPluginActive(TestData::plugin));
+    ASSERT_NE(nullptr, cryptography);
+
+    Thunder::Cryptography::IVault* vault = cryptography->Vault(CRYPTOGRAPHY_VAULT_PLATFORM);
+
+    ASSERT_NE(nullptr, vault);
+
+    uint32_t keyId = vault->Import(sizeof(TestData::cipherkey), TestData::cipherkey);
+
+    // Two calculations on the same key in flight at the same time must not see each other's data
+    Thunder::Cryptography::IHash* first = vault->HMAC(Thunder::Cryptography::SHA1, keyId);
+    ASSERT_NE(nullptr, first);
+
+    EXPECT_EQ(first->Ingest(sizeof(TestData::data), reinterpret_cast<const uint8_t*>(TestData::data)), sizeof(TestData::data));
+
+    Thunder::Cryptography::IHash* second = vault->HMAC(Thunder::Cryptography::SHA1, keyId);
+    ASSERT_NE(nullptr, second);
+
+    EXPECT_EQ(second->Ingest(sizeof(TestData::data), reinterpret_cast<const uint8_t*>(TestData::data)), sizeof(TestData::data));
+
+    EXPECT_EQ(first->Calculate(sizeof(firstBuffer), firstBuffer), Thunder::Cryptography::SHA1);
+    EXPECT_EQ(second->Calculate(sizeof(secondBuffer), secondBuffer), Thunder::Cryptography::SHA1);
+
+    EXPECT_TRUE(ArraysMatch(firstBuffer, hashExpected));
+    EXPECT_TRUE(ArraysMatch(secondBuffer, hashExpected));
+
+    first->Release();
+
+    // A calculator handed out again starts from a clean state
+    Thunder::Cryptography::IHash* third = vault->HMAC(Thunder::Cryptography::SHA1, keyId);
+    ASSERT_NE(nullptr, third);
+
+    memset(firstBuffer, 0, sizeof(firstBuffer));
+
+    EXPECT_EQ(third->Ingest(sizeof(TestData::data), reinterpret_cast<const uint8_t*>(TestData::data)), sizeof(TestData::data));
+    EXPECT_EQ(third->Calculate(sizeof(firstBuffer), firstBuffer), Thunder::Cryptography::SHA1);
+
+    EXPECT_TRUE(ArraysMatch(firstBuffer, hashExpected));
+
+    third->Release();
+    second->Release();
+
+    if (vault != nullptr) {
+        vault->Release();
+        vault = nullptr;
+    }
+}
+
 TEST_F(BasicTest, VaultAES)
 {
     ASSERT_EQ(controller.ActivatePlugin(TestData::plugin), Thunder::Core::ERROR_NONE);
@@ -512,6 +580,78 @@ TEST_F(BasicTest, VaultAESEncryptDecrypt)
     }
 }
 
+TEST_F(BasicTest, VaultAESEncryptDecryptConcurrent)
+{
+    static constexpr uint8_t Threads = 4;
+    static constexpr uint32_t Iterations = 500;
+
+    ASSERT_EQ(controller.ActivatePlugin(TestData::plugin), Thunder::Core::ERROR_NONE);
+    ASSERT_TRUE(controller.IsPluginActive(TestData::plugin));
+    ASSERT_NE(nullptr, cryptography);
+
+    Thunder::Cryptography::IVault* vault = cryptography->Vault(CRYPTOGRAPHY_VAULT_PLATFORM);
+
+    ASSERT_NE(nullptr, vault);
+
+    uint32_t keyId = vault->Import(sizeof(TestData::cipherkey), TestData::cipherkey);
+
+    // One cipher proxy, shared by all threads
+    Thunder::Cryptography::ICipher* iface = vault->AES(Thunder::Cryptography::CBC, keyId);
+
+    ASSERT_NE(nullptr, iface);
+
+    std::atomic<uint32_t> failures(0);
+    std::vector<std::thread> workers;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for (uint8_t i = 0; i < Threads; i++) {
+        workers.emplace_back([&iface, &failures]() {
+            uint8_t encryptBuffer[128];
+            uint8_t clearBuffer[128];
+
+            for (uint32_t j = 0; j < Iterations; j++) {
+                int32_t encryptedSize = iface->Encrypt(
+                    sizeof(TestData::cipherkey), TestData::cipherkey,
+                    sizeof(TestData::data), reinterpret_cast<const uint8_t*>(TestData::data),
+                    sizeof(encryptBuffer), encryptBuffer);
+
+                int32_t clearSize = (encryptedSize <= 0 ? 0 : iface->Decrypt(
+                    sizeof(TestData::cipherkey), TestData::cipherkey,
+                    encryptedSize, encryptBuffer,
+                    sizeof(clearBuffer), clearBuffer));
+
+                if ((clearSize != sizeof(TestData::data)) || (memcmp(clearBuffer, TestData::data, sizeof(TestData::data)) != 0)) {
+                    failures++;
+                }
+            }
+        });
+    }
+
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+    EXPECT_EQ(failures.load(), 0u);
+
+    if (elapsed > 0) {
+        RecordProperty("RoundTripsPerSecond", static_cast<int>((static_cast<uint64_t>(Threads) * Iterations * 1000000) / elapsed));
+    }
+
+    if (iface != nullptr) {
+        iface->Release();
+        iface = nullptr;
+    }
+
+    if (vault != nullptr) {
+        EXPECT_TRUE(vault->Delete(keyId));
+        vault->Release();
+        vault = nullptr;
+    }
+}
+
 TEST_F(BasicTest, VaultAESEncryptDecryptDisablePlugin)
 {
     uint8_t encryptBuffer[128];